@@ -0,0 +1,515 @@
+/**
+ * @file: bench_main.cpp
+ * @description: Прогон сценариев движения на ПК и замеры движка шагов и планировщика
+ * @dependencies: sim.h, step_engine.h, motion_jobs.h, endstop_latch.h, stepper_control.h
+ * @created: 2026-10-14
+ *
+ * Собирается окружением native_bench (platformio.ini) вместе с настоящими
+ * step_engine/stepper_control/motion_jobs. Фронты STEP записываются обработчиком
+ * пинов симуляции, по ним считаются достигнутая частота шагов и отклонение от
+ * идеального профиля с maxSpeed/acceleration/jerk оси из config.h (трапеция или S-кривая).
+ *
+ * Сценарий - текстовый файл, по команде на строке (# - комментарий):
+ *   loop_us <мкс>              длительность прохода основного цикла между serviceMotionJobs()
+ *   isr_ticks <тиков>          стоимость одного обработчика прерывания на кристалле (2 тика = 1 мкс)
+ *   move <ось> <поз> [...]     одновременный запуск осей (multi, multizone, rright, e0, e1) и ожидание
+ *   events <ось> <поз> <пин>@<шаг>=<0|1> [...]
+ *                              движение с событиями выходов: на каком шаге переключился каждый пин
+ *   clamp <поз>                связанное движение E0/E1
+ *   planner <n>                время хоста на checkBuffer()/addTarget() планировщика пары E0/E1
+ *   echo <0|1>                 вывод Serial прошивки в stdout
+ *
+ * Результат - строки key=value; код возврата 1, если шагов выдано не столько, сколько нужно,
+ * или время профиля ушло от идеального больше чем на BENCH_TIME_ERR_PCT (строка с FAIL).
+ */
+
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+#include <vector>
+#include "sim.h"
+#include "stepper_control.h"
+#include "step_engine.h"
+#include "motion_jobs.h"
+#include "endstop_latch.h"
+#include "log.h"
+#include "accel_profile.h"
+
+// Предел ожидания одного задания в виртуальном времени
+#define BENCH_JOB_TIMEOUT_MS 600000UL
+// Допуск времени профиля относительно идеального, %
+#define BENCH_TIME_ERR_PCT 10.0
+
+typedef struct {
+  uint8_t stepPin;
+  std::vector<uint64_t> edges;    // тики переднего фронта STEP
+} AxisTrace;
+
+// Переключение выхода события
+typedef struct {
+  uint8_t pin;
+  bool level;
+  uint64_t ticks;
+} OutputEdge;
+
+static AxisTrace traces[STEPPER_AXIS_COUNT];
+static std::vector<OutputEdge> outputEdges;
+static uint8_t outputPins[STEP_ENGINE_MAX_EVENTS];
+static uint8_t outputPinCount = 0;
+static bool failed = false;
+
+static void onPinChange(uint8_t pin, bool level, uint64_t ticks) {
+  for (uint8_t i = 0; i < outputPinCount; i++) {
+    if (outputPins[i] == pin) outputEdges.push_back({pin, level, ticks});
+  }
+  if (!level) return;
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    if (traces[i].stepPin == pin) traces[i].edges.push_back(ticks);
+  }
+}
+
+static bool parseAxis(const char* name, StepperType& type) {
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    if (!strcmp(name, reinterpret_cast<const char*>(getAxisEventName((StepperType)i)))) {
+      type = (StepperType)i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// ============== ИДЕАЛЬНЫЙ ПРОФИЛЬ ==============
+// Ускорение, рывок и верхняя скорость таблиц осей (как в axisProfiles step_engine.cpp)
+static const uint32_t axisAccel[STEPPER_AXIS_COUNT] = {
+  MULTI_ACCELERATION, MULTIZONE_ACCELERATION, RRIGHT_ACCELERATION, E0_ACCELERATION, E1_ACCELERATION,
+};
+static const uint32_t axisJerk[STEPPER_AXIS_COUNT] = {MULTI_JERK, MULTIZONE_JERK, RRIGHT_JERK, E0_JERK, E1_JERK};
+static const uint32_t axisTopSpeed[STEPPER_AXIS_COUNT] = {
+  ACCEL_PROFILE_SPEED(MULTI), ACCEL_PROFILE_SPEED(MULTIZONE), ACCEL_PROFILE_SPEED(RRIGHT),
+  ACCEL_PROFILE_SPEED(E0), ACCEL_PROFILE_SPEED(E1),
+};
+
+// Разгон от нуля по кривой accel_profile.h: трапеция при jerk 0, иначе S-кривая до topSpeed.
+// timeScale - растяжение времени таблицы движком при ускорении не из config.h
+typedef struct {
+  double accel;
+  uint32_t jerk;
+  uint32_t topSpeed;
+  double timeScale;
+} IdealRamp;
+
+// Ускорение трапеции пары E0/E1 дробное - в accelProfilePeakAccel() оно не передаётся
+static double rampPeak(const IdealRamp& ramp) {
+  return ramp.jerk ? accelProfilePeakAccel(ramp.accel, ramp.topSpeed, ramp.jerk) : ramp.accel;
+}
+
+static double rampTime(const IdealRamp& ramp, double s) {
+  return ramp.timeScale * accelProfileTimeAt(s, ramp.topSpeed, ramp.jerk, rampPeak(ramp));
+}
+
+static double rampDistance(const IdealRamp& ramp, double speed) {
+  return accelProfileDistanceAt(speed * ramp.timeScale, ramp.topSpeed, ramp.jerk, rampPeak(ramp));
+}
+
+// Момент достижения позиции s (шагов) на пути total: разгон, участок скорости speed и
+// торможение зеркальным разгоном, мкс от старта
+static double idealTimeUs(double s, double total, double speed, const IdealRamp& ramp) {
+  double accelDistance = rampDistance(ramp, speed);
+  // Треугольник: до середины разгон, дальше торможение
+  if (2 * accelDistance > total) accelDistance = total / 2;
+  double accelTime = rampTime(ramp, accelDistance);
+  double cruise = total - 2 * accelDistance;
+  double totalTime = 2 * accelTime + (cruise > 0 ? cruise / speed : 0);
+  double t;
+  if (s <= accelDistance) t = rampTime(ramp, s);
+  else if (s <= total - accelDistance) t = accelTime + (s - accelDistance) / speed;
+  else t = totalTime - rampTime(ramp, total - s);
+  return t * 1e6;
+}
+
+static void reportAxis(StepperType type, long expected, double speed, const IdealRamp& ramp) {
+  const std::vector<uint64_t>& edges = traces[type].edges;
+  StepEngineStats stats;
+  stepEngineGetStats(type, &stats);
+
+  printf("axis=%s steps=%lu expected=%ld late=%u", reinterpret_cast<const char*>(getAxisEventName(type)),
+         (unsigned long)edges.size(), expected, stats.lateSteps);
+  if ((long)edges.size() != expected) failed = true;
+  if (edges.size() < 2) {
+    printf("\n");
+    return;
+  }
+
+  uint64_t minInterval = UINT64_MAX;
+  double maxError = 0;
+  for (size_t k = 1; k < edges.size(); k++) {
+    uint64_t interval = edges[k] - edges[k - 1];
+    if (interval < minInterval) minInterval = interval;
+    double actual = (double)(edges[k] - edges[0]) / SIM_TICKS_PER_US;
+    double ideal = idealTimeUs(k + 1, expected, speed, ramp) - idealTimeUs(1, expected, speed, ramp);
+    double error = fabs(actual - ideal);
+    if (error > maxError) maxError = error;
+  }
+
+  double durationUs = (double)(edges.back() - edges.front()) / SIM_TICKS_PER_US;
+  double idealUs = idealTimeUs(expected, expected, speed, ramp) - idealTimeUs(1, expected, speed, ramp);
+  double timeErrPct = idealUs > 0 ? (durationUs - idealUs) * 100 / idealUs : 0.0;
+  printf(" time_ms=%.3f ideal_ms=%.3f time_err_pct=%.2f profile_err_max_us=%.1f peak_sps=%.0f target_sps=%.0f",
+         durationUs / 1000, idealUs / 1000, timeErrPct, maxError, 1e6 * SIM_TICKS_PER_US / minInterval, speed);
+#if PERF_ENABLED
+  if (stats.isrCalls) {
+    printf(" isr_avg_us=%.2f isr_max_us=%.1f", (double)stats.isrTicks / stats.isrCalls / STEP_ENGINE_TICKS_PER_US,
+           (double)stats.isrMaxTicks / STEP_ENGINE_TICKS_PER_US);
+  }
+#endif
+  // ошибка темпа (например, не тот период тика) не меняет число шагов - ловим по времени
+  if (fabs(timeErrPct) > BENCH_TIME_ERR_PCT) {
+    printf(" FAIL");
+    failed = true;
+  }
+  printf("\n");
+}
+
+static void reportHostIsr() {
+  SimIsrStats isr;
+  simGetIsrStats(&isr);
+  if (!isr.calls) return;
+  printf("host_isr calls=%llu avg_ns=%.0f max_ns=%llu\n", (unsigned long long)isr.calls,
+         (double)isr.hostNs / isr.calls, (unsigned long long)isr.maxHostNs);
+}
+
+static void beginMeasure() {
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) traces[i].edges.clear();
+  stepEngineResetStats();
+  simResetIsrStats();
+}
+
+static bool waitJobs(uint8_t axisMask) {
+  unsigned long start = millis();
+  for (;;) {
+    bool active = false;
+    for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+      if ((axisMask & STEP_ENGINE_AXIS_BIT(i)) && isMotionJobActive((StepperType)i)) active = true;
+    }
+    if (!active) return true;
+    if (millis() - start >= BENCH_JOB_TIMEOUT_MS) return false;
+    serviceMotionJobs();
+    serviceLog();
+    yield();
+  }
+}
+
+// ============== КОМАНДЫ СЦЕНАРИЯ ==============
+static void runMove(char* args) {
+  long expected[STEPPER_AXIS_COUNT] = {0};
+  uint8_t axisMask = 0;
+  beginMeasure();
+
+  for (char* name = strtok(args, " \t"); name; name = strtok(nullptr, " \t")) {
+    char* value = strtok(nullptr, " \t");
+    StepperType type;
+    if (!value || !parseAxis(name, type)) {
+      printf("error: move <axis> <position> ...\n");
+      failed = true;
+      return;
+    }
+    long position = atol(value);
+    long start = stepEngineGetPosition(type);
+    if (!startMoveJob(type, position, false)) {
+      printf("error: move %s rejected\n", name);
+      failed = true;
+      return;
+    }
+    expected[type] = labs(position - start);
+    axisMask |= STEP_ENGINE_AXIS_BIT(type);
+  }
+
+  if (!waitJobs(axisMask)) {
+    printf("error: move timeout\n");
+    failed = true;
+  }
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    if (!(axisMask & STEP_ENGINE_AXIS_BIT(i))) continue;
+    StepperConfig config;
+    readStepperConfig((StepperType)i, config);
+    IdealRamp ramp = {(double)axisAccel[i], axisJerk[i], axisTopSpeed[i], sqrt((double)axisAccel[i] / config.acceleration)};
+    reportAxis((StepperType)i, expected[i], min(config.maxSpeed, (int)stepEngineGetSpeedCeiling((StepperType)i)), ramp);
+  }
+  reportHostIsr();
+}
+
+// Каждое событие должно сработать в тот же тик, что и фронт STEP своего шага
+static void runEvents(char* args) {
+  char* name = strtok(args, " \t");
+  char* value = strtok(nullptr, " \t");
+  StepperType type;
+  if (!name || !value || !parseAxis(name, type)) {
+    printf("error: events <axis> <position> <pin>@<step>=<0|1> ...\n");
+    failed = true;
+    return;
+  }
+
+  StepEngineEvent events[STEP_ENGINE_MAX_EVENTS];
+  uint8_t count = 0;
+  outputPinCount = 0;
+  for (char* spec = strtok(nullptr, " \t"); spec && count < STEP_ENGINE_MAX_EVENTS; spec = strtok(nullptr, " \t")) {
+    unsigned pin, state;
+    unsigned long step;
+    if (sscanf(spec, "%u@%lu=%u", &pin, &step, &state) != 3) {
+      printf("error: event %s\n", spec);
+      failed = true;
+      return;
+    }
+    events[count++] = {(uint32_t)step, (uint8_t)pin, state != 0};
+
+    // До движения выход в состоянии, противоположном его первому событию
+    bool known = false;
+    for (uint8_t i = 0; i < outputPinCount; i++) known |= outputPins[i] == pin;
+    if (!known) {
+      digitalWrite(pin, state ? LOW : HIGH);
+      outputPins[outputPinCount++] = pin;
+    }
+  }
+
+  long position = atol(value);
+  long start = stepEngineGetPosition(type);
+  beginMeasure();
+  outputEdges.clear();
+  if (!startMoveJob(type, position, false, events, count) || !waitJobs(STEP_ENGINE_AXIS_BIT(type))) {
+    printf("error: events move failed\n");
+    failed = true;
+    return;
+  }
+
+  const std::vector<uint64_t>& edges = traces[type].edges;
+  for (uint8_t i = 0; i < count; i++) {
+    // Переключения пина идут в порядке его событий: k-е событие пина - k-е переключение
+    const OutputEdge* edge = nullptr;
+    uint8_t order = 0;
+    for (uint8_t j = 0; j < i; j++) order += events[j].pin == events[i].pin && events[j].step <= events[i].step;
+    for (const OutputEdge& candidate : outputEdges) {
+      if (candidate.pin == events[i].pin && order-- == 0) {
+        edge = &candidate;
+        break;
+      }
+    }
+    if (!edge) {
+      printf("event pin=%u step=%lu fired=0\n", events[i].pin, (unsigned long)events[i].step);
+      failed = true;
+      continue;
+    }
+    unsigned long firedStep = 0;
+    while (firedStep < edges.size() && edges[firedStep] <= edge->ticks) firedStep++;
+    printf("event pin=%u step=%lu fired_step=%lu\n", events[i].pin, (unsigned long)events[i].step, firedStep);
+    if (firedStep != events[i].step) failed = true;
+  }
+  printf("axis=%s steps=%lu expected=%ld pending=%u\n", name, (unsigned long)edges.size(), labs(position - start),
+         stepEngineGetPendingEvents(type));
+  outputPinCount = 0;
+}
+
+static void runClamp(long position) {
+  StepperConfig e0Config, e1Config;
+  readStepperConfig(STEPPER_E0, e0Config);
+  readStepperConfig(STEPPER_E1, e1Config);
+  long e0Expected = labs(position - stepEngineGetPosition(STEPPER_E0));
+  long e1Expected = labs(position - stepEngineGetPosition(STEPPER_E1));
+
+  beginMeasure();
+  if (!startClampJob(position, false)) {
+    printf("error: clamp rejected\n");
+    failed = true;
+    return;
+  }
+  if (!waitJobs(STEP_ENGINE_AXIS_BIT(STEPPER_E0))) {
+    printf("error: clamp timeout\n");
+    failed = true;
+  }
+  // Пара идёт общим профилем с меньшими из скоростей и ускорений вдоль гипотенузы,
+  // на каждую ось приходится доля, пропорциональная её пути
+  double speed = min(e0Config.maxSpeed, e1Config.maxSpeed);
+  double accel = min(e0Config.acceleration, e1Config.acceleration);
+  double path = sqrt((double)e0Expected * e0Expected + (double)e1Expected * e1Expected);
+  // Планировщик GPlanner2 разгоняет пару трапецией, *_JERK на неё не действует
+  if (path > 0) {
+    IdealRamp e0Ramp = {accel * e0Expected / path, 0, 0, 1};
+    IdealRamp e1Ramp = {accel * e1Expected / path, 0, 0, 1};
+    reportAxis(STEPPER_E0, e0Expected, speed * e0Expected / path, e0Ramp);
+    reportAxis(STEPPER_E1, e1Expected, speed * e1Expected / path, e1Ramp);
+  }
+  printf("clamp skew_max=%u\n", stepEngineGetClampSkew());
+  reportHostIsr();
+}
+
+// Стоимость расчёта блока планировщиком: addTarget() и checkBuffer(), который
+// вызывает calculateBlock()/setTarget() для новой точки. Двигатели без пинов
+static void runPlanner(uint32_t iterations) {
+  Stepper<STEPPER2WIRE> first(255, 255);
+  Stepper<STEPPER2WIRE> second(255, 255);
+  ClampGroupPlanner planner;
+  planner.addStepper(0, first);
+  planner.addStepper(1, second);
+  planner.setMaxSpeed(E0_MAX_SPEED);
+  planner.setAcceleration(E0_ACCELERATION);
+
+  uint64_t addNs = 0, checkNs = 0, checkMaxNs = 0;
+  uint32_t planned = 0;
+  for (uint32_t i = 0; i < iterations; i++) {
+    int32_t origin[2] = {0, 0};
+    int32_t target[2] = {(int32_t)(1000 + i % 4000), (int32_t)(900 + i % 3000)};
+    planner.brake();
+    planner.clearBuffer();
+    planner.setCurrent(origin);
+
+    auto t0 = std::chrono::steady_clock::now();
+    planner.addTarget(origin, 0);
+    planner.addTarget(target, 1);
+    auto t1 = std::chrono::steady_clock::now();
+    planner.start();
+    bool ok = planner.checkBuffer();
+    auto t2 = std::chrono::steady_clock::now();
+
+    uint64_t check = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count();
+    addNs += std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count();
+    checkNs += check;
+    if (check > checkMaxNs) checkMaxNs = check;
+    if (ok) planned++;
+  }
+  printf("planner calls=%lu planned=%lu add_target_ns=%.0f check_buffer_ns=%.0f check_buffer_max_ns=%llu\n",
+         (unsigned long)iterations, (unsigned long)planned, iterations ? (double)addNs / iterations : 0.0,
+         iterations ? (double)checkNs / iterations : 0.0, (unsigned long long)checkMaxNs);
+}
+
+// Пределы оси как после tune save (0 - config.h): следующие move идут с ними
+static void runLimits(char* args) {
+  char* name = strtok(args, " \t");
+  char* speed = strtok(nullptr, " \t");
+  char* accel = strtok(nullptr, " \t");
+  StepperType type;
+  if (!name || !speed || !accel || !parseAxis(name, type)) {
+    printf("error: limits <axis> <max_speed> <acceleration>\n");
+    failed = true;
+    return;
+  }
+  setAxisLimits(type, atoi(speed), atoi(accel));
+  StepperConfig config;
+  readStepperConfig(type, config);
+  stepEngineSetAcceleration(type, config.acceleration);
+  stepEngineSetMaxSpeed(type, config.maxSpeed);
+  printf("limits axis=%s max_speed=%d acceleration=%d ceiling_sps=%u\n", name, config.maxSpeed, config.acceleration,
+         stepEngineGetSpeedCeiling(type));
+}
+
+// Перемешивание: ходы должны вернуть ось в исходную позицию, число шагов - по циклам
+// (2 * ход на цикл) или оборотам; по времени вращение проверяется только по завершению
+static void runAgitate(char* args) {
+  char* name = strtok(args, " \t");
+  char* amplitude = strtok(nullptr, " \t");
+  char* speed = strtok(nullptr, " \t");
+  char* count = strtok(nullptr, " \t");
+  StepperType type;
+  if (!name || !amplitude || !speed || !count || !parseAxis(name, type)) {
+    printf("error: agitate <axis> <amplitude> <speed> <cycles|<ms>ms>\n");
+    failed = true;
+    return;
+  }
+  char* unit;
+  unsigned long value = strtoul(count, &unit, 10);
+  bool timed = !strcmp(unit, "ms");
+  long stroke = atol(amplitude);
+
+  long start = stepEngineGetPosition(type);
+  unsigned long began = millis();
+  beginMeasure();
+  if (!startAgitateJob(type, stroke, atoi(speed), timed ? 0 : value, timed ? value : 0, false) ||
+      !waitJobs(STEP_ENGINE_AXIS_BIT(type)) || getMotionJobResult(type) != JOB_RESULT_OK) {
+    printf("error: agitate failed\n");
+    failed = true;
+    return;
+  }
+
+  StepperConfig config;
+  readStepperConfig(type, config);
+  long offset = stepEngineGetPosition(type) - start;
+  unsigned long steps = traces[type].edges.size();
+  uint16_t cycles = getAgitateCycles(type);
+  long expected = stroke ? 2 * labs(stroke) * cycles : (timed ? labs(offset) : (long)value * config.stepsPerRevolution);
+  printf("agitate axis=%s cycles=%u steps=%lu expected=%ld offset=%ld elapsed_ms=%lu", name, cycles, steps, expected,
+         offset, millis() - began);
+  if ((long)steps != expected || (stroke && offset != 0) || (stroke && !timed && cycles != value)) failed = true;
+  if (!stroke) {
+    // Вращение без разворотов: продление хода не должно давать шаг чаще заданной скорости
+    // (перезапуск канала ставит шаг через STEP_ENGINE_MIN_LEAD_TICKS после предыдущего)
+    const std::vector<uint64_t>& edges = traces[type].edges;
+    uint64_t minInterval = UINT64_MAX;
+    for (size_t k = 1; k < edges.size(); k++) {
+      if (edges[k] - edges[k - 1] < minInterval) minInterval = edges[k] - edges[k - 1];
+    }
+    double peak = edges.size() > 1 ? 1e6 * SIM_TICKS_PER_US / minInterval : 0;
+    double target = labs(atol(speed));
+    printf(" peak_sps=%.0f target_sps=%.0f", peak, target);
+    if (peak > target * (1 + BENCH_TIME_ERR_PCT / 100)) {
+      printf(" FAIL");
+      failed = true;
+    }
+  }
+  printf("\n");
+  reportHostIsr();
+}
+
+static void runLine(char* line) {
+  char* comment = strchr(line, '#');
+  if (comment) *comment = '\0';
+  char* command = strtok(line, " \t\r\n");
+  if (!command) return;
+  char* rest = strtok(nullptr, "\r\n");
+  char empty[] = "";
+  if (!rest) rest = empty;
+
+  printf("> %s %s\n", command, rest);
+  if (!strcmp(command, "loop_us")) simSetLoopCost(atoi(rest));
+  else if (!strcmp(command, "isr_ticks")) simSetIsrCost(atoi(rest));
+  else if (!strcmp(command, "echo")) simSetEcho(atoi(rest) != 0);
+  else if (!strcmp(command, "move")) runMove(rest);
+  else if (!strcmp(command, "events")) runEvents(rest);
+  else if (!strcmp(command, "clamp")) runClamp(atol(rest));
+  else if (!strcmp(command, "planner")) runPlanner(strtoul(rest, nullptr, 10));
+  else if (!strcmp(command, "limits")) runLimits(rest);
+  else if (!strcmp(command, "agitate")) runAgitate(rest);
+  else {
+    printf("error: unknown command %s\n", command);
+    failed = true;
+  }
+}
+
+int main(int argc, char** argv) {
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <script>\n", argv[0]);
+    return 2;
+  }
+  FILE* script = fopen(argv[1], "r");
+  if (!script) {
+    perror(argv[1]);
+    return 2;
+  }
+
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    StepperType type = (StepperType)i;
+    StepperConfig config;
+    readStepperConfig(type, config);
+    traces[i].stepPin = config.stepPin;
+    // Концевики в состоянии "не сработал"
+    simSetInput(getAxisEndstopPin(type), getAxisEndstopNPN(type));
+  }
+  simSetPinHook(onPinChange);
+
+  initializeSteppers();
+  initializeStepEngine();
+  initializeMotionJobs();
+  initializeEndstopLatches();
+
+  char line[256];
+  while (fgets(line, sizeof(line), script)) runLine(line);
+  fclose(script);
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,127 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// ============== ARDUINO ДЛЯ НАТИВНОЙ СБОРКИ ==============
+// Минимальный слой Arduino для сборки кода движения на ПК (env:native_bench).
+// Время виртуальное: millis()/micros() идут от счётчика sim.h, yield() и delay()
+// продвигают его и вызывают прерывания сравнения таймеров 1/3/4/5.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "avr/io.h"
+#include "avr/pgmspace.h"
+#include "avr/interrupt.h"
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define CHANGE 1
+#define FALLING 2
+#define RISING 3
+#define NOT_AN_INTERRUPT -1
+
+#define A0 54
+#define A1 55
+#define A2 56
+#define A3 57
+#define A4 58
+#define A5 59
+#define A6 60
+#define A7 61
+#define A8 62
+#define A9 63
+#define A10 64
+#define A11 65
+#define A12 66
+#define A13 67
+#define A14 68
+#define A15 69
+
+#define SIM_PIN_COUNT 70
+
+class __FlashStringHelper;
+#define F(string_literal) (reinterpret_cast<const __FlashStringHelper*>(string_literal))
+
+template <typename T, typename U>
+static inline auto min(const T& a, const U& b) -> decltype(a < b ? a : b) { return a < b ? a : b; }
+template <typename T, typename U>
+static inline auto max(const T& a, const U& b) -> decltype(a > b ? a : b) { return a > b ? a : b; }
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+#define sq(x) ((x) * (x))
+
+// Пины: уровни хранятся в sim.cpp, фронты STEP передаются обработчику sim.h
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t value);
+int digitalRead(uint8_t pin);
+
+// Прерывания по пинам в симуляции не генерируются: концевики опрашиваются
+static inline int digitalPinToInterrupt(uint8_t) { return NOT_AN_INTERRUPT; }
+static inline void attachInterrupt(uint8_t, void (*)(void), int) {}
+static inline void detachInterrupt(uint8_t) {}
+static inline volatile uint8_t* digitalPinToPCICR(uint8_t) { return nullptr; }
+static inline uint8_t digitalPinToPCICRbit(uint8_t) { return 0xFF; }
+static inline volatile uint8_t* digitalPinToPCMSK(uint8_t) { return nullptr; }
+static inline uint8_t digitalPinToPCMSKbit(uint8_t) { return 0; }
+static inline uint8_t digitalPinToPort(uint8_t pin) { return pin; }
+static inline uint8_t digitalPinToBitMask(uint8_t) { return 1; }
+volatile uint8_t* portInputRegister(uint8_t port);
+volatile uint8_t* portOutputRegister(uint8_t port);
+
+static inline void interrupts() {}
+static inline void noInterrupts() {}
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+void yield();
+
+// Вывод в стиле Arduino Print: наследник задаёт write()
+class Print {
+ public:
+  virtual ~Print() {}
+  virtual size_t write(uint8_t value) = 0;
+  virtual size_t write(const uint8_t* buffer, size_t size);
+
+  size_t print(const char* text);
+  size_t print(const __FlashStringHelper* text) { return print(reinterpret_cast<const char*>(text)); }
+  size_t print(char value);
+  size_t print(unsigned char value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(int value, int base = 10) { return print((long)value, base); }
+  size_t print(unsigned int value, int base = 10) { return print((unsigned long)value, base); }
+  size_t print(long value, int base = 10);
+  size_t print(unsigned long value, int base = 10);
+  size_t print(double value, int digits = 2);
+
+  template <typename T>
+  size_t println(T value) { size_t n = print(value); return n + println(); }
+  template <typename T>
+  size_t println(T value, int format) { size_t n = print(value, format); return n + println(); }
+  size_t println() { return print("\r\n"); }
+};
+
+// Последовательный порт: вывод в stdout при simSetEcho(true), ввода нет
+class SimSerial : public Print {
+ public:
+  void begin(unsigned long) {}
+  int available() { return 0; }
+  int read() { return -1; }
+  int availableForWrite() { return 63; }
+  void flush() {}
+
+  size_t write(uint8_t value) override;
+  size_t write(const uint8_t* buffer, size_t size) override;
+  using Print::write;
+};
+
+extern SimSerial Serial;
+
+#endif // SIM_ARDUINO_H
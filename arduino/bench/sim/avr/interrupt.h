@@ -0,0 +1,13 @@
+#ifndef SIM_AVR_INTERRUPT_H
+#define SIM_AVR_INTERRUPT_H
+
+// Обработчики прерываний - обычные функции, их вызывает таймерная модель sim.cpp
+#define ISR_NOBLOCK
+#define ISR(vector, ...)       \
+  extern "C" void vector(void); \
+  extern "C" void vector(void)
+
+static inline void cli() {}
+static inline void sei() {}
+
+#endif // SIM_AVR_INTERRUPT_H
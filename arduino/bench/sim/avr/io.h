@@ -0,0 +1,65 @@
+#ifndef SIM_AVR_IO_H
+#define SIM_AVR_IO_H
+
+// ============== РЕГИСТРЫ ATMEGA2560 ДЛЯ НАТИВНОЙ СБОРКИ ==============
+// Таймеры 1/3/4/5 считают в sim.cpp, остальные регистры - простые переменные
+
+#include <stdint.h>
+
+#ifndef F_CPU
+#define F_CPU 16000000UL
+#endif
+
+#define E2END 0x0FFF
+
+extern volatile uint8_t SREG;
+
+#define SIM_TIMER_REGS(n)                  \
+  extern volatile uint8_t TCCR##n##A;      \
+  extern volatile uint8_t TCCR##n##B;      \
+  extern volatile uint16_t TCNT##n;        \
+  extern volatile uint16_t OCR##n##A;      \
+  extern volatile uint16_t OCR##n##B;      \
+  extern volatile uint8_t TIMSK##n;        \
+  extern volatile uint8_t TIFR##n;
+
+SIM_TIMER_REGS(1)
+SIM_TIMER_REGS(3)
+SIM_TIMER_REGS(4)
+SIM_TIMER_REGS(5)
+
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCMSK1;
+
+// Номера битов
+#define CS10 0
+#define CS11 1
+#define CS12 2
+#define CS30 0
+#define CS31 1
+#define CS32 2
+#define CS40 0
+#define CS41 1
+#define CS42 2
+#define CS50 0
+#define CS51 1
+#define CS52 2
+#define OCIE1A 1
+#define OCIE1B 2
+#define OCIE3A 1
+#define OCIE3B 2
+#define OCIE4A 1
+#define OCIE4B 2
+#define OCIE5A 1
+#define OCIE5B 2
+#define OCF1A 1
+#define OCF1B 2
+#define OCF3A 1
+#define OCF4A 1
+#define OCF5A 1
+#define OCF5B 2
+#define PCIE0 0
+#define PCIE1 1
+#define PCIE2 2
+
+#endif // SIM_AVR_IO_H
@@ -0,0 +1,31 @@
+#ifndef SIM_AVR_PGMSPACE_H
+#define SIM_AVR_PGMSPACE_H
+
+// На ПК flash и ОЗУ - одно адресное пространство
+#include <stdint.h>
+#include <string.h>
+
+#define PROGMEM
+#define PSTR(s) (s)
+typedef const char* PGM_P;
+
+// Чтение через memcpy: адрес приходит любым указателем, как у avr-libc
+template <typename T>
+static inline T simPgmRead(const void* address) {
+  T value;
+  memcpy(&value, address, sizeof(value));
+  return value;
+}
+
+#define pgm_read_byte(address) simPgmRead<uint8_t>((const void*)(address))
+#define pgm_read_word(address) simPgmRead<uint16_t>((const void*)(address))
+#define pgm_read_dword(address) simPgmRead<uint32_t>((const void*)(address))
+#define pgm_read_float(address) simPgmRead<float>((const void*)(address))
+#define pgm_read_ptr(address) simPgmRead<void*>((const void*)(address))
+#define memcpy_P memcpy
+#define strcpy_P strcpy
+#define strlen_P strlen
+#define strcmp_P strcmp
+#define strncmp_P strncmp
+
+#endif // SIM_AVR_PGMSPACE_H
@@ -0,0 +1,314 @@
+/**
+ * @file: sim.cpp
+ * @description: Виртуальное время, модель таймеров 1/3/4/5, пины и Serial для нативной сборки
+ * @dependencies: sim.h, Arduino.h (bench/sim)
+ * @created: 2026-10-14
+ *
+ * Таймеры считают только на участках simAdvanceUs(): время перескакивает сразу
+ * к ближайшему совпадению TCNTn с OCRnx разрешённого канала, поэтому длинные
+ * перемещения моделируются за доли секунды. Запись в TIFRn снимает ожидающие флаги.
+ */
+
+#include "sim.h"
+#include <Arduino.h>
+#include <chrono>
+#include <stdio.h>
+
+extern "C" {
+void TIMER1_COMPA_vect(void);
+void TIMER3_COMPA_vect(void);
+void TIMER4_COMPA_vect(void);
+void TIMER5_COMPA_vect(void);
+void TIMER5_COMPB_vect(void);
+}
+
+// ============== РЕГИСТРЫ ==============
+volatile uint8_t SREG = 0x80;
+
+#define SIM_TIMER_DEFS(n)          \
+  volatile uint8_t TCCR##n##A = 0; \
+  volatile uint8_t TCCR##n##B = 0; \
+  volatile uint16_t TCNT##n = 0;   \
+  volatile uint16_t OCR##n##A = 0; \
+  volatile uint16_t OCR##n##B = 0; \
+  volatile uint8_t TIMSK##n = 0;   \
+  volatile uint8_t TIFR##n = 0;
+
+SIM_TIMER_DEFS(1)
+SIM_TIMER_DEFS(3)
+SIM_TIMER_DEFS(4)
+SIM_TIMER_DEFS(5)
+
+volatile uint8_t PCICR = 0;
+volatile uint8_t PCMSK1 = 0;
+
+// Граница кучи для perf.cpp (__data_start на хосте даёт libc)
+char __heap_start;
+char* __brkval = nullptr;
+
+SimSerial Serial;
+
+// ============== МОДЕЛЬ ТАЙМЕРОВ ==============
+typedef struct {
+  volatile uint8_t* tccrb;
+  volatile uint16_t* tcnt;
+  volatile uint8_t* tifr;
+} SimTimer;
+
+typedef struct {
+  uint8_t timer;              // индекс в timers[]
+  volatile uint16_t* ocr;
+  volatile uint8_t* timsk;
+  uint8_t mask;
+  void (*vector)(void);
+  bool pending;
+} SimChannel;
+
+static SimTimer timers[] = {
+  {&TCCR1B, &TCNT1, &TIFR1},
+  {&TCCR3B, &TCNT3, &TIFR3},
+  {&TCCR4B, &TCNT4, &TIFR4},
+  {&TCCR5B, &TCNT5, &TIFR5},
+};
+
+// Порядок - приоритет векторов ATmega2560
+static SimChannel channels[] = {
+  {0, &OCR1A, &TIMSK1, (1 << OCIE1A), TIMER1_COMPA_vect, false},
+  {1, &OCR3A, &TIMSK3, (1 << OCIE3A), TIMER3_COMPA_vect, false},
+  {2, &OCR4A, &TIMSK4, (1 << OCIE4A), TIMER4_COMPA_vect, false},
+  {3, &OCR5A, &TIMSK5, (1 << OCIE5A), TIMER5_COMPA_vect, false},
+  {3, &OCR5B, &TIMSK5, (1 << OCIE5B), TIMER5_COMPB_vect, false},
+};
+
+#define SIM_TIMER_COUNT (sizeof(timers) / sizeof(timers[0]))
+#define SIM_CHANNEL_COUNT (sizeof(channels) / sizeof(channels[0]))
+
+static uint64_t now = 0;
+static uint64_t busyUntil = 0;
+static uint16_t isrCost = 0;
+static uint16_t loopCost = 10;
+static bool echo = false;
+static bool inIsr = false;            // обработчики не вкладываются (I сброшен на входе в ISR)
+static SimIsrStats isrStats = {0, 0, 0};
+
+static bool timerRunning(const SimTimer& timer) {
+  return (*timer.tccrb & 0x07) != 0;
+}
+
+static bool channelEnabled(const SimChannel& ch) {
+  return timerRunning(timers[ch.timer]) && (*ch.timsk & ch.mask);
+}
+
+// Запись единицы в TIFRn сбрасывает флаг совпадения
+static void applyFlagWrites() {
+  for (uint8_t t = 0; t < SIM_TIMER_COUNT; t++) {
+    uint8_t cleared = *timers[t].tifr;
+    if (!cleared) continue;
+    for (uint8_t c = 0; c < SIM_CHANNEL_COUNT; c++) {
+      if (channels[c].timer == t && (cleared & channels[c].mask)) channels[c].pending = false;
+    }
+    *timers[t].tifr = 0;
+  }
+}
+
+static void servicePending() {
+  if (inIsr) return;
+  while (now >= busyUntil) {
+    SimChannel* next = nullptr;
+    for (uint8_t c = 0; c < SIM_CHANNEL_COUNT && !next; c++) {
+      if (channels[c].pending && channelEnabled(channels[c])) next = &channels[c];
+    }
+    if (!next) return;
+
+    next->pending = false;
+    inIsr = true;
+    auto start = std::chrono::steady_clock::now();
+    next->vector();
+    inIsr = false;
+    uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    isrStats.calls++;
+    isrStats.hostNs += ns;
+    if (ns > isrStats.maxHostNs) isrStats.maxHostNs = ns;
+
+    applyFlagWrites();
+    busyUntil = now + isrCost;
+  }
+}
+
+uint64_t simTicks() {
+  return now;
+}
+
+void simAdvanceUs(uint32_t us) {
+  uint64_t end = now + (uint64_t)us * SIM_TICKS_PER_US;
+  applyFlagWrites();
+  servicePending();
+
+  while (now < end) {
+    uint64_t step = end - now;
+    bool waiting = false;
+    for (uint8_t c = 0; c < SIM_CHANNEL_COUNT; c++) {
+      const SimChannel& ch = channels[c];
+      if (!channelEnabled(ch)) continue;
+      if (ch.pending) waiting = true;
+      uint32_t distance = (uint16_t)(*ch.ocr - *timers[ch.timer].tcnt);
+      if (distance == 0) distance = 0x10000;
+      if (distance < step) step = distance;
+    }
+    if (waiting && busyUntil > now && busyUntil - now < step) step = busyUntil - now;
+
+    for (uint8_t t = 0; t < SIM_TIMER_COUNT; t++) {
+      if (timerRunning(timers[t])) *timers[t].tcnt = (uint16_t)(*timers[t].tcnt + step);
+    }
+    now += step;
+
+    for (uint8_t c = 0; c < SIM_CHANNEL_COUNT; c++) {
+      SimChannel& ch = channels[c];
+      if (channelEnabled(ch) && *timers[ch.timer].tcnt == *ch.ocr) ch.pending = true;
+    }
+    servicePending();
+  }
+}
+
+void simSetIsrCost(uint16_t ticks) {
+  isrCost = ticks;
+}
+
+void simSetLoopCost(uint16_t us) {
+  loopCost = us;
+}
+
+void simSetEcho(bool enabled) {
+  echo = enabled;
+}
+
+void simGetIsrStats(SimIsrStats* stats) {
+  *stats = isrStats;
+}
+
+void simResetIsrStats() {
+  isrStats.calls = 0;
+  isrStats.hostNs = 0;
+  isrStats.maxHostNs = 0;
+}
+
+// ============== ВРЕМЯ ==============
+unsigned long millis() {
+  return (unsigned long)(now / (SIM_TICKS_PER_US * 1000UL));
+}
+
+unsigned long micros() {
+  return (unsigned long)(now / SIM_TICKS_PER_US);
+}
+
+void delay(unsigned long ms) {
+  simAdvanceUs(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us) {
+  simAdvanceUs(us);
+}
+
+void yield() {
+  simAdvanceUs(loopCost);
+}
+
+// ============== ПИНЫ ==============
+static uint8_t outputLevels[SIM_PIN_COUNT];
+static uint8_t inputLevels[SIM_PIN_COUNT];
+static volatile uint8_t portRegisters[SIM_PIN_COUNT];
+static SimPinHook pinHook = nullptr;
+static bool inputsInitialized = false;
+
+static void initializeInputs() {
+  if (inputsInitialized) return;
+  memset(inputLevels, HIGH, sizeof(inputLevels));
+  inputsInitialized = true;
+}
+
+void pinMode(uint8_t, uint8_t) {}
+
+void digitalWrite(uint8_t pin, uint8_t value) {
+  if (pin >= SIM_PIN_COUNT) return;
+  uint8_t level = value ? HIGH : LOW;
+  if (outputLevels[pin] == level) return;
+  outputLevels[pin] = level;
+  if (pinHook) pinHook(pin, level, now);
+}
+
+int digitalRead(uint8_t pin) {
+  initializeInputs();
+  return pin < SIM_PIN_COUNT ? inputLevels[pin] : LOW;
+}
+
+void simSetInput(uint8_t pin, bool level) {
+  initializeInputs();
+  if (pin >= SIM_PIN_COUNT) return;
+  inputLevels[pin] = level ? HIGH : LOW;
+  portRegisters[pin] = level ? 1 : 0;
+}
+
+void simSetPinHook(SimPinHook hook) {
+  pinHook = hook;
+}
+
+volatile uint8_t* portInputRegister(uint8_t port) {
+  return &portRegisters[port < SIM_PIN_COUNT ? port : 0];
+}
+
+volatile uint8_t* portOutputRegister(uint8_t port) {
+  return &portRegisters[port < SIM_PIN_COUNT ? port : 0];
+}
+
+// ============== SERIAL ==============
+size_t SimSerial::write(uint8_t value) {
+  if (echo) fputc(value, stdout);
+  return 1;
+}
+
+size_t SimSerial::write(const uint8_t* buffer, size_t size) {
+  if (echo) fwrite(buffer, 1, size, stdout);
+  return size;
+}
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+  for (size_t i = 0; i < size; i++) write(buffer[i]);
+  return size;
+}
+
+size_t Print::print(const char* text) {
+  size_t length = strlen(text);
+  return write((const uint8_t*)text, length);
+}
+
+size_t Print::print(char value) {
+  return write((uint8_t)value);
+}
+
+size_t Print::print(long value, int base) {
+  if (base == 10) {
+    char buffer[24];
+    snprintf(buffer, sizeof(buffer), "%ld", value);
+    return print(buffer);
+  }
+  return print((unsigned long)value, base);
+}
+
+size_t Print::print(unsigned long value, int base) {
+  char buffer[72];
+  char* p = buffer + sizeof(buffer) - 1;
+  *p = '\0';
+  if (base < 2) base = 10;
+  do {
+    uint8_t digit = value % base;
+    *--p = digit < 10 ? '0' + digit : 'A' + digit - 10;
+    value /= base;
+  } while (value);
+  return print(p);
+}
+
+size_t Print::print(double value, int digits) {
+  char buffer[48];
+  snprintf(buffer, sizeof(buffer), "%.*f", digits, value);
+  return print(buffer);
+}
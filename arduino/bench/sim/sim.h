@@ -0,0 +1,42 @@
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+
+// ============== УПРАВЛЕНИЕ СИМУЛЯЦИЕЙ ==============
+// Время считается в тиках таймеров 1/3/4/5 с делителем 8: 2 тика на мкс.
+// Прерывание сравнения вызывается в тот тик, когда TCNTn совпадает с OCRnx,
+// если его бит разрешён в TIMSKn. Обработчик занимает simSetIsrCost() тиков:
+// совпадения за это время ждут своей очереди, как флаги OCFnx на кристалле.
+#define SIM_TICKS_PER_US 2
+
+uint64_t simTicks();
+
+// Продвижение времени с обслуживанием прерываний
+void simAdvanceUs(uint32_t us);
+
+// Стоимость одного вызова обработчика и одного прохода основного цикла (yield)
+void simSetIsrCost(uint16_t ticks);
+void simSetLoopCost(uint16_t us);
+
+// Вывод Serial в stdout (по умолчанию выключен)
+void simSetEcho(bool enabled);
+
+// Уровень входа, который вернёт digitalRead()
+void simSetInput(uint8_t pin, bool level);
+
+// Обработчик изменения уровня выхода (фронты STEP/DIR)
+typedef void (*SimPinHook)(uint8_t pin, bool level, uint64_t ticks);
+void simSetPinHook(SimPinHook hook);
+
+// Время хоста в обработчиках прерываний: вызовы и наносекунды с последнего сброса
+typedef struct {
+  uint64_t calls;
+  uint64_t hostNs;
+  uint64_t maxHostNs;
+} SimIsrStats;
+
+void simGetIsrStats(SimIsrStats* stats);
+void simResetIsrStats();
+
+#endif // SIM_H
@@ -0,0 +1,9 @@
+#ifndef SIM_UTIL_ATOMIC_H
+#define SIM_UTIL_ATOMIC_H
+
+// Прерывания симуляции вызываются только из yield()/delay(), блок выполняется как обычный
+#define ATOMIC_RESTORESTATE 0
+#define ATOMIC_FORCEON 1
+#define ATOMIC_BLOCK(type) for (uint8_t simAtomicOnce = 1; simAtomicOnce; simAtomicOnce = 0)
+
+#endif // SIM_UTIL_ATOMIC_H
@@ -0,0 +1,156 @@
+#ifndef ACCEL_PROFILE_H
+#define ACCEL_PROFILE_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== ТАБЛИЧНЫЙ ПРОФИЛЬ РАЗГОНА ==============
+// Разгон делится на SLICES участков с равным приростом скорости. Для участка j таблица хранит
+// путь от старта до конца участка (он же путь торможения с этой скорости) и период шага на нём.
+// Трапеция (рывок 0): участок j длится quantum * (2j - 1) шагов, границы на quantum * j^2 (s = v^2 / 2a).
+// S-кривая (рывок J, шаг/сек^3): ускорение нарастает до a за a / J, держится и спадает до нуля
+// к верхней скорости; период участка - время участка по кривой, делённое на его шаги.
+// Таблицы считает компилятор из *_ACCELERATION, *_JERK и скоростей config.h, в прерывании
+// остаются только счётчики и чтение таблицы из PROGMEM.
+#define ACCEL_PROFILE_SLICES 64
+
+typedef struct {
+  uint32_t brakeSteps[ACCEL_PROFILE_SLICES + 1];  // путь до конца участка j, шагов; [0] = 0
+  uint32_t periodUs[ACCEL_PROFILE_SLICES + 1];    // период шага на участке j, [0] не используется
+} AccelProfile;
+
+constexpr uint32_t accelProfileMax(uint32_t a, uint32_t b) {
+  return a > b ? a : b;
+}
+
+// Квадратный корень методом Ньютона для вычисления на этапе компиляции
+constexpr double accelProfileSqrtIter(double x, double guess, uint8_t iterations) {
+  return iterations ? accelProfileSqrtIter(x, (guess + x / guess) / 2, iterations - 1) : guess;
+}
+
+constexpr double accelProfileSqrt(double x) {
+  return x > 0 ? accelProfileSqrtIter(x, x > 1 ? x : 1, 32) : 0;
+}
+
+// Квант выбирается так, чтобы SLICES участков хватило до скорости speed: quantum * SLICES^2 >= speed^2 / 2a
+constexpr uint32_t accelProfileQuantum(uint32_t accel, uint32_t speed) {
+  return accelProfileMax(1, ((uint32_t)speed * speed / (2UL * accel) + ACCEL_PROFILE_SLICES * ACCEL_PROFILE_SLICES - 1) /
+                                (ACCEL_PROFILE_SLICES * ACCEL_PROFILE_SLICES));
+}
+
+// Прирост скорости на участок: у трапеции из кванта, у S-кривой speed / SLICES
+constexpr double accelProfileVelocityStep(uint32_t accel, uint32_t speed, uint32_t jerk) {
+  return jerk ? (double)speed / ACCEL_PROFILE_SLICES : accelProfileSqrt(2.0 * accel * accelProfileQuantum(accel, speed));
+}
+
+// Наибольшее ускорение на кривой: до скорости speed за время рывка может не успеть набраться accel
+constexpr double accelProfilePeakAccel(uint32_t accel, uint32_t speed, uint32_t jerk) {
+  return (jerk == 0 || (double)accel * accel <= (double)speed * jerk) ? accel : accelProfileSqrt((double)speed * jerk);
+}
+
+// Скорость в конце нарастания ускорения: ap^2 / 2J
+constexpr double accelProfileJerkVelocity(double peak, uint32_t jerk) {
+  return peak * peak / (2.0 * jerk);
+}
+
+// Путь за время t при росте ускорения от нуля с рывком J (и за время t до конца спада)
+constexpr double accelProfileJerkDistance(double t, uint32_t jerk) {
+  return (double)jerk * t * t * t / 6;
+}
+
+// Длительность разгона до speed: V / ap + ap / J, путь разгона - speed * T / 2
+constexpr double accelProfileRampTime(uint32_t speed, uint32_t jerk, double peak) {
+  return speed / peak + peak / jerk;
+}
+
+// Путь от старта до скорости v, шагов. На спаде ускорения - полный путь разгона
+// минус недостающий до speed участок длительностью tau: speed * tau - J * tau^3 / 6
+constexpr double accelProfileDistanceTail(double total, uint32_t speed, uint32_t jerk, double tau) {
+  return total - (speed * tau - accelProfileJerkDistance(tau, jerk));
+}
+
+constexpr double accelProfileDistanceAt(double v, uint32_t speed, uint32_t jerk, double peak) {
+  return jerk == 0 ? v * v / (2.0 * peak)
+         : v <= accelProfileJerkVelocity(peak, jerk) ? accelProfileJerkDistance(accelProfileSqrt(2.0 * v / jerk), jerk)
+         : v <= speed - accelProfileJerkVelocity(peak, jerk)
+             ? accelProfileJerkDistance(peak / jerk, jerk) +
+                   (v * v - accelProfileJerkVelocity(peak, jerk) * accelProfileJerkVelocity(peak, jerk)) / (2.0 * peak)
+         : accelProfileDistanceTail(speed * accelProfileRampTime(speed, jerk, peak) / 2, speed, jerk,
+                                    v >= speed ? 0 : accelProfileSqrt(2.0 * (speed - v) / jerk));
+}
+
+// Путь S-кривой к моменту t от старта, шагов
+constexpr double accelProfileDistanceAtTime(double t, uint32_t speed, uint32_t jerk, double peak) {
+  return t <= peak / jerk ? accelProfileJerkDistance(t, jerk)
+         : t <= speed / peak ? accelProfileJerkDistance(peak / jerk, jerk) + accelProfileJerkVelocity(peak, jerk) * (t - peak / jerk) +
+                                   peak * (t - peak / jerk) * (t - peak / jerk) / 2
+         : t < accelProfileRampTime(speed, jerk, peak)
+             ? accelProfileDistanceTail(speed * accelProfileRampTime(speed, jerk, peak) / 2, speed, jerk,
+                                        accelProfileRampTime(speed, jerk, peak) - t)
+             : speed * accelProfileRampTime(speed, jerk, peak) / 2 + speed * (t - accelProfileRampTime(speed, jerk, peak));
+}
+
+// Момент прохождения пути d по S-кривой - делением отрезка [low, high] пополам
+constexpr double accelProfileTimeSearch(double d, uint32_t speed, uint32_t jerk, double peak, double low, double high,
+                                        uint8_t iterations) {
+  return iterations == 0 ? (low + high) / 2
+         : accelProfileDistanceAtTime((low + high) / 2, speed, jerk, peak) < d
+             ? accelProfileTimeSearch(d, speed, jerk, peak, (low + high) / 2, high, iterations - 1)
+             : accelProfileTimeSearch(d, speed, jerk, peak, low, (low + high) / 2, iterations - 1);
+}
+
+// Время от старта до шага d, сек; за пределами разгона - движение на speed
+constexpr double accelProfileTimeAt(double d, uint32_t speed, uint32_t jerk, double peak) {
+  return jerk == 0 ? accelProfileSqrt(2.0 * d / peak)
+         : d >= speed * accelProfileRampTime(speed, jerk, peak) / 2
+             ? accelProfileRampTime(speed, jerk, peak) + (d - speed * accelProfileRampTime(speed, jerk, peak) / 2) / speed
+             : accelProfileTimeSearch(d, speed, jerk, peak, 0, accelProfileRampTime(speed, jerk, peak), 40);
+}
+
+// Граница участка j: путь до скорости j * dv, но не меньше j шагов - иначе первые участки
+// S-кривой были бы пустыми. Путь на прирост скорости растёт с номером участка (ds/dv = v / a,
+// ускорение падает только на спаде, где растёт скорость), поэтому границы строго возрастают
+constexpr uint32_t accelProfileBrake(uint32_t accel, uint32_t speed, uint32_t jerk, uint8_t slice) {
+  return accelProfileMax(slice, (uint32_t)(accelProfileDistanceAt(slice * accelProfileVelocityStep(accel, speed, jerk), speed, jerk,
+                                                                   accelProfilePeakAccel(accel, speed, jerk)) +
+                                           0.5));
+}
+
+// Период на участке j: время между его границами по кривой на число шагов участка,
+// так округление границ до шага не сбивает моменты шагов на границах.
+// Для трапеции это период скорости середины участка (j - 0.5) * sqrt(2 * a * quantum)
+constexpr double accelProfileBoundaryTime(uint32_t accel, uint32_t speed, uint32_t jerk, uint8_t slice) {
+  return accelProfileTimeAt(accelProfileBrake(accel, speed, jerk, slice), speed, jerk, accelProfilePeakAccel(accel, speed, jerk));
+}
+
+constexpr uint32_t accelProfilePeriod(uint32_t accel, uint32_t speed, uint32_t jerk, uint8_t slice) {
+  return slice ? (uint32_t)(1000000.0 *
+                                (accelProfileBoundaryTime(accel, speed, jerk, slice) -
+                                 accelProfileBoundaryTime(accel, speed, jerk, slice - 1)) /
+                                (accelProfileBrake(accel, speed, jerk, slice) - accelProfileBrake(accel, speed, jerk, slice - 1)) +
+                            0.5)
+               : 0;
+}
+
+#define ACCEL_PROFILE_T4(fn, a, v, r, j) fn(a, v, r, j), fn(a, v, r, j + 1), fn(a, v, r, j + 2), fn(a, v, r, j + 3)
+#define ACCEL_PROFILE_T16(fn, a, v, r, j) \
+  ACCEL_PROFILE_T4(fn, a, v, r, j), ACCEL_PROFILE_T4(fn, a, v, r, j + 4), ACCEL_PROFILE_T4(fn, a, v, r, j + 8), \
+      ACCEL_PROFILE_T4(fn, a, v, r, j + 12)
+#define ACCEL_PROFILE_T64(fn, a, v, r)                                                                  \
+  ACCEL_PROFILE_T16(fn, a, v, r, 1), ACCEL_PROFILE_T16(fn, a, v, r, 17), ACCEL_PROFILE_T16(fn, a, v, r, 33), \
+      ACCEL_PROFILE_T16(fn, a, v, r, 49)
+
+// Инициализатор AccelProfile для ускорения accel (шаг/сек^2), максимальной скорости speed (шаг/сек)
+// и рывка jerk (шаг/сек^3, 0 - трапеция)
+#define ACCEL_PROFILE(accel, speed, jerk)                                         \
+  {                                                                               \
+    {0, ACCEL_PROFILE_T64(accelProfileBrake, accel, speed, jerk)}, {            \
+      0, ACCEL_PROFILE_T64(accelProfilePeriod, accel, speed, jerk)              \
+    }                                                                             \
+  }
+
+// Верхняя скорость таблицы оси: максимум из рабочей скорости и скоростей хоминга
+#define ACCEL_PROFILE_SPEED(axis) \
+  accelProfileMax(accelProfileMax(axis##_MAX_SPEED, axis##_HOMING_SPEED), axis##_HOMING_FAST_SPEED)
+
+#endif // ACCEL_PROFILE_H
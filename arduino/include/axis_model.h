@@ -0,0 +1,85 @@
+#ifndef AXIS_MODEL_H
+#define AXIS_MODEL_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== МОДЕЛЬ ОСЕЙ ==============
+// Одно описание пяти осей для обеих прошивок (arduino/ и arduino_main/). Значения - макросы
+// config.h, таблица axisModel constexpr: прочитанная в константных выражениях, она не
+// занимает ОЗУ. Axis<id> отдаёт поля оси константами - пины, пересчёт единиц и полярность
+// датчика сворачиваются компилятором в числа. Порядок осей - StepperType и MotorID arduino_main
+
+enum AxisId : uint8_t {
+  AXIS_MULTI,
+  AXIS_MULTIZONE,
+  AXIS_RRIGHT,
+  AXIS_E0,
+  AXIS_E1
+};
+
+#define AXIS_COUNT 5
+static_assert(AXIS_E1 + 1 == AXIS_COUNT, "AXIS_COUNT расходится с AxisId");
+
+struct AxisModel {
+  uint8_t stepPin;
+  uint8_t dirPin;
+  uint8_t enablePin;
+  uint8_t endstopPin;           // датчик, по которому ось обнуляется
+  uint16_t stepsPerRevolution;
+  uint16_t stepsPerUnit;        // шагов на единицу хода (мм, градус)
+  uint16_t maxSpeed;            // шаг/сек
+  uint16_t acceleration;        // шаг/сек^2
+  uint16_t homingSpeed;         // перемещения после хоминга
+  uint16_t homingFastSpeed;     // быстрый поиск датчика
+  uint16_t homingLatchSpeed;    // медленный повторный подход
+  uint16_t homingLatchDistance; // отъезд перед повторным подходом, шагов
+  bool endstopNPN;              // NPN - при срабатывании на пине LOW
+  bool powerAlwaysOn;
+};
+
+#define AXIS_MODEL_ENTRY(AXIS, endstopPin)                                                         \
+  {                                                                                                \
+    AXIS##_STEP_PIN, AXIS##_DIR_PIN, AXIS##_ENABLE_PIN, endstopPin, AXIS##_STEPS_PER_REVOLUTION,   \
+        AXIS##_STEPS_PER_UNIT, AXIS##_MAX_SPEED, AXIS##_ACCELERATION, AXIS##_HOMING_SPEED,         \
+        AXIS##_HOMING_FAST_SPEED, AXIS##_HOMING_LATCH_SPEED, AXIS##_HOMING_LATCH_DISTANCE,         \
+        AXIS##_ENDSTOP_TYPE_NPN, AXIS##_POWER_ALWAYS_ON                                            \
+  }
+
+constexpr AxisModel axisModel[AXIS_COUNT] = {
+  AXIS_MODEL_ENTRY(MULTI, MULTI_ENDSTOP_PIN),
+  AXIS_MODEL_ENTRY(MULTIZONE, MULTIZONE_ENDSTOP_PIN),
+  AXIS_MODEL_ENTRY(RRIGHT, RRIGHT_ENDSTOP_PIN),
+  AXIS_MODEL_ENTRY(E0, CLAMP_SENSOR_PIN),   // E0/E1 обнуляются по общему датчику clamp_zero
+  AXIS_MODEL_ENTRY(E1, CLAMP_SENSOR_PIN),
+};
+
+// Шагов на единицу и на оборот больше нуля у всех осей - пересчёт единиц без деления на 0
+constexpr bool axisModelValid(uint8_t id = 0) {
+  return id >= AXIS_COUNT ||
+         (axisModel[id].stepsPerUnit > 0 && axisModel[id].stepsPerRevolution > 0 && axisModelValid(id + 1));
+}
+static_assert(axisModelValid(), "Шагов на единицу и на оборот оси должно быть больше 0");
+
+// Поля оси константами этапа компиляции
+template <uint8_t ID>
+struct Axis {
+  static_assert(ID < AXIS_COUNT, "Нет оси с таким номером");
+
+  static constexpr uint8_t stepPin() { return axisModel[ID].stepPin; }
+  static constexpr uint8_t dirPin() { return axisModel[ID].dirPin; }
+  static constexpr uint8_t enablePin() { return axisModel[ID].enablePin; }
+  static constexpr uint8_t endstopPin() { return axisModel[ID].endstopPin; }
+  static constexpr uint16_t stepsPerRevolution() { return axisModel[ID].stepsPerRevolution; }
+  static constexpr uint16_t maxSpeed() { return axisModel[ID].maxSpeed; }
+  static constexpr uint16_t acceleration() { return axisModel[ID].acceleration; }
+  static constexpr bool endstopNPN() { return axisModel[ID].endstopNPN; }
+
+  static constexpr int32_t toSteps(float units) { return units * axisModel[ID].stepsPerUnit; }
+  static constexpr float toUnits(int32_t steps) { return (float)steps / axisModel[ID].stepsPerUnit; }
+
+  // Датчик сработал при уровне пина level: NPN замыкает на землю
+  static constexpr bool endstopTriggered(uint8_t level) { return (level == HIGH) != axisModel[ID].endstopNPN; }
+};
+
+#endif // AXIS_MODEL_H
@@ -0,0 +1,45 @@
+#ifndef AXIS_TUNE_H
+#define AXIS_TUNE_H
+
+#include <stdint.h>
+#include "config.h"
+#include "stepper_control.h"
+
+// ============== ПОДБОР ПРЕДЕЛОВ ОСИ ==============
+// Ось обнуляется, затем для каждого уровня делает TUNE_CYCLES ходов между 1 и distance
+// и снова обнуляется: смещение датчика от прежнего нуля (getHomingDrift) больше
+// TUNE_TOLERANCE_STEPS - шаги потеряны. Сначала растёт ускорение на скорости оси,
+// затем скорость на найденном ускорении; скорость не выше того, что даёт таблица разгона.
+// Каждый уровень выводится строкой "TUNE <ось> accel=<a> speed=<v> drift=<d> ok|lost".
+// Пределы хранятся в EEPROM с TUNE_EEPROM_BASE: магический байт, скорость и ускорение
+// каждой оси (0 - config.h), CRC16 (_crc_ccitt_update)
+
+// Загрузка пределов из EEPROM и передача их движку (после initializeStepEngine)
+void initializeAxisTune();
+
+// Запуск подбора. save - записать найденные пределы в EEPROM и применить.
+// false - уже идёт подбор, ось занята или ход меньше двух шагов.
+// notify = true: по окончании "COMPLETED tune" или "ERR: <код> tune"
+bool startAxisTune(StepperType type, long distance, bool save, bool notify);
+
+// Переход по уровням - вызывать из loop()
+void serviceAxisTune();
+
+// Блокирующее ожидание окончания подбора (задания движения продолжают обслуживаться)
+bool waitAxisTune();
+
+// Прерывание подбора: ось останавливается, пределы не меняются
+void abortAxisTune();
+
+bool isAxisTuneActive();
+const char* getLastAxisTuneError();
+
+// Результат последнего подбора: наибольшие скорость и ускорение без потери шагов
+uint16_t getTunedSpeed();
+uint16_t getTunedAcceleration();
+
+// Запись пределов всех осей в EEPROM и сброс к config.h (EEPROM очищается)
+void saveAxisLimits();
+void clearAxisLimits();
+
+#endif // AXIS_TUNE_H
@@ -0,0 +1,67 @@
+#ifndef BINARY_PROTOCOL_H
+#define BINARY_PROTOCOL_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== ДВОИЧНЫЙ ПРОТОКОЛ ==============
+// Запрос: 0xA5 LEN SEQ OP AXIS [ARG0..ARG3: int32 LE] CRC16
+// Ответ:  0xA5 LEN SEQ STATUS OP [данные] CRC16
+// LEN - число байт от SEQ до конца данных, CRC16 (LE) считается по LEN..данные,
+// алгоритм _crc_ccitt_update из avr-libc: полином 0x8408 (отражённый), начальное значение 0xFFFF.
+// Команда движения отвечает ACK сразу и DONE/ERR с тем же SEQ по завершении задания.
+#define BIN_SYNC 0xA5
+#define BIN_MAX_ARGS 4
+#define BIN_MAX_PAYLOAD (BIN_MAX_ARGS * 4)
+#define BIN_BYTE_TIMEOUT_MS 50   // пауза внутри кадра - кадр отбрасывается
+#define BIN_PROTOCOL_VERSION 1
+
+// Коды операций
+#define BIN_OP_PING 0x01         // DONE [версия протокола]
+#define BIN_OP_MOVE 0x10         // AXIS, ARG0 = позиция
+#define BIN_OP_HOME 0x11         // AXIS
+#define BIN_OP_HOME_MASK 0x12    // ARG0 = маска STEP_ENGINE_AXIS_BIT
+#define BIN_OP_CLAMP 0x13        // ARG0 = позиция E0/E1
+#define BIN_OP_CLAMP_ZERO 0x14
+#define BIN_OP_STOP 0x15         // ARG0 = маска осей, 0 - все
+#define BIN_OP_POSITION 0x20     // AXIS -> DONE [позиция]
+#define BIN_OP_STATUS 0x21       // DONE [маска занятых осей, маска обнулённых осей]
+#define BIN_OP_WEIGHT 0x22       // DONE [вес * 100]
+#define BIN_OP_TELEMETRY 0x23    // ARG0 = частота кадров телеметрии, Гц (0 - выключить)
+#define BIN_OP_OUTPUT 0x30       // AXIS = выход (0 насос, 1 KL1, 2 KL2), ARG0 = 0/1
+#define BIN_OP_RECIPE_STEP 0x40  // AXIS = номер шага (0 очищает буфер), ARG0 = код RecipeOp | arg << 8, ARG1 = value
+#define BIN_OP_RECIPE_SAVE 0x41  // AXIS = слот EEPROM
+#define BIN_OP_RECIPE_RUN 0x42   // AXIS = слот (RECIPE_RAM_ID - буфер); EVENT [число шагов] после каждого шага,
+                                 // DONE или ERR [код, номер шага] по завершении
+#define BIN_OP_RECIPE_STOP 0x43
+#define BIN_OP_TEXT_MODE 0x7F    // DONE и возврат к текстовым командам
+
+// Статус ответа
+#define BIN_STATUS_ACK 0x00      // команда принята, задание запущено
+#define BIN_STATUS_DONE 0x01     // команда выполнена
+#define BIN_STATUS_ERR 0x02      // данные: код ошибки (1 байт)
+#define BIN_STATUS_NAK 0x03      // кадр повреждён, данные: BIN_ERR_CRC; SEQ может быть неверным
+#define BIN_STATUS_EVENT 0x04    // кадр по инициативе контроллера (телеметрия), SEQ - свой счётчик
+
+// Коды ошибок
+#define BIN_ERR_BUSY 0x01
+#define BIN_ERR_PARAM 0x02
+#define BIN_ERR_UNKNOWN_OP 0x03
+#define BIN_ERR_CRC 0x04
+#define BIN_ERR_FAILED 0x05
+#define BIN_ERR_ABORTED 0x06
+
+// Переход в двоичный режим (команда "binary"); выход - BIN_OP_TEXT_MODE
+void enterBinaryMode();
+bool isBinaryMode();
+
+// Кадр-событие: 0xA5 LEN SEQ BIN_STATUS_EVENT OP данные CRC16
+void sendBinaryEvent(uint8_t seq, uint8_t op, const uint8_t* payload, uint8_t length);
+
+// Разбор входящих кадров и ответы о завершении заданий - вызывать из loop()
+void serviceBinaryProtocol();
+
+// Статическое ОЗУ протокола: буфер принимаемого кадра и ожидающие ответы, байт
+uint16_t getBinaryProtocolMemory();
+
+#endif // BINARY_PROTOCOL_H
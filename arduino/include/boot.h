@@ -0,0 +1,43 @@
+#ifndef BOOT_H
+#define BOOT_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== КАЛИБРОВКА ВЕСОВ ==============
+// Запись EEPROM с WEIGHT_CAL_EEPROM_BASE: магический байт, коэффициент (float), тара (int32),
+// CRC16 LE по ним (_crc_ccitt_update). Пишется командами calibrate_weight и calibrate_weight_factor
+
+// Коэффициент и тара из EEPROM в scale. false - записи нет или она повреждена:
+// установлен WEIGHT_SCALE_FACTOR, тару снимет самопроверка
+bool loadWeightCalibration();
+
+// Запись текущих коэффициента и тары scale
+void saveWeightCalibration();
+
+// true - коэффициент и тара записаны в EEPROM (при старте или после калибровки)
+bool isWeightCalibrationStored();
+
+// ============== САМОПРОВЕРКА ==============
+typedef enum {
+  SELFTEST_PENDING,
+  SELFTEST_OK,
+  SELFTEST_FAILED
+} SelfTestState;
+
+// Проверка датчика веса в фоне: SELFTEST_WEIGHT_SAMPLES новых отсчётов за SELFTEST_TIMEOUT_MS.
+// Без записи калибровки по ним снимается тара. По окончании - строка printSelfTest()
+void startSelfTest();
+
+// Продвижение проверки - вызывать из loop()
+void serviceSelfTest();
+
+// Блокирующее ожидание окончания (старт с FAST_BOOT false), true - датчик ответил
+bool waitSelfTest();
+
+SelfTestState getSelfTestState();
+
+// "SELFTEST weight=<pending|ok|fail> calibration=<eeprom|default>"
+void printSelfTest();
+
+#endif // BOOT_H
@@ -5,8 +5,12 @@
 #include <NBHX711.h>
 #include "config.h"
 #include "stepper_control.h"
+#include "step_engine.h"
+#include "motion_jobs.h"
 #include "sensors.h"
 #include "valves.h"
+#include "dosing.h"
+#include "recipe.h"
 #include <stdint.h>
 
 // Объявление внешних переменных
@@ -46,6 +50,10 @@ extern NBHX711 scale;
 #define MSG_INVALID_PARAMETER "ERR_INVALID_PARAMETER"
 #endif
 
+#ifndef MSG_WEIGHT_SENSOR
+#define MSG_WEIGHT_SENSOR "ERR_WEIGHT_SENSOR"
+#endif
+
 // Настройка обработчиков команд
 void setupCommandHandlers();
 
@@ -64,6 +72,10 @@ void handleUnrecognized(const char* command);
 // Тестовая функция для проверки связи
 void testCommand();
 
+// Список команд (help; при FAST_BOOT false выводится и при старте)
+void printHelp();
+void handleHelp();
+
 // Обработчики команд движения
 void handleMoveMulti();
 void handleMoveMultizone();
@@ -83,6 +95,8 @@ void handleZeroMultizone();
 void handleZeroRRight();
 void handleZeroE0();
 void handleZeroE1();
+void handleZeroAll();
+void handleZeroMask();
 
 // Обработчики команд насоса
 void handlePumpOn();
@@ -95,6 +109,7 @@ void handleKl1On();
 void handleKl2On();
 void handleKl1Off();
 void handleKl2Off();
+void handlePulse();
 
 // Обработчики команд датчиков
 void handleWeight();
@@ -102,6 +117,16 @@ void handleRawWeight();
 void handleWeightDebug();
 void handleCalibrateWeight();
 void handleCalibrateWeightFactor();
+void handleSelfTest();
+void handleWeightFilter();
+void handleWeightOutlier();
+void handleWeightReportOn();
+void handleWeightReportOff();
+void handleTelemetry();
+
+// Обработчики команд дозирования
+void handleDose();
+void handleDoseStop();
 void handleStateRotor();
 void handleWaste();
 
@@ -111,15 +136,36 @@ void handleCheckMultizoneEndstop();
 void handleCheckRRightEndstop();
 void handleCheckAllEndstops();
 void handleCheckEnablePins();
+void handleEngineStats();
+void handlePerf();
+void handleMem();
+
+// Обработчики асинхронного режима движения
+void handleAsyncOn();
+void handleAsyncOff();
+void handleJobs();
+void handleBinaryMode();
+
+// Обработчики команд рецептов
+void handleRecipeNew();
+void handleRecipeAdd();
+void handleRecipeSave();
+void handleRecipeList();
+void handleRunRecipe();
+void handleStopRecipe();
+
+// Обработчики подбора пределов осей
+void handleTune();
+void handleTuneStop();
+void handleTuneLimits();
 
 // Обработчики команд clamp
 void handleClamp();
 void handleClampZero();
 
-// Обработчики команд для роторов
-void handleRotorForward();
-void handleRotorReverse();
-void handleRotorStop();
+// Обработчики команд перемешивания
+void handleAgitate();
+void handleAgitateStop();
 
 // Обработчик команд для весов
 void handleGetWeight();
@@ -54,44 +54,157 @@
 
 // Stepper Multi (X) Configuration
 #define MULTI_STEPS_PER_REVOLUTION 200    // шагов на оборот
+#define MULTI_STEPS_PER_UNIT 40           // шагов на единицу хода (мм, градус)
 #define MULTI_MAX_SPEED 6000               // steps/sec
 #define MULTI_ACCELERATION 5000           // steps/sec^2
+#define MULTI_JERK 0                      // steps/sec^3, рывок S-кривой разгона (0 - трапеция)
 #define MULTI_HOMING_SPEED 6000            // steps/sec для хоминга (увеличено)
+#define MULTI_HOMING_FAST_SPEED 6000       // steps/sec быстрый поиск датчика
+#define MULTI_HOMING_LATCH_SPEED 600       // steps/sec медленный повторный подход
+#define MULTI_HOMING_LATCH_DISTANCE 200    // шагов отъезда перед повторным подходом (0 - без него)
 #define MULTI_ENDSTOP_TYPE_NPN false       // true = NPN, false = PNP
 #define MULTI_POWER_ALWAYS_ON true         // true = питание постоянно, false = только при движении
 
 // Stepper Multizone (Y) Configuration
 #define MULTIZONE_STEPS_PER_REVOLUTION 200  // шагов на оборот
+#define MULTIZONE_STEPS_PER_UNIT 80         // шагов на единицу хода (мм, градус)
 #define MULTIZONE_MAX_SPEED 600             // steps/sec
 #define MULTIZONE_ACCELERATION 800          // steps/sec^2
+#define MULTIZONE_JERK 8000                 // steps/sec^3, рывок S-кривой разгона (0 - трапеция)
 #define MULTIZONE_HOMING_SPEED 400          // steps/sec для хоминга (увеличено)
+#define MULTIZONE_HOMING_FAST_SPEED 600     // steps/sec быстрый поиск датчика
+#define MULTIZONE_HOMING_LATCH_SPEED 200    // steps/sec медленный повторный подход
+#define MULTIZONE_HOMING_LATCH_DISTANCE 100 // шагов отъезда перед повторным подходом (0 - без него)
 #define MULTIZONE_ENDSTOP_TYPE_NPN true     // true = NPN, false = PNP
 #define MULTIZONE_POWER_ALWAYS_ON true      // true = питание постоянно, false = только при движении
 
 // Stepper RRight (Z) Configuration
 #define RRIGHT_STEPS_PER_REVOLUTION 200     // шагов на оборот
+#define RRIGHT_STEPS_PER_UNIT 200           // шагов на единицу хода (мм, градус)
 #define RRIGHT_MAX_SPEED 30000                // steps/sec (временно увеличено для диагностики)
 #define RRIGHT_ACCELERATION 2000             // steps/sec^2 (временно увеличено для диагностики)
+#define RRIGHT_JERK 0                        // steps/sec^3, рывок S-кривой разгона (0 - трапеция)
 #define RRIGHT_HOMING_SPEED 2000             // steps/sec для хоминга (увеличено)
+#define RRIGHT_HOMING_FAST_SPEED 6000        // steps/sec быстрый поиск датчика
+#define RRIGHT_HOMING_LATCH_SPEED 1000       // steps/sec медленный повторный подход
+#define RRIGHT_HOMING_LATCH_DISTANCE 200     // шагов отъезда перед повторным подходом (0 - без него)
 #define RRIGHT_ENDSTOP_TYPE_NPN true        // true = NPN, false = PNP
 #define RRIGHT_POWER_ALWAYS_ON true         // true = питание постоянно, false = только при движении
 
 // Stepper E0 Configuration
 #define E0_STEPS_PER_REVOLUTION 200         // шагов на оборот
+#define E0_STEPS_PER_UNIT 200               // шагов на единицу хода (мм, градус)
 #define E0_MAX_SPEED 2000                   // steps/sec
 #define E0_ACCELERATION 2000                // steps/sec^2
+#define E0_JERK 0                           // steps/sec^3, рывок S-кривой разгона (0 - трапеция)
 #define E0_HOMING_SPEED 1000                // steps/sec для хоминга (если будет использоваться)
+#define E0_HOMING_FAST_SPEED 2000           // steps/sec быстрый поиск датчика
+#define E0_HOMING_LATCH_SPEED 500           // steps/sec медленный повторный подход
+#define E0_HOMING_LATCH_DISTANCE 100        // шагов отъезда перед повторным подходом (0 - без него)
 #define E0_ENDSTOP_TYPE_NPN true            // true = NPN, false = PNP (для clamp_zero датчика)
 #define E0_POWER_ALWAYS_ON true            // ВРЕМЕННО true для диагностики
 
 // Stepper E1 Configuration
 #define E1_STEPS_PER_REVOLUTION 200         // шагов на оборот
+#define E1_STEPS_PER_UNIT 200               // шагов на единицу хода (мм, градус)
 #define E1_MAX_SPEED 2000                   // steps/sec
 #define E1_ACCELERATION 2000                // steps/sec^2
+#define E1_JERK 0                           // steps/sec^3, рывок S-кривой разгона (0 - трапеция)
 #define E1_HOMING_SPEED 1000                // steps/sec для хоминга (если будет использоваться)
+#define E1_HOMING_FAST_SPEED 2000           // steps/sec быстрый поиск датчика
+#define E1_HOMING_LATCH_SPEED 500           // steps/sec медленный повторный подход
+#define E1_HOMING_LATCH_DISTANCE 100        // шагов отъезда перед повторным подходом (0 - без него)
 #define E1_ENDSTOP_TYPE_NPN true            // true = NPN, false = PNP (для clamp_zero датчика)
 #define E1_POWER_ALWAYS_ON true            // ВРЕМЕННО true для диагностики
 
+// ============== ENDSTOP LATCH ==============
+// true - концевики фиксируются по прерыванию (позиция шага запоминается в ISR), false - опрос digitalRead
+#define ENDSTOP_INTERRUPT_LATCH true
+
+// ============== STEP ENGINE ==============
+// true - одиночные оси разгоняются по таблицам accel_profile.h, рассчитанным при компиляции,
+// false - профиль GStepper2 (sqrt и деление при каждой смене скорости и на каждом шаге, *_JERK не действует)
+#define STEP_ENGINE_TABLE_PROFILE true
+// true - шаги одиночных осей (при STEP_ENGINE_TABLE_PROFILE) выдаются прямой записью в порт STEP:
+// фронт в начале прерывания, спад после расчёта следующего шага вместо delayMicroseconds(DRIVER_STEP_TIME)
+#define STEP_ENGINE_FAST_PULSE true
+#define STEP_ENGINE_PULSE_US 2                // минимальная длительность импульса STEP для драйвера
+#define STEP_ENGINE_MAX_EVENTS 8              // событий выходов на одно движение оси (8 байт ОЗУ на событие)
+#define CLAMP_PLANNER_BUFFER 4                // точек в буфере GPlanner2 пары E0/E1 (15 байт ОЗУ на точку)
+
+// ============== WEIGHT SAMPLER ==============
+// true - HX711 опрашивается в фоне прерыванием Timer2 (у пина DT нет PCINT), false - из loop()
+#define WEIGHT_SAMPLER_TIMER2 true
+#define WEIGHT_SAMPLER_POLL_HZ 1000        // частота проверки готовности DT (HX711 выдаёт 10/80 SPS)
+#define WEIGHT_SAMPLE_STALE_MS 500         // отсчёт старше - предупреждение в weight
+#define WEIGHT_HISTORY_DEPTH 16            // история NBHX711, отсчётов (статический буфер, 4 байта на отсчёт)
+
+// Фильтр веса по умолчанию (NBHX711.h): FilterMean, FilterMedian или FilterIIR
+#define WEIGHT_FILTER_MODE FilterMean
+#define WEIGHT_FILTER_IIR_SHIFT 3          // вес нового отсчёта в FilterIIR: 1/2^shift
+#define WEIGHT_OUTLIER_LIMIT 0             // скачок больше (сырых единиц) отбрасывается, 0 - выключено
+
+// ============== FAST BOOT ==============
+// true - setup() без паузы и справки (help - по запросу), тара и коэффициент весов из EEPROM,
+// самопроверка датчика веса в фоне после "СИСТЕМА ГОТОВА"; false - прежний старт с ожиданием датчика
+#define FAST_BOOT true
+#define WEIGHT_SCALE_FACTOR 2230.0         // коэффициент весов, пока калибровка не записана в EEPROM
+#define WEIGHT_CAL_EEPROM_BASE 0           // коэффициент и тара весов (11 байт), до TUNE_EEPROM_BASE
+#define SELFTEST_WEIGHT_SAMPLES 10         // новых отсчётов HX711 для проверки датчика (и тары без записи)
+#define SELFTEST_TIMEOUT_MS 2000           // датчик не выдал их за это время - ошибка самопроверки
+
+// ============== VALVE SCHEDULER ==============
+// true - импульсы клапанов и насоса по прерыванию сравнения Timer0 A (~1 кГц, рядом с millis()),
+// false - из loop(). analogWrite на пине 13 (OC0A) несовместим с режимом Timer0
+#define VALVE_SCHEDULER_TIMER0 true
+#define VALVE_PULSE_SLOTS 4                // одновременных расписаний (KL1, KL2, насос и запас)
+#define VALVE_PULSE_MAX_MS 60000           // максимальная длительность одного импульса
+
+// ============== DOSING ==============
+#define DOSE_MAX_GRAMS 5000                // максимальная доза одной команды
+#define DOSE_TIMEOUT_MS 120000             // отсечка, если цель не достигнута
+#define DOSE_SETTLE_MS 1500                // успокоение весов после отсечки перед итоговым взвешиванием
+#define DOSE_INFLIGHT_MS 300               // начальная оценка массы "в полёте": столько мс текущего расхода
+#define DOSE_INFLIGHT_MAX_MS 3000          // предел подстройки оценки по результатам доз
+#define DOSE_RATE_SHIFT 2                  // сглаживание расхода: вес нового измерения 1/2^shift
+
+// ============== TELEMETRY ==============
+#define TELEMETRY_MAX_HZ 50                // предел частоты telemetry <hz> (115200 бод)
+
+// ============== RECIPES ==============
+#define RECIPE_MAX_STEPS 32                // шагов в рецепте (буфер ОЗУ 6 байт на шаг)
+#define RECIPE_SLOTS 8                     // рецептов в EEPROM
+#define RECIPE_EEPROM_BASE 64              // начало слотов рецептов, адреса ниже - под настройки
+#define RECIPE_WAIT_TIMEOUT_MS 120000      // предел шага wait_weight
+
+// ============== AXIS TUNE ==============
+// tune <ось> <ход>: ходы туда-обратно на растущих ускорении, затем скорости (в % от config.h),
+// после каждого уровня хоминг и сверка точки срабатывания датчика с ожидаемой
+#define TUNE_CYCLES 3                      // ходов туда-обратно на уровень
+#define TUNE_START_PCT 50                  // первый уровень, % от скорости/ускорения оси
+#define TUNE_STEP_PCT 25                   // прирост уровня
+#define TUNE_MAX_PCT 300                   // последний уровень
+#define TUNE_TOLERANCE_STEPS 2             // смещение датчика в пределах повторяемости - шаги не потеряны
+#define TUNE_EEPROM_BASE 32                // пределы осей после tune ... save (23 байта), до RECIPE_EEPROM_BASE
+
+// ============== COMMAND BATCH ==============
+// Строка "cmd1 a; cmd2; cmd3 b" выполняется по шагам с одним ответом.
+// Длина строки - SERIALCOMMAND_BUFFER (lib/SerialCommand, 128 символов)
+#define COMMAND_BATCH_MAX_STEPS 16         // шагов в одной строке
+#define COMMAND_BATCH_SEPARATOR ';'
+
+// ============== PERF ==============
+// Счётчики времени для команды perf; false - замеры не компилируются
+#define PERF_ENABLED true
+#define PERF_STACK_PAINT 0xA5              // заполнение свободного ОЗУ для минимального запаса стека
+#define PERF_STACK_GUARD 64                // байт под текущим указателем стека, которые не размечаются
+
+// ============== LOG ==============
+// Уровень диагностики: 0 - нет, 1 - ошибки, 2 - предупреждения, 3 - ход выполнения, 4 - отладка
+// (прогресс движения и хоминга). Сообщения выше уровня не компилируются
+#define LOG_LEVEL 3
+#define LOG_QUEUE_SIZE 256                 // очередь сообщений перед Serial, байт (степень двойки, до 256)
+
 // ============== LEGACY CONSTANTS (для обратной совместимости) ==============
 const int HOMING_SPEED = 300;               // Общий хоминг (устарело, используйте индивидуальные настройки)
 const int HOMING_TIMEOUT = 30000;           // ms - увеличен для более медленных двигателей
@@ -109,5 +222,23 @@ const int CLAMP_ACCELERATION = 2000;        // steps/sec^2 для функций
 #define MSG_INVALID_VALUE "INVALID VALUE"
 #define MSG_MISSING_PARAMETER "MISSING PARAMETER"
 #define MSG_INVALID_PARAMETER "INVALID PARAMETER"
+#define MSG_AXIS_BUSY "AXIS BUSY"
+#define MSG_JOB_ABORTED "ABORTED"
+// Коды отказа движения из первых версий протокола - с подчёркиванием, хост сверяет их как есть
+#define MSG_MOVE_FAILED "MOVE_FAILED"
+#define MSG_CLAMP_FAILED "CLAMP_FAILED"
+#define MSG_CLAMP_ZERO_FAILED "CLAMP_ZERO_FAILED"
+#define MSG_AGITATE_FAILED "AGITATE FAILED"
+#define MSG_DOSE_BUSY "DOSE BUSY"
+#define MSG_DOSE_TIMEOUT "DOSE TIMEOUT"
+#define MSG_DOSE_SENSOR "DOSE SENSOR"
+#define MSG_RECIPE_BUSY "RECIPE BUSY"
+#define MSG_RECIPE_EMPTY "RECIPE EMPTY"
+#define MSG_RECIPE_STEP "STEP FAILED"
+#define MSG_RECIPE_TIMEOUT "RECIPE TIMEOUT"
+#define MSG_TUNE_FAILED "TUNE FAILED"
+#define MSG_UNKNOWN_COMMAND "UNKNOWN COMMAND"
+#define MSG_LINE_TOO_LONG "LINE TOO LONG"
+#define MSG_BATCH_TOO_LONG "BATCH TOO LONG"
 
 #endif // CONFIG_H 
\ No newline at end of file
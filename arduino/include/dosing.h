@@ -0,0 +1,38 @@
+#ifndef DOSING_H
+#define DOSING_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Исполнительные устройства дозирования
+typedef enum {
+  DOSE_PUMP,
+  DOSE_KL1,
+  DOSE_KL2,
+  DOSE_ACTUATOR_COUNT
+} DoseActuator;
+
+// Подключение к отсчётам weight_sampler
+void initializeDosing();
+
+// Дозирование grams граммов: устройство включается и выключается по весу с упреждением
+// на массу "в полёте". false - дозирование уже идёт, датчик веса не отвечает или параметры недопустимы.
+// notify = true: по окончании "COMPLETED dose" или "ERR: <код> dose"
+bool startDose(float grams, DoseActuator actuator, bool notify);
+
+// Обслуживание дозирования (таймаут, итоговое взвешивание) - вызывать из loop()
+void serviceDosing();
+
+// Блокирующее ожидание окончания дозирования (задания движения продолжают обслуживаться)
+bool waitDose();
+
+// Прерывание дозирования с выключением устройства
+void abortDose();
+
+bool isDoseActive();
+
+// Итог последней дозы, г, и код ошибки (nullptr - успешно)
+float getLastDoseGrams();
+const char* getLastDoseError();
+
+#endif // DOSING_H
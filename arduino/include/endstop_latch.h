@@ -0,0 +1,27 @@
+#ifndef ENDSTOP_LATCH_H
+#define ENDSTOP_LATCH_H
+
+#include <stdint.h>
+#include "config.h"
+#include "stepper_control.h"
+
+// Максимум датчиков с фиксацией: концевики Multi/Multizone/RRight и датчик clamp (общие пины объединяются)
+#define ENDSTOP_LATCH_SOURCES 4
+
+// Настройка прерываний датчиков (INT на пине 2, PCINT1 на пинах 14/15)
+void initializeEndstopLatches();
+
+// Взвод фиксации: при срабатывании датчика ISR запоминает pos осей из маски и останавливает их.
+// false - фиксация выключена, у пина нет прерывания или датчик уже взведён другой осью
+bool endstopLatchArm(int pin, bool isNPN, uint8_t axisMask);
+
+// Снятие фиксации с датчика
+void endstopLatchDisarm(int pin);
+
+// true - датчик сработал после взвода
+bool endstopLatchFired(int pin);
+
+// Позиция оси в момент срабатывания датчика
+long endstopLatchPosition(StepperType type);
+
+#endif // ENDSTOP_LATCH_H
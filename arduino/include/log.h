@@ -0,0 +1,68 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <Arduino.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============== ДИАГНОСТИЧЕСКИЕ СООБЩЕНИЯ ==============
+// Ответы протокола (RECEIVED / COMPLETED / ERROR, события, данные запросов) пишутся в Serial
+// напрямую. Пояснения к ходу выполнения идут через Log: строка копится в очереди и уходит
+// из serviceLog() целиком, когда в буфере передачи есть место, поэтому print() не ждёт UART.
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+// Аргумент - один или несколько операторов с Log.print(); выше LOG_LEVEL удаляются целиком
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) do { __VA_ARGS__; } while (0)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) do { __VA_ARGS__; } while (0)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) do { __VA_ARGS__; } while (0)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) do { __VA_ARGS__; } while (0)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+// Очередь строк перед Serial. Строка, не поместившаяся в очередь, отбрасывается целиком
+class LogQueue : public Print {
+ public:
+  size_t write(uint8_t value) override;
+  using Print::write;
+};
+
+extern LogQueue Log;
+
+// Передача накопленных строк - вызывать из loop()
+void serviceLog();
+
+// Передача всей очереди с ожиданием UART - для setup(), пока loop() ещё не крутит serviceLog()
+void flushLog();
+
+// Двоичный режим: очередь очищается, новые строки отбрасываются, чтобы не рвать кадры
+void setLogMuted(bool muted);
+
+// Байт в очереди и строк, отброшенных из-за переполнения
+uint16_t getLogQueued();
+uint16_t getLogDropped();
+
+// Статическое ОЗУ очереди, байт
+uint16_t getLogMemory();
+
+#endif // LOG_H
@@ -0,0 +1,91 @@
+#ifndef MOTION_JOBS_H
+#define MOTION_JOBS_H
+
+#include <stdint.h>
+#include "config.h"
+#include "stepper_control.h"
+#include "step_engine.h"
+
+// Виды заданий движения
+typedef enum {
+  JOB_NONE,
+  JOB_MOVE,
+  JOB_HOME,
+  JOB_CLAMP,
+  JOB_CLAMP_ZERO,
+  JOB_AGITATE
+} MotionJobKind;
+
+// Результат последнего задания оси
+typedef enum {
+  JOB_RESULT_NONE,
+  JOB_RESULT_OK,
+  JOB_RESULT_FAILED,
+  JOB_RESULT_ABORTED
+} MotionJobResult;
+
+// Задание выполняется в слоте основной оси; clamp/clamp_zero занимают слот E0 и блокируют E1
+void initializeMotionJobs();
+
+// Запуск заданий. false - ось занята другим заданием или параметры недопустимы.
+// notify = true: по окончании задание само выведет "COMPLETED <ось>" или "ERROR: <код> <ось>"
+bool startMoveJob(StepperType type, long position, bool notify);
+// Движение с событиями выходов по шагам (step_engine.h): насос и клапаны переключаются на ходу
+bool startMoveJob(StepperType type, long position, bool notify, const StepEngineEvent* events, uint8_t eventCount);
+bool startHomeJob(StepperType type, bool notify);   // конфигурация из таблицы описаний осей
+bool startHomeJob(StepperType type, const StepperConfig& config, bool notify);
+bool startClampJob(long position, bool notify);
+bool startClampZeroJob(bool notify);
+
+// Перемешивание оси на скорости |speed| (не выше предела оси), ровно одно из cycles/duration (мс).
+// amplitude != 0 - ходы от текущей позиции на amplitude и обратно, цикл - ход туда и обратно;
+// по времени начатый цикл доводится, ось всегда возвращается в исходную позицию.
+// amplitude = 0 - вращение в сторону знака speed: cycles оборотов (stepsPerRevolution)
+// или до истечения времени с торможением
+bool startAgitateJob(StepperType type, long amplitude, int speed, uint16_t cycles, unsigned long duration, bool notify);
+// Плавное завершение перемешивания: ходы - после текущего цикла, вращение - торможением
+void stopAgitateJob(StepperType type);
+// Циклы текущего или последнего перемешивания оси (при вращении - полные обороты)
+uint16_t getAgitateCycles(StepperType type);
+
+// Одновременный хоминг осей из маски STEP_ENGINE_AXIS_BIT.
+// Оси с общим датчиком обнуляются по очереди, E0+E1 вместе - процедурой clamp_zero.
+// notify = true: по окончании "COMPLETED zero" или "ERROR: <код> <маска неудачных осей> zero"
+bool startHomingBatch(uint8_t axisMask, bool notify);
+bool waitHomingBatch();
+bool isHomingBatchActive();
+uint8_t getHomingBatchFailed();
+
+// true - ось обнулена по датчику с момента включения
+bool isAxisHomed(StepperType type);
+
+// Смещение точки срабатывания датчика при последнем хоминге оси относительно нуля
+// предыдущего хоминга, шагов: потерянные между ними шаги. false - ось до этого не была обнулена
+bool getHomingDrift(StepperType type, long& drift);
+
+// Обслуживание всех активных заданий - вызывать из loop() как можно чаще
+void serviceMotionJobs();
+
+// Блокирующее ожидание задания в слоте оси (остальные задания продолжают обслуживаться)
+bool waitMotionJob(StepperType type);
+
+// Прерывание заданий, затрагивающих оси из маски STEP_ENGINE_AXIS_BIT
+void abortMotionJobs(uint8_t axisMask);
+
+// Состояние заданий
+bool isMotionJobActive(StepperType type);
+bool isAxisBusy(StepperType type);
+MotionJobKind getMotionJobKind(StepperType type);
+MotionJobResult getMotionJobResult(StepperType type);
+
+// Имя оси/задания для событий ("multi", "multizone", "rright", "e0", "e1", "clamp")
+const __FlashStringHelper* getMotionJobName(StepperType type);
+
+// Асинхронный режим команд движения (по умолчанию выключен - команды блокирующие)
+void setAsyncMode(bool enabled);
+bool isAsyncMode();
+
+// Статическое ОЗУ заданий: слоты осей, пакет хоминга, признаки и смещения хоминга, байт
+uint16_t getMotionJobsMemory();
+
+#endif // MOTION_JOBS_H
@@ -0,0 +1,57 @@
+#ifndef PERF_H
+#define PERF_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== СЧЁТЧИКИ ВРЕМЕНИ ==============
+// Время обработчиков шагов по осям - в StepEngineStats (step_engine.h), здесь - остальные участки
+typedef enum {
+  PERF_LOOP,         // период основного цикла loop()
+  PERF_COMMAND,      // разбор текстовой команды: от вызова readSerial() до входа в обработчик
+  PERF_HX711,        // чтение 24 бит HX711
+  PERF_PLANNER,      // checkBuffer() планировщика пары E0/E1 при запуске clamp
+  PERF_COUNTER_COUNT
+} PerfCounterId;
+
+typedef struct {
+  uint32_t count;
+  uint32_t totalUs;
+  uint32_t maxUs;
+} PerfCounter;
+
+#if PERF_ENABLED
+// Разметка свободного ОЗУ для getMinFreeMemory() - вызывать в начале setup()
+void initializePerf();
+
+// Учёт длительности участка; можно вызывать из прерывания
+void perfRecord(PerfCounterId id, uint32_t us);
+
+// Отметки основного цикла и разбора команд
+void perfLoopTick();
+void perfCommandStart();
+void perfCommandDispatched();
+
+void perfGetCounter(PerfCounterId id, PerfCounter* counter);
+void perfReset();
+
+// Свободное ОЗУ между кучей и стеком сейчас и минимальное с момента initializePerf()
+uint16_t getFreeMemory();
+uint16_t getMinFreeMemory();
+
+// Статическое ОЗУ (.data + .bss, от __data_start до __heap_start) и занятая куча, байт
+uint16_t getStaticMemory();
+uint16_t getHeapMemory();
+
+static inline uint32_t perfNow() { return micros(); }
+#else
+// Без PERF_ENABLED замеры сводятся к пустым вызовам и удаляются компилятором
+static inline void initializePerf() {}
+static inline void perfRecord(PerfCounterId, uint32_t) {}
+static inline void perfLoopTick() {}
+static inline void perfCommandStart() {}
+static inline void perfCommandDispatched() {}
+static inline uint32_t perfNow() { return 0; }
+#endif
+
+#endif // PERF_H
@@ -0,0 +1,78 @@
+#ifndef RECIPE_H
+#define RECIPE_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== РЕЦЕПТЫ ==============
+// Рецепт - последовательность шагов, выполняемая контроллером без участия хоста.
+// Шаги собираются в буфере ОЗУ (recipe_add или BIN_OP_RECIPE_STEP), сохраняются
+// в слот EEPROM и запускаются run_recipe <слот>; run_recipe без номера выполняет буфер.
+// Слот EEPROM: магический байт, число шагов, CRC16 (_crc_ccitt_update), шаги по 6 байт.
+typedef enum {
+  RECIPE_END,           // конец рецепта (в буфере не хранится)
+  RECIPE_MOVE,          // arg = ось StepperType, value = позиция
+  RECIPE_ZERO,          // arg = маска осей STEP_ENGINE_AXIS_BIT
+  RECIPE_CLAMP,         // value = позиция E0/E1
+  RECIPE_CLAMP_ZERO,
+  RECIPE_OUTPUT,        // arg = выход (0 насос, 1 KL1, 2 KL2), value = 0/1
+  RECIPE_PULSE,         // arg = выход, value = длительность импульса, мс
+  RECIPE_DOSE,          // arg = DoseActuator, value = доза, г * 100
+  RECIPE_WAIT_WEIGHT,   // value = вес, г * 100: ждать, пока показания не достигнут его
+  RECIPE_DELAY,         // value = пауза, мс
+  RECIPE_OP_COUNT
+} RecipeOp;
+
+typedef struct {
+  uint8_t op;
+  uint8_t arg;
+  int32_t value;
+} RecipeStep;
+
+// Источник для startRecipe(): буфер ОЗУ вместо слота EEPROM
+#define RECIPE_RAM_ID 0xFF
+
+void initializeRecipes();
+
+// Буфер редактирования. false - буфер выполняется; append - также буфер полон или шаг недопустим
+bool clearRecipeBuffer();
+bool appendRecipeStep(const RecipeStep& step);
+
+// Буфер <-> слот EEPROM. loadRecipe - false, если слот пуст или CRC не совпадает
+bool saveRecipe(uint8_t id);
+bool loadRecipe(uint8_t id);
+
+// Число шагов рецепта id (RECIPE_RAM_ID - буфер), 0 - слот пуст или CRC не совпадает
+uint8_t getRecipeLength(uint8_t id);
+
+// Шаг index рецепта id без проверки CRC, false - шага нет
+bool getRecipeStep(uint8_t id, uint8_t index, RecipeStep& step);
+
+// Имя шага ("move", "zero", ...) и поиск кода по имени, RECIPE_OP_COUNT - не найдено
+const __FlashStringHelper* getRecipeOpName(uint8_t op);
+uint8_t findRecipeOp(const char* name);
+
+// Запуск рецепта. false - уже выполняется другой рецепт или слот пуст/повреждён.
+// Завершение каждого шага выводится строкой "STEP <номер> <имя>" (в текстовом режиме);
+// notify = true: по окончании "COMPLETED recipe" или "ERR: <код> <номер шага> recipe"
+bool startRecipe(uint8_t id, bool notify);
+
+// Переход по шагам - вызывать из loop()
+void serviceRecipe();
+
+// Блокирующее ожидание окончания рецепта (задания и расписания продолжают обслуживаться)
+bool waitRecipe();
+
+// Прерывание рецепта: текущий шаг останавливается, насос и клапаны выключаются
+void abortRecipe();
+
+bool isRecipeActive();
+
+// Число завершённых шагов текущего или последнего рецепта и код ошибки (nullptr - успешно)
+uint8_t getRecipeStepsDone();
+const char* getLastRecipeError();
+
+// Статическое ОЗУ рецептов: буфер RECIPE_MAX_STEPS шагов и текущий шаг, байт
+uint16_t getRecipeMemory();
+
+#endif // RECIPE_H
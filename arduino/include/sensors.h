@@ -7,6 +7,27 @@
 // Инициализация пинов датчиков
 void initializeSensors();
 
+// ============== СНИМОК ВХОДОВ ==============
+// Все датчики за одно чтение регистров PINx: уровни ротора и отходов как у digitalRead,
+// концевики - "сработал" с учётом типа NPN/PNP оси (бит оси StepperType)
+#define SENSOR_BIT_ROTOR(i) ((uint16_t)1 << (i))
+#define SENSOR_BIT_WASTE ((uint16_t)1 << 4)
+#define SENSOR_BIT_ENDSTOP(type) ((uint16_t)1 << (5 + (type)))
+#define SENSOR_ROTOR_MASK 0x000F
+#define SENSOR_ENDSTOP_SHIFT 5
+
+typedef struct {
+  unsigned long timeUs;   // micros() момента чтения
+  uint16_t bits;
+} SensorSnapshot;
+
+SensorSnapshot readSensorSnapshot();
+
+// Маска концевиков снимка: бит i - ось StepperType i
+inline uint8_t sensorEndstopMask(const SensorSnapshot& snapshot) {
+  return (uint8_t)(snapshot.bits >> SENSOR_ENDSTOP_SHIFT);
+}
+
 // Чтение состояния ротора
 void readRotorState(char* stateBuffer);
 
@@ -0,0 +1,107 @@
+#ifndef STEP_ENGINE_H
+#define STEP_ENGINE_H
+
+#include <stdint.h>
+#include <GyverPlanner2.h>
+#include "config.h"
+#include "stepper_control.h"
+
+// ============== ПАРАМЕТРЫ ДВИЖКА ШАГОВ ==============
+// Таймеры 1/3/4/5 работают в нормальном режиме с предделителем 8: 2 тика на мкс
+#define STEP_ENGINE_TICKS_PER_US 2
+// Максимальный интервал одного сравнения (длинные периоды делятся на части).
+// Меньше 0x8000: опережение next - TCNT проверяется как int16 и при быстром входе в прерывание
+// ровно 0x8000 читалось бы как опоздание
+#define STEP_ENGINE_MAX_CHUNK 0x7C00
+// Минимальный запас до следующего сравнения, меньше - шаг считается опоздавшим
+#define STEP_ENGINE_MIN_LEAD_TICKS 16
+// Масштаб периодов таблицы разгона - число с фиксированной точкой, 12 дробных бит
+#define STEP_ENGINE_SCALE_SHIFT 12
+
+#define STEP_ENGINE_AXES 5
+#define STEP_ENGINE_AXIS_BIT(type) (1 << (type))
+
+// Статистика канала движка
+typedef struct {
+  uint32_t steps;          // шагов выполнено с последнего сброса
+  uint32_t minPeriodUs;    // минимальный период шага, выданный без опоздания
+  uint16_t lateSteps;      // шаги, момент которых уже прошёл к моменту планирования
+  uint32_t isrCalls;       // вызовы обработчика прерывания канала (при PERF_ENABLED)
+  uint32_t isrTicks;       // суммарное время в обработчике, тиков таймера
+  uint16_t isrMaxTicks;    // самый долгий вызов обработчика, тиков таймера
+} StepEngineStats;
+
+// Событие движения: на шаге step от начала движения (с 1) выход pin переводится в state.
+// Выход переключается записью в порт из прерывания шага, сразу после изменения pos
+typedef struct {
+  uint32_t step;
+  uint8_t pin;
+  bool state;
+} StepEngineEvent;
+
+// Связанная пара E0/E1: один планировщик, буфер на CLAMP_PLANNER_BUFFER точек (текущая и цель)
+typedef GPlanner2<STEPPER2WIRE, 2, CLAMP_PLANNER_BUFFER> ClampGroupPlanner;
+
+// Инициализация таймеров (вызывать после initializeSteppers)
+void initializeStepEngine();
+
+// Рабочая скорость оси, шаг/сек. Ускорение и рывок заданы таблицей accel_profile.h,
+// скорость выше верхней скорости таблицы оси не поднимается
+void stepEngineSetMaxSpeed(StepperType type, uint16_t speed);
+
+// Ускорение оси, шаг/сек^2. Таблица не пересчитывается: её периоды умножаются на
+// sqrt(ускорение таблицы / acceleration), так что вместе с ускорением в sqrt раз меняется
+// и верхняя скорость таблицы. Без STEP_ENGINE_TABLE_PROFILE - setAcceleration() GStepper2
+void stepEngineSetAcceleration(StepperType type, uint16_t acceleration);
+
+// Наибольшая скорость, которую ось наберёт при текущем ускорении, шаг/сек
+uint16_t stepEngineGetSpeedCeiling(StepperType type);
+
+// Запуск движения к абсолютной позиции из фона; false - движения нет (уже на месте).
+// events (до STEP_ENGINE_MAX_EVENTS, шаги за пределами пути отбрасываются) заменяют события
+// прежнего движения. Если движение прервано раньше, несработавшие выключения выполняются
+// сразу, а включения отменяются - насос и клапаны не остаются открытыми.
+// Новая цель в сторону идущего движения меняет только остаток пути, темп шагов не сбивается
+bool stepEngineMoveTo(StepperType type, long position, const StepEngineEvent* events = nullptr, uint8_t eventCount = 0);
+
+// События текущего движения оси, ещё не сработавшие
+uint8_t stepEngineGetPendingEvents(StepperType type);
+
+// Запуск канала после ручной настройки двигателя (setTarget/setSpeed)
+void stepEngineStart(StepperType type);
+
+// Одновременный запуск нескольких каналов от одного момента таймера (маска STEP_ENGINE_AXIS_BIT)
+void stepEngineStartMask(uint8_t axisMask);
+
+// Немедленная остановка оси (brake) и отключение канала
+void stepEngineStop(StepperType type);
+
+// Остановка осей из маски прямо в прерывании (фиксация концевика).
+// Только из ISR или при запрещённых прерываниях
+void stepEngineHaltFromISR(uint8_t axisMask);
+
+// Связанное движение E0/E1 одним трапецеидальным профилем: обе оси шагает
+// планировщик из прерывания канала E0 (Timer5 A). false - движения нет
+void stepEngineConfigureClampGroup(double maxSpeed, uint16_t acceleration);
+bool stepEngineMoveClampGroup(long e0Target, long e1Target);
+bool stepEngineClampGroupActive();
+
+// Максимальное расхождение E0/E1 относительно общей траектории, шагов:
+// за последнее связанное движение и с последнего сброса статистики
+uint16_t stepEngineGetClampSkew();
+uint16_t stepEngineGetClampSkewMax();
+
+// true, пока ось генерирует шаги
+bool stepEngineIsRunning(StepperType type);
+
+// Атомарное чтение текущей позиции оси
+long stepEngineGetPosition(StepperType type);
+
+// Получение и сброс статистики канала
+void stepEngineGetStats(StepperType type, StepEngineStats* stats);
+void stepEngineResetStats();
+
+// Статическое ОЗУ движка: каналы осей (с событиями) и планировщик пары E0/E1, байт
+uint16_t stepEngineGetMemory();
+
+#endif // STEP_ENGINE_H
@@ -4,14 +4,15 @@
 #include <GyverStepper2.h>
 #include <stdint.h>
 #include "config.h"
+#include "axis_model.h"
 
-// Типы шаговых двигателей
+// Типы шаговых двигателей - номера осей модели axis_model.h
 typedef enum {
-  STEPPER_MULTI,
-  STEPPER_MULTIZONE,
-  STEPPER_RRIGHT,
-  STEPPER_E0,
-  STEPPER_E1
+  STEPPER_MULTI = AXIS_MULTI,
+  STEPPER_MULTIZONE = AXIS_MULTIZONE,
+  STEPPER_RRIGHT = AXIS_RRIGHT,
+  STEPPER_E0 = AXIS_E0,
+  STEPPER_E1 = AXIS_E1
 } StepperType;
 
 // Структура для хранения конфигурации шагового двигателя
@@ -23,10 +24,27 @@ typedef struct {
   int maxSpeed;
   int acceleration;
   int homingSpeed;
+  int homingFastSpeed;        // быстрый поиск датчика
+  int homingLatchSpeed;       // медленный повторный подход
+  int homingLatchDistance;    // отъезд перед повторным подходом, шагов
   bool endstopTypeNPN;
   bool powerAlwaysOn;
 } StepperConfig;
 
+#define STEPPER_AXIS_COUNT AXIS_COUNT
+
+// Наибольшая скорость и ускорение в StepperConfig (поля int)
+#define AXIS_LIMIT_MAX 32767
+
+// Описание оси: двигатель, конфигурация и имена во flash. Таблица описаний лежит в PROGMEM,
+// поля читаются только функциями доступа ниже
+typedef struct {
+  GStepper2<STEPPER2WIRE>* stepper;
+  const char* name;           // имя для сообщений ("Multi")
+  const char* eventName;      // имя в событиях протокола ("multi")
+  StepperConfig config;
+} AxisDescriptor;
+
 // Объявления шаговых двигателей
 extern GStepper2<STEPPER2WIRE> multiStepper;
 extern GStepper2<STEPPER2WIRE> multizoneSteper;
@@ -37,6 +55,8 @@ extern GStepper2<STEPPER2WIRE> e1Stepper;
 // Функции для управления переменной clampInProgress
 void resetClampFlag();
 bool isClampInProgress();
+bool acquireClampFlag();   // false - clamp уже выполняется
+void releaseClampFlag();
 
 // Инициализация шаговых двигателей
 void initializeSteppers();
@@ -44,8 +64,22 @@ void initializeSteppers();
 // Получение указателя на двигатель по типу
 GStepper2<STEPPER2WIRE>* getStepperByType(StepperType type);
 
-// Получение конфигурации двигателя по типу
-StepperConfig getStepperConfig(StepperType type);
+// Копирование конфигурации оси из таблицы описаний с учётом пределов setAxisLimits()
+void readStepperConfig(StepperType type, StepperConfig& config);
+
+// Пределы скорости и ускорения оси вместо config.h (0 - значение config.h). Скорости хоминга
+// ограничиваются maxSpeed. В движок не передаются - после смены применить stepEngineSet*()
+void setAxisLimits(StepperType type, uint16_t maxSpeed, uint16_t acceleration);
+void getAxisLimits(StepperType type, uint16_t& maxSpeed, uint16_t& acceleration);
+
+// Имена оси во flash: для сообщений и для событий протокола
+const __FlashStringHelper* getAxisName(StepperType type);
+const __FlashStringHelper* getAxisEventName(StepperType type);
+
+// Датчик оси (E0/E1 - общий датчик clamp) и его тип
+int getAxisEndstopPin(StepperType type);
+bool getAxisEndstopNPN(StepperType type);
+bool readAxisEndstop(StepperType type);
 
 // Применение конфигурации к двигателю
 void applyStepperConfig(GStepper2<STEPPER2WIRE>& stepper, const StepperConfig& config);
@@ -0,0 +1,30 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============== ПОТОК ТЕЛЕМЕТРИИ ==============
+// Текстовый режим - строка:
+//   TLM,<мс>,<multi>,<multizone>,<rright>,<e0>,<e1>,<вес г>,<маска ротора>,<отходы>,<маска концевиков>
+// Двоичный режим - кадр binary_protocol со статусом BIN_STATUS_EVENT, OP = BIN_OP_TELEMETRY,
+// SEQ - счётчик кадров (пропуск виден по разрыву), данные TELEMETRY_PAYLOAD_SIZE байт LE:
+//   uint32 мс, int32 позиции x5, int32 вес * 100, uint8 ротор, uint8 отходы, uint8 концевики
+// Маски: бит i ротора - ROTOR_PINS[i], бит i концевиков - ось StepperType i (1 - сработал)
+#define TELEMETRY_PAYLOAD_SIZE 31
+
+// Частота кадров, Гц: 0 - выключено, не больше TELEMETRY_MAX_HZ
+bool setTelemetryRate(uint8_t hz);
+uint8_t getTelemetryRate();
+
+// Число кадров, пропущенных из-за заполненного буфера передачи
+uint32_t getTelemetryDropped();
+
+// Отправка кадра по расписанию - вызывать из loop()
+void serviceTelemetry();
+
+// Прежний интерфейс автоматического отчёта веса: телеметрия раз в секунду
+void enableWeightReport();
+void disableWeightReport();
+
+#endif // TELEMETRY_H
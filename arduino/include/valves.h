@@ -22,7 +22,29 @@ void turnValveOn(int valvePin);
 // Выключение клапана
 void turnValveOff(int valvePin);
 
-// Открытие клапана на указанное время (в сотых долях секунды)
-void openValveForTime(int valvePin, int timeInCentiseconds);
+// Открытие клапана на указанное время (в сотых долях секунды) через расписание, без ожидания.
+// notify = true: по окончании "COMPLETED kl1" (kl2, pump) или "ERR: ABORTED kl1"
+bool openValveForTime(int valvePin, int timeInCentiseconds, bool notify);
+
+// Серия из count импульсов длительностью onMs с периодом periodMs (для count = 1 период не важен).
+// Повторный запуск на том же выходе заменяет расписание; ручное управление выходом его снимает.
+// false - параметры недопустимы или таблица расписаний занята
+bool startValvePulse(int pin, uint16_t onMs, uint16_t count, uint16_t periodMs, bool notify);
+
+// События о завершении импульсов (и переключение выходов в режиме без Timer0) - вызывать из loop()
+void serviceValves();
+
+bool isValvePulseActive(int pin);
+
+// Снятие расписания выхода, которым дальше управляет другой модуль (события движения step_engine).
+// Выход с расписанием выключается; уровень, заданный вручную, не меняется
+void releaseValvePulse(int pin);
+
+// Ожидание окончания импульсов выхода (задания движения продолжают обслуживаться),
+// false - расписание снято ручной командой
+bool waitValvePulse(int pin);
+
+// Статическое ОЗУ расписаний импульсов (VALVE_PULSE_SLOTS), байт
+uint16_t getValvesMemory();
 
 #endif // VALVES_H 
\ No newline at end of file
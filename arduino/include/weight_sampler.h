@@ -0,0 +1,25 @@
+#ifndef WEIGHT_SAMPLER_H
+#define WEIGHT_SAMPLER_H
+
+#include <stdint.h>
+#include "config.h"
+
+// Фоновое заполнение истории NBHX711: по прерыванию Timer2 (WEIGHT_SAMPLER_TIMER2) или из loop()
+void initializeWeightSampler();
+
+// Опрос датчика в режиме без таймера - вызывать из loop(); при работе от Timer2 ничего не делает
+void serviceWeightSampler();
+
+// Ожидание count новых отсчётов, false - датчик не ответил за timeoutMs
+bool waitWeightSamples(uint8_t count, unsigned long timeoutMs);
+
+// Обработчик нового отсчёта (сырое значение). При работе от Timer2 вызывается из прерывания
+// с разрешёнными прерываниями - должен быть коротким и не печатать в Serial
+typedef void (*WeightSampleHandler)(long raw);
+void setWeightSampleHandler(WeightSampleHandler handler);
+
+// Число отсчётов с момента запуска и время с последнего отсчёта, мс
+uint32_t getWeightSampleCount();
+unsigned long getWeightSampleAge();
+
+#endif // WEIGHT_SAMPLER_H
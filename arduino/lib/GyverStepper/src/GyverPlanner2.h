@@ -37,6 +37,7 @@
 
     // ПЛАНИРОВЩИК
     uint32_t getPeriod();                       // возвращает время в мкс до следующего вызова tick/tickManual
+    uint32_t getSubstepPeriod();                // период вызовов tickManual с учётом сабшагов, мкс
     void start();                               // начать работу
     void stop();                                // остановить плавно (с заданным ускорением)
     void brake();                               // резко остановить моторы из любого режима
@@ -386,6 +387,12 @@ class GPlanner2 {
         return us << shift;
     }
 
+    // время до следующего tickManual, мкс: шаг траектории делится на 2^shift сабшагов
+    // (локальное дополнение для внешнего таймера)
+    uint32_t getSubstepPeriod() {
+        return us;
+    }
+
     // статус планировщика
     uint8_t getStatus() {
         return status;
@@ -1,7 +1,8 @@
 #include <Bounce2.h>
 #include <NBHX711.h>
 
-NBHX711 scale(A2, A3, 20);
+NBHX711History<20> history;
+NBHX711 scale(A2, A3, history);
 Bounce tara;
 
 void setup() {
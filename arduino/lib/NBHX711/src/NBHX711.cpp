@@ -1,33 +1,37 @@
 #include <Arduino.h>
 #include <NBHX711.h>
 
-NBHX711::NBHX711(byte data, byte clock, byte depth, byte gain) : 
+NBHX711::NBHX711(byte data, byte clock, unsigned long* buffer, byte depth, byte gain) : 
 	dataPin(data),
 	clockPin(clock),
+	dataInReg(portInputRegister(digitalPinToPort(data))),
+	dataMask(digitalPinToBitMask(data)),
+	clockOutReg(portOutputRegister(digitalPinToPort(clock))),
+	clockMask(digitalPinToBitMask(clock)),
 	offset(0),
 	scaleFactor(1.0),
-	histSize(0),
-	histBuffer(NULL),
-	curr(0)
+	histSize(depth),
+	histBuffer(buffer),
+	curr(0),
+	filled(0),
+	filterMode(FilterMean),
+	iirShift(3),
+	iirState(0),
+	outlierLimit(0),
+	outlierRun(0),
+	rejectCount(0)
 {
-	histSize = 3 * min(max(depth, 6), 255/3);
-	histBuffer = new byte[histSize];
-	if (!histBuffer) {
-		histSize = 0;
-	} else {
-		memset(histBuffer, 0, histSize);
-	}
+	memset(histBuffer, 0, NBHX711_BUFFER_SIZE(histSize) * sizeof(unsigned long));
 	setGainAndChannel(gain);
 	powerUp();
 }
 
 NBHX711::~NBHX711() {
-	delete[] histBuffer;
 	pinMode(clockPin, INPUT);
 }
 
 byte NBHX711::getHistSize() {
-	return histSize / 3;
+	return histSize;
 }	
 
 void NBHX711::begin() {
@@ -35,7 +39,7 @@ void NBHX711::begin() {
 }
 
 bool NBHX711::isReady() {
-	return digitalRead(dataPin) == LOW;
+	return (*dataInReg & dataMask) == 0;
 }
 
 void NBHX711::setGainAndChannel(byte gain) {
@@ -43,18 +47,44 @@ void NBHX711::setGainAndChannel(byte gain) {
 }
 
 long NBHX711::getRaw() {
-	return cvt24(histBuffer + curr);
+	return histSize ? readingAt(curr) : 0;
+}
+
+void NBHX711::writeClock(bool high) {
+	uint8_t oldSREG = SREG;
+	cli();
+	if (high) {
+		*clockOutReg |= clockMask;
+	} else {
+		*clockOutReg &= ~clockMask;
+	}
+	SREG = oldSREG;
+}
+
+byte NBHX711::shiftInFast() {
+	byte value = 0;
+	for (byte i = 0; i < 8; i++) {
+		writeClock(true);
+		value <<= 1;
+		// data is valid 0.1 us after the rising edge, the clock stays high at least 0.2 us
+		if (*dataInReg & dataMask) {
+			value |= 1;
+		}
+		writeClock(false);
+	}
+	return value;
 }
 
 void NBHX711::putData(byte* storeTo) {
 	// pulse the clock pin 24 times to read the data
-	storeTo[2] = shiftIn(dataPin, clockPin, MSBFIRST);
-	storeTo[1] = shiftIn(dataPin, clockPin, MSBFIRST);
-	storeTo[0] = shiftIn(dataPin, clockPin, MSBFIRST);
+	// interrupts may stretch a high pulse, the chip powers down only after 60 us
+	storeTo[2] = shiftInFast();
+	storeTo[1] = shiftInFast();
+	storeTo[0] = shiftInFast();
 	// set the channel and the gain factor for the next reading using the clock pin
 	for (byte i = 0; i < gainCode; i++) {
-		digitalWrite(clockPin, HIGH);
-		digitalWrite(clockPin, LOW);
+		writeClock(true);
+		writeClock(false);
 	}
 }
 
@@ -71,42 +101,140 @@ long NBHX711::cvt24(byte* from) {
 
 bool NBHX711::update() {
 	bool retVal = false;
-	if (isReady()) {
+	if (isReady() && histSize) {
 		retVal = true;
-		curr = nextIndex(curr);
-		putData(histBuffer + curr);
+		byte data[3];
+		putData(data);
+		long value = rejectOutlier(cvt24(data));
+		// fill the next slot first, readers keep using curr until it is complete
+		byte last = curr;
+		byte next = nextIndex(last);
+		histBuffer[next] = histBuffer[last] + static_cast<unsigned long>(value);
+		if (filled) {
+			iirState += (value * (1L << NBHX711_IIR_FRACTION) - iirState) >> iirShift;
+		} else {
+			iirState = value * (1L << NBHX711_IIR_FRACTION);
+		}
+		curr = next;
+		if (filled < histSize) {
+			filled++;
+		}
 	}
 	return retVal;
 }
 
-byte NBHX711::backIndex(byte times) {
-	int index = curr - (times - 1) * 3;
+long NBHX711::rejectOutlier(long value) {
+	if (outlierLimit && filled) {
+		long previous = readingAt(curr);
+		long delta = value - previous;
+		if ((delta > outlierLimit || -delta > outlierLimit) && ++outlierRun < NBHX711_OUTLIER_CONFIRM) {
+			rejectCount++;
+			return previous;
+		}
+	}
+	outlierRun = 0;
+	return value;
+}
+
+byte NBHX711::backIndex(byte from, byte times) {
+	int index = from - times;
 	if (index < 0) {
-		index += histSize;
+		index += histSize + 2;
 	}
 	return index;
 }
 
 byte NBHX711::nextIndex(byte index) {
-	int nIndex = index + 3;
-	if (nIndex >= histSize) {
+	int nIndex = index + 1;
+	if (nIndex >= histSize + 2) {
 		nIndex = 0;
 	}
 	return nIndex;	
 }
 
+long NBHX711::readingAt(byte index) {
+	return static_cast<long>(histBuffer[index] - histBuffer[backIndex(index, 1)]);
+}
+
+byte NBHX711::clampTimes(byte times) {
+	byte available = filled;
+	if (times > available) {
+		times = available;
+	}
+	return times;
+}
+
 long NBHX711::readAverage(byte times) {
-	long sum = 0;
-	byte index = backIndex(times);
+	times = clampTimes(times);
+	if (!times) {
+		return 0;
+	}
+	byte last = curr;
+	return static_cast<long>(histBuffer[last] - histBuffer[backIndex(last, times)]) / times;
+}
+
+long NBHX711::readMedian(byte times) {
+	times = clampTimes(min(times, NBHX711_MEDIAN_MAX));
+	if (!times) {
+		return 0;
+	}
+	// insertion sort of a short window is cheaper than keeping a sorted copy
+	long window[NBHX711_MEDIAN_MAX];
+	byte index = curr;
 	for (byte i = 0; i < times; i++) {
-		sum += cvt24(histBuffer + index);
-		index = nextIndex(index);
+		long value = readingAt(index);
+		byte j = i;
+		for (; j > 0 && window[j - 1] > value; j--) {
+			window[j] = window[j - 1];
+		}
+		window[j] = value;
+		index = backIndex(index, 1);
 	}
-	return sum / times;
+	if (times & 1) {
+		return window[times / 2];
+	}
+	return (window[times / 2 - 1] + window[times / 2]) / 2;
+}
+
+long NBHX711::readFiltered() {
+	uint8_t oldSREG = SREG;
+	cli();
+	long state = iirState;
+	SREG = oldSREG;
+	return state >> NBHX711_IIR_FRACTION;
+}
+
+void NBHX711::setFilter(byte mode, byte shift) {
+	filterMode = mode;
+	iirShift = constrain(shift, 1, NBHX711_IIR_FRACTION);
+}
+
+byte NBHX711::getFilter() {
+	return filterMode;
+}
+
+void NBHX711::setOutlierLimit(long limit) {
+	outlierLimit = limit;
+	outlierRun = 0;
+}
+
+unsigned long NBHX711::getRejectCount() {
+	uint8_t oldSREG = SREG;
+	cli();
+	unsigned long count = rejectCount;
+	SREG = oldSREG;
+	return count;
 }
 
 long NBHX711::getValue(byte times) {
-	return readAverage(times) - offset;
+	switch (filterMode) {
+		case FilterMedian:
+			return readMedian(times) - offset;
+		case FilterIIR:
+			return readFiltered() - offset;
+		default:
+			return readAverage(times) - offset;
+	}
 }
 
 float NBHX711::getUnits(byte times) {
@@ -37,6 +37,41 @@ enum ChGain {
 	ChA64
 };
 
+ /**
+  * enumerate the filters applied by getValue / getUnits
+  *
+  */
+enum FilterMode {
+	/// arithmetic mean of the last times readings, constant time
+	FilterMean = 0,
+	/// median of the last times readings, at most NBHX711_MEDIAN_MAX
+	FilterMedian,
+	/// fixed-point exponential filter updated on every reading, times is ignored
+	FilterIIR
+};
+
+/// longest window of the median filter
+#define NBHX711_MEDIAN_MAX 15
+/// fractional bits of the exponential filter state
+#define NBHX711_IIR_FRACTION 6
+/// consecutive out-of-limit readings accepted as a real change
+#define NBHX711_OUTLIER_CONFIRM 2
+/// shallowest and deepest history buffer in readings
+#define NBHX711_DEPTH_MIN 6
+#define NBHX711_DEPTH_MAX 253
+/// entries of a history buffer of depth readings
+#define NBHX711_BUFFER_SIZE(depth) ((depth) + 2)
+
+/**
+ *	statically allocated history buffer of DEPTH readings, no heap is used
+ *	two spare running sums follow the readings, see histBuffer
+ */
+template <byte DEPTH>
+struct NBHX711History {
+	static_assert(DEPTH >= NBHX711_DEPTH_MIN && DEPTH <= NBHX711_DEPTH_MAX, "NBHX711 history depth out of range");
+	unsigned long entries[NBHX711_BUFFER_SIZE(DEPTH)];
+};
+
 //--current development 
 // onRapidChange
 
@@ -49,6 +84,12 @@ class NBHX711 {
 	byte dataPin;
 	/// serial clock and power down control
 	byte clockPin;
+	/// input register and bit of dataPin, read directly
+	volatile uint8_t* dataInReg;
+	uint8_t dataMask;
+	/// output register and bit of clockPin, written directly
+	volatile uint8_t* clockOutReg;
+	uint8_t clockMask;
 protected:
 	/// selects gain and channel
 	byte gainCode;
@@ -56,12 +97,27 @@ protected:
 	long offset;
 	/// factor to convert reading to units
 	float scaleFactor;
-	/// size of history buffer
+	/// depth of history buffer in readings
 	byte histSize;
-	/// the history buffer
-	byte* histBuffer;
-	/// pointer to current reading
-	byte curr;
+	/// running sums: histBuffer[i] is the sum of all readings up to i (mod 2^32),
+	/// a window sum is the difference of two entries, histSize + 2 entries
+	unsigned long* histBuffer;
+	/// index of current reading, published after the sample is complete
+	volatile byte curr;
+	/// number of readings in the history, up to histSize
+	volatile byte filled;
+	/// filter used by getValue
+	byte filterMode;
+	/// exponential filter weight 2^-iirShift
+	byte iirShift;
+	/// exponential filter state, scaled by 2^NBHX711_IIR_FRACTION
+	long iirState;
+	/// readings farther than this from the previous one are rejected, 0 - off
+	long outlierLimit;
+	/// consecutive rejected readings
+	byte outlierRun;
+	/// total rejected readings
+	unsigned long rejectCount;
 /**
  *	conversion function
  *	convert 3 byte signed value to signed 32 bit long
@@ -75,18 +131,57 @@ protected:
  *	@param storeTo [in] pointer to little endian 24 bit value
  */
 	void putData(byte* storeTo);
+/**
+ *	access function
+ *	set the clock pin, the read-modify-write is done with interrupts off
+ *	because other pins of the port may be driven from interrupts
+ *	@param high [in] new level of the clock pin
+ */
+	void writeClock(bool high);
+/**
+ *	access function
+ *	clock in 8 bits MSB first using direct port access
+ *	@return byte read
+ */
+	byte shiftInFast();
 /**
  *	utility function
+ *	@param from [in] index of history element
  *	@param times [in] number of history elements
- *	@return index of curr - (times - 1) elements
+ *	@return index of from - times element
  */
-	byte backIndex(byte times);
+	byte backIndex(byte from, byte times);
 /**
  *	utility function
  *	@param index [in] index of history element
  *	@return index of index + 1 element
  */
 	byte nextIndex(byte index);
+/**
+ *	utility function
+ *	@param index [in] index of history element
+ *	@return reading stored at index
+ */
+	long readingAt(byte index);
+/**
+ *	utility function
+ *	@param times [in] number of history elements requested
+ *	@return times limited to the readings available
+ */
+	byte clampTimes(byte times);
+/**
+ *	utility function
+ *	replace a single spike by the previous reading, see setOutlierLimit
+ *	@param value [in] new reading
+ *	@return value to store
+ */
+	long rejectOutlier(long value);
+/**
+ *	constructor on a caller-owned buffer of NBHX711_BUFFER_SIZE(depth) entries
+ *	@param buffer [in] history buffer, depth + 2 entries
+ *	@param depth [in] depth of cyclic history buffer, NBHX711_DEPTH_MIN .. NBHX711_DEPTH_MAX
+ */
+	NBHX711(byte dout, byte pd_sck, unsigned long* buffer, byte depth, byte gain);
 public:
 /**
  *	available data is signaled by the HX711 via LOW on dataPin
@@ -94,16 +189,18 @@ public:
 	bool isReady();
 /**
  *	constructor
- *  set up variables and allocate history buffer
+ *  set up variables, the history buffer is owned by the caller
  *	@param dout [in] data pin
  *	@param pd_sck [in] clock pin, used also to set channel and gain via additional pulses
- *	@param depth [in] depth of cyclic history buffer
+ *	@param history [in] cyclic history buffer, its depth is the template parameter
  *	@param gain [in] selected gain and channel, default A-128
  */
-	NBHX711(byte dout, byte pd_sck, byte depth = 12, byte gain = ChA128);
+	template <byte DEPTH>
+	NBHX711(byte dout, byte pd_sck, NBHX711History<DEPTH>& history, byte gain = ChA128) :
+		NBHX711(dout, pd_sck, history.entries, DEPTH, gain) {}
 /**
  *	destructor
- *  free history buffer, release output port
+ *  release output port
  */
 	~NBHX711();
 /**
@@ -122,6 +219,8 @@ public:
 	void setGainAndChannel(byte gain = ChA128);
 /**
  *	check if new value available and put it to history buffer
+ *	safe to call from a timer interrupt: readers only see completed samples,
+ *	the ring keeps two spare entries so a full-depth window is never being written
  *	@return true if value was read
  */
 	bool update();
@@ -132,14 +231,48 @@ public:
 	long getRaw();
 /**
  *	get the arithmetic mean of the last times raw HX711 outputs
+ *	constant time, computed from the running sums
  *	@param times [in] number of history elements to process
  *	@return arithmetic mean of the last times raw HX711 outputs
  */
 	long readAverage(byte times = 10);
 /**
- *	compute relative average
+ *	get the median of the last times raw HX711 outputs
+ *	@param times [in] number of history elements to process, at most NBHX711_MEDIAN_MAX
+ *	@return median of the last times raw HX711 outputs
+ */
+	long readMedian(byte times = 5);
+/**
+ *	get the output of the exponential filter
+ *	@return filtered raw HX711 output
+ */
+	long readFiltered();
+/**
+ *	select the filter used by getValue and getUnits
+ *	@param mode [in] FilterMean, FilterMedian or FilterIIR
+ *	@param shift [in] exponential filter weight 2^-shift, 1..NBHX711_IIR_FRACTION
+ */
+	void setFilter(byte mode = FilterMean, byte shift = 3);
+/**
+ *	get the selected filter
+ *	@return FilterMean, FilterMedian or FilterIIR
+ */
+	byte getFilter();
+/**
+ *	reject single readings that jump more than limit from the previous one,
+ *	NBHX711_OUTLIER_CONFIRM readings in a row are accepted as a real change
+ *	@param limit [in] largest accepted step in raw units, 0 disables rejection
+ */
+	void setOutlierLimit(long limit = 0);
+/**
+ *	get the number of rejected readings
+ *	@return readings replaced since start
+ */
+	unsigned long getRejectCount();
+/**
+ *	compute relative filtered value
  *	@param times [in] number of history elements to process
- *	@return readAverage(times) minus offset
+ *	@return reading of the selected filter minus offset
  */
 	long getValue(byte times = 1);
 /**
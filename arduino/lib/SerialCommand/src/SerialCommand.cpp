@@ -0,0 +1,116 @@
+/**
+ * SerialCommand - A Wiring/Arduino library to tokenize and parse commands
+ * received over a serial port.
+ *
+ * Copyright (C) 2012 Stefan Rado
+ * Copyright (C) 2011 Steven Cogswell <steven.cogswell@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ */
+#include "SerialCommand.h"
+#include <stdlib.h>
+#include <ctype.h>
+
+SerialCommand::SerialCommand()
+  : commandCount(0),
+    droppedCount(0),
+    defaultHandler(NULL),
+    lineHandler(NULL),
+    overflowHandler(NULL),
+    term('\n'),
+    last(NULL)
+{
+  strcpy(delim, " ");
+  clearBuffer();
+}
+
+bool SerialCommand::addCommand(const char *command, void (*function)()) {
+  if (commandCount >= SERIALCOMMAND_MAX_COMMANDS) {
+    droppedCount++;
+    return false;
+  }
+  commandList[commandCount].command = command;
+  commandList[commandCount].function = function;
+  commandCount++;
+  return true;
+}
+
+void SerialCommand::setDefaultHandler(void (*function)(const char *)) {
+  defaultHandler = function;
+}
+
+void SerialCommand::setLineHandler(void (*function)(char *)) {
+  lineHandler = function;
+}
+
+void SerialCommand::setOverflowHandler(void (*function)()) {
+  overflowHandler = function;
+}
+
+void SerialCommand::readSerial() {
+  while (Serial.available() > 0) {
+    char inChar = Serial.read();
+    if (inChar == term) {
+      if (overflow) {
+        if (overflowHandler != NULL) (*overflowHandler)();
+      } else if (lineHandler != NULL) {
+        (*lineHandler)(buffer);
+      } else {
+        dispatch(buffer);
+      }
+      clearBuffer();
+      // Остальные символы - в следующем вызове: loop() успевает обслужить задания
+      // и переход в двоичный режим не съедает первые байты кадров
+      return;
+    }
+    else if (isprint(inChar)) {
+      if (bufPos < SERIALCOMMAND_BUFFER) {
+        buffer[bufPos++] = inChar;
+        buffer[bufPos] = '\0';
+      } else {
+        overflow = true;
+      }
+    }
+  }
+}
+
+bool SerialCommand::dispatch(char *line) {
+  char *command = strtok_r(line, delim, &last);
+  if (command == NULL) return false;
+
+  int8_t index = findCommand(command, strlen(command));
+  if (index >= 0) {
+    (*commandList[index].function)();
+    return true;
+  }
+  if (defaultHandler != NULL) (*defaultHandler)(command);
+  return false;
+}
+
+bool SerialCommand::hasCommand(const char *line) const {
+  while (*line == delim[0]) line++;
+  return findCommand(line, strcspn(line, delim)) >= 0;
+}
+
+int8_t SerialCommand::findCommand(const char *name, size_t length) const {
+  if (length == 0) return -1;
+  for (uint8_t i = 0; i < commandCount; i++) {
+    if (strlen(commandList[i].command) == length && strncmp(name, commandList[i].command, length) == 0) {
+      return i;
+    }
+  }
+  return -1;
+}
+
+void SerialCommand::clearBuffer() {
+  buffer[0] = '\0';
+  bufPos = 0;
+  overflow = false;
+}
+
+char *SerialCommand::next() {
+  return strtok_r(NULL, delim, &last);
+}
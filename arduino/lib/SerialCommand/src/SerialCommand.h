@@ -0,0 +1,89 @@
+/**
+ * SerialCommand - A Wiring/Arduino library to tokenize and parse commands
+ * received over a serial port.
+ *
+ * Copyright (C) 2012 Stefan Rado
+ * Copyright (C) 2011 Steven Cogswell <steven.cogswell@gmail.com>
+ *
+ * This library is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Локальная копия kroimon/SerialCommand@76ebd2d60e для прошивки:
+ * - имя команды сравнивается целиком (в исходной версии - первые 8 символов);
+ * - строка до SERIALCOMMAND_BUFFER символов, переполненная строка не выполняется;
+ * - setLineHandler() получает строку целиком (пакеты команд через ';'),
+ *   dispatch() выполняет одну команду из строки;
+ * - readSerial() обрабатывает не больше одной строки за вызов;
+ * - таблица команд - статический массив на SERIALCOMMAND_MAX_COMMANDS записей вместо realloc().
+ */
+#ifndef SerialCommand_h
+#define SerialCommand_h
+
+#include <Arduino.h>
+#include <string.h>
+
+// Длина строки команды (без завершающего нуля)
+#ifndef SERIALCOMMAND_BUFFER
+#define SERIALCOMMAND_BUFFER 128
+#endif
+
+// Зарегистрированных команд (4 байта на команду)
+#ifndef SERIALCOMMAND_MAX_COMMANDS
+#define SERIALCOMMAND_MAX_COMMANDS 72
+#endif
+
+class SerialCommand {
+  public:
+    SerialCommand();
+
+    // Команда хранится по указателю: строка должна жить всё время работы (литерал).
+    // false - таблица команд заполнена, команда не добавлена (учитывается в getDroppedCount())
+    bool addCommand(const char *command, void (*function)());
+    uint8_t getCommandCount() const { return commandCount; }
+    uint8_t getDroppedCount() const { return droppedCount; }
+    void setDefaultHandler(void (*function)(const char *));
+
+    // Обработчик принятой строки вместо dispatch(); строка изменяема до возврата
+    void setLineHandler(void (*function)(char *));
+    // Вызывается вместо выполнения строки длиннее SERIALCOMMAND_BUFFER
+    void setOverflowHandler(void (*function)());
+
+    void readSerial();
+    void clearBuffer();
+    char *next();
+
+    // Выполнение одной команды из line (line разбивается strtok_r).
+    // false - пустая строка или неизвестная команда (вызван defaultHandler)
+    bool dispatch(char *line);
+
+    // true - первое слово line является зарегистрированной командой
+    bool hasCommand(const char *line) const;
+
+  private:
+    struct SerialCommandCallback {
+      const char *command;
+      void (*function)();
+    };
+
+    int8_t findCommand(const char *name, size_t length) const;
+
+    SerialCommandCallback commandList[SERIALCOMMAND_MAX_COMMANDS];
+    uint8_t commandCount;
+    uint8_t droppedCount;
+
+    void (*defaultHandler)(const char *);
+    void (*lineHandler)(char *);
+    void (*overflowHandler)();
+
+    char delim[2];
+    char term;
+
+    char buffer[SERIALCOMMAND_BUFFER + 1];
+    uint8_t bufPos;
+    bool overflow;
+    char *last;
+};
+
+#endif // SerialCommand_h
@@ -0,0 +1,322 @@
+/**
+ * @file: axis_tune.cpp
+ * @description: Подбор наибольших скорости и ускорения оси без потери шагов
+ * @dependencies: motion_jobs, step_engine, stepper_control, EEPROM, config.h
+ * @created: 2026-10-14
+ *
+ * Потерянные шаги измеряются датчиком: после серии ходов ось обнуляется заново, и
+ * смещение точки срабатывания от прежнего нуля (getHomingDrift) показывает, сколько
+ * шагов двигатель не отработал. Сначала ускорение поднимается от TUNE_START_PCT до
+ * TUNE_MAX_PCT значения config.h на рабочей скорости, затем на найденном ускорении так
+ * же поднимается скорость. Первый уровень с потерей шагов завершает этап.
+ *
+ * Ускорение движок задаёт масштабом таблицы разгона, поэтому скорость не поднимается
+ * выше stepEngineGetSpeedCeiling(): дальше таблица скорость не даёт, и ход на таком
+ * уровне ничего бы не проверял. Обнуление каждый раз идёт на ускорении config.h.
+ */
+
+#include "axis_tune.h"
+#include "motion_jobs.h"
+#include "step_engine.h"
+#include "binary_protocol.h"
+#include "log.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <util/crc16.h>
+
+// Запись EEPROM: TUNE_MAGIC, скорость и ускорение каждой оси (uint16 LE), CRC16 LE по ним
+#define TUNE_MAGIC 0xA7
+#define TUNE_RECORD_SIZE (1 + STEPPER_AXIS_COUNT * 4 + 2)
+
+static_assert(TUNE_EEPROM_BASE + TUNE_RECORD_SIZE <= RECIPE_EEPROM_BASE,
+              "Пределы осей заходят на слоты рецептов");
+
+typedef enum {
+  TUNE_IDLE,
+  TUNE_HOME,     // обнуление перед уровнем или после его ходов
+  TUNE_MOVE      // ходы уровня
+} TuneState;
+
+typedef enum {
+  STAGE_ACCEL,
+  STAGE_SPEED
+} TuneStage;
+
+static TuneState tuneState = TUNE_IDLE;
+static TuneStage stage = STAGE_ACCEL;
+static StepperType axis = STEPPER_MULTI;
+static StepperConfig base;
+static long distance = 0;
+static uint16_t pct = 0;
+static uint8_t movesDone = 0;
+static bool reference = false;       // обнуление опорное, уровня ещё не было
+static bool lastLevel = false;       // скорость упёрлась в предел таблицы
+static uint16_t levelSpeed = 0;
+static uint16_t levelAccel = 0;
+static uint16_t bestSpeed = 0;
+static uint16_t bestAccel = 0;
+static bool saveResult = false;
+static bool notifyHost = false;
+static const char* lastTuneError = nullptr;
+
+// ============== EEPROM ==============
+static uint16_t readWord(int address) {
+  return EEPROM.read(address) | ((uint16_t)EEPROM.read(address + 1) << 8);
+}
+
+static void writeWord(int address, uint16_t value) {
+  EEPROM.update(address, value & 0xFF);
+  EEPROM.update(address + 1, value >> 8);
+}
+
+static uint16_t recordCrc() {
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT * 4; i++) crc = _crc_ccitt_update(crc, EEPROM.read(TUNE_EEPROM_BASE + 1 + i));
+  return crc;
+}
+
+static void applyLimits(StepperType type) {
+  StepperConfig config;
+  readStepperConfig(type, config);
+  stepEngineSetAcceleration(type, config.acceleration);
+  stepEngineSetMaxSpeed(type, config.maxSpeed);
+}
+
+// ============== УРОВНИ ==============
+static uint16_t scaled(int value) {
+  uint32_t result = (uint32_t)value * pct / 100;
+  return result < 1 ? 1 : (result > AXIS_LIMIT_MAX ? AXIS_LIMIT_MAX : result);
+}
+
+static void finishTune(const char* error) {
+  tuneState = TUNE_IDLE;
+  lastTuneError = error;
+
+  if (!error && saveResult) {
+    setAxisLimits(axis, bestSpeed, bestAccel);
+    saveAxisLimits();
+  }
+
+  // Как после обычного хоминга: ускорение оси и скорость хоминга
+  StepperConfig config;
+  readStepperConfig(axis, config);
+  stepEngineSetAcceleration(axis, config.acceleration);
+  stepEngineSetMaxSpeed(axis, config.homingSpeed);
+
+  if (isBinaryMode()) return;
+  if (!error) {
+    Serial.print(F("TUNE "));
+    Serial.print(getMotionJobName(axis));
+    Serial.print(F(" max_speed="));
+    Serial.print(bestSpeed);
+    Serial.print(F(" acceleration="));
+    Serial.println(bestAccel);
+  }
+  if (notifyHost) {
+    if (error) {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(error);
+    } else {
+      Serial.print(MSG_COMPLETED);
+    }
+    Serial.println(F(" tune"));
+  }
+}
+
+static void reportLevel(long drift, bool ok) {
+  if (isBinaryMode()) return;
+  Serial.print(F("TUNE "));
+  Serial.print(getMotionJobName(axis));
+  Serial.print(F(" accel="));
+  Serial.print(levelAccel);
+  Serial.print(F(" speed="));
+  Serial.print(levelSpeed);
+  Serial.print(F(" drift="));
+  Serial.print(drift);
+  Serial.println(ok ? F(" ok") : F(" lost"));
+}
+
+static bool startHome() {
+  stepEngineSetAcceleration(axis, base.acceleration);
+  tuneState = TUNE_HOME;
+  return startHomeJob(axis, false);
+}
+
+// Параметры уровня pct текущего этапа и первый ход
+static bool startLevel() {
+  if (stage == STAGE_ACCEL) {
+    levelAccel = scaled(base.acceleration);
+    levelSpeed = base.maxSpeed;
+  } else {
+    levelAccel = bestAccel;
+    levelSpeed = scaled(base.maxSpeed);
+  }
+  stepEngineSetAcceleration(axis, levelAccel);
+
+  // Пониженное ускорение снижает и предел таблицы - на этапе ускорения это не повод
+  // останавливаться, на этапе скорости выше предела уровней нет
+  uint16_t ceiling = stepEngineGetSpeedCeiling(axis);
+  lastLevel = pct >= TUNE_MAX_PCT;
+  if (levelSpeed >= ceiling) {
+    levelSpeed = ceiling;
+    if (stage == STAGE_SPEED) lastLevel = true;
+  }
+  stepEngineSetMaxSpeed(axis, levelSpeed);
+
+  movesDone = 0;
+  tuneState = TUNE_MOVE;
+  return startMoveJob(axis, distance, false);
+}
+
+// Переход к следующему уровню или этапу; false - подбор завершён
+static bool nextLevel(bool ok) {
+  if (ok) {
+    if (stage == STAGE_ACCEL) bestAccel = levelAccel;
+    else bestSpeed = levelSpeed;
+  }
+  bool stageDone = !ok || lastLevel;
+  if (!stageDone) {
+    pct += TUNE_STEP_PCT;
+    return true;
+  }
+
+  // Этап без единого уровня без потерь - предел ниже TUNE_START_PCT
+  if ((stage == STAGE_ACCEL ? bestAccel : bestSpeed) == 0) {
+    finishTune(MSG_TUNE_FAILED);
+    return false;
+  }
+  if (stage == STAGE_SPEED) {
+    finishTune(nullptr);
+    return false;
+  }
+  stage = STAGE_SPEED;
+  pct = TUNE_START_PCT;
+  return true;
+}
+
+// ============== ИНТЕРФЕЙС ==============
+void initializeAxisTune() {
+  tuneState = TUNE_IDLE;
+  if (EEPROM.read(TUNE_EEPROM_BASE) != TUNE_MAGIC) return;
+  if (readWord(TUNE_EEPROM_BASE + 1 + STEPPER_AXIS_COUNT * 4) != recordCrc()) return;
+
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    int address = TUNE_EEPROM_BASE + 1 + i * 4;
+    uint16_t speed = readWord(address);
+    uint16_t accel = readWord(address + 2);
+    if (speed > AXIS_LIMIT_MAX || accel > AXIS_LIMIT_MAX) continue;
+    setAxisLimits((StepperType)i, speed, accel);
+    applyLimits((StepperType)i);
+  }
+}
+
+bool startAxisTune(StepperType type, long moveDistance, bool save, bool notify) {
+  if (labs(moveDistance) < 2) {
+    lastTuneError = MSG_INVALID_PARAMETER;
+    return false;
+  }
+  if (tuneState != TUNE_IDLE || isAxisBusy(type)) {
+    lastTuneError = MSG_AXIS_BUSY;
+    return false;
+  }
+
+  axis = type;
+  distance = moveDistance;
+  saveResult = save;
+  notifyHost = notify;
+  lastTuneError = nullptr;
+  readStepperConfig(type, base);
+  stage = STAGE_ACCEL;
+  pct = TUNE_START_PCT;
+  bestSpeed = 0;
+  bestAccel = 0;
+  reference = true;
+  if (!startHome()) {
+    tuneState = TUNE_IDLE;
+    lastTuneError = MSG_AXIS_BUSY;
+    return false;
+  }
+  return true;
+}
+
+void serviceAxisTune() {
+  if (tuneState == TUNE_IDLE || isMotionJobActive(axis)) return;
+
+  MotionJobResult result = getMotionJobResult(axis);
+  if (result != JOB_RESULT_OK) {
+    finishTune(result == JOB_RESULT_ABORTED ? MSG_JOB_ABORTED : (tuneState == TUNE_HOME ? MSG_HOMING_TIMEOUT : MSG_MOVE_FAILED));
+    return;
+  }
+
+  if (tuneState == TUNE_MOVE) {
+    // Ходы между distance и 1 (позиция 0 для заданий движения недопустима)
+    if (++movesDone < 2 * TUNE_CYCLES) {
+      if (!startMoveJob(axis, (movesDone & 1) ? (distance > 0 ? 1 : -1) : distance, false)) finishTune(MSG_MOVE_FAILED);
+      return;
+    }
+    if (!startHome()) finishTune(MSG_HOMING_TIMEOUT);
+    return;
+  }
+
+  // Обнуление завершено
+  if (!reference) {
+    long drift = 0;
+    bool ok = getHomingDrift(axis, drift) && labs(drift) <= TUNE_TOLERANCE_STEPS;
+    reportLevel(drift, ok);
+    if (!nextLevel(ok)) return;
+  }
+  reference = false;
+  if (!startLevel()) finishTune(MSG_MOVE_FAILED);
+}
+
+bool waitAxisTune() {
+  while (tuneState != TUNE_IDLE) {
+    serviceAxisTune();
+    serviceMotionJobs();
+    serviceLog();
+    yield();
+  }
+  return lastTuneError == nullptr;
+}
+
+void abortAxisTune() {
+  if (tuneState == TUNE_IDLE) return;
+  abortMotionJobs(STEP_ENGINE_AXIS_BIT(axis));
+  finishTune(MSG_JOB_ABORTED);
+}
+
+bool isAxisTuneActive() {
+  return tuneState != TUNE_IDLE;
+}
+
+const char* getLastAxisTuneError() {
+  return lastTuneError;
+}
+
+uint16_t getTunedSpeed() {
+  return bestSpeed;
+}
+
+uint16_t getTunedAcceleration() {
+  return bestAccel;
+}
+
+void saveAxisLimits() {
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    uint16_t speed, accel;
+    getAxisLimits((StepperType)i, speed, accel);
+    writeWord(TUNE_EEPROM_BASE + 1 + i * 4, speed);
+    writeWord(TUNE_EEPROM_BASE + 3 + i * 4, accel);
+  }
+  writeWord(TUNE_EEPROM_BASE + 1 + STEPPER_AXIS_COUNT * 4, recordCrc());
+  EEPROM.update(TUNE_EEPROM_BASE, TUNE_MAGIC);
+}
+
+void clearAxisLimits() {
+  EEPROM.update(TUNE_EEPROM_BASE, 0xFF);
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    setAxisLimits((StepperType)i, 0, 0);
+    applyLimits((StepperType)i);
+  }
+}
@@ -0,0 +1,394 @@
+/**
+ * @file: binary_protocol.cpp
+ * @description: Двоичный протокол команд с номерами последовательности и CRC16
+ * @dependencies: motion_jobs, step_engine, valves, telemetry, recipe, NBHX711, config.h
+ * @created: 2026-10-14
+ *
+ * Работает рядом с текстовым SerialCommand: после команды "binary" байты порта разбираются
+ * здесь, пока хост не пришлёт BIN_OP_TEXT_MODE. Хост может отправить несколько команд подряд
+ * и сопоставлять ответы по SEQ. Задания движения запускаются без текстовых событий,
+ * завершение отслеживается опросом motion_jobs и отправляется кадром DONE/ERR.
+ */
+
+#include "binary_protocol.h"
+#include "motion_jobs.h"
+#include "step_engine.h"
+#include "valves.h"
+#include "telemetry.h"
+#include "recipe.h"
+#include "log.h"
+#include <Arduino.h>
+#include <NBHX711.h>
+#include <util/crc16.h>
+
+extern NBHX711 scale;
+
+typedef enum {
+  RX_SYNC,
+  RX_LEN,
+  RX_BODY,
+  RX_CRC_LO,
+  RX_CRC_HI
+} RxState;
+
+// Ожидающий ответа о завершении запрос
+typedef struct {
+  bool active;
+  uint8_t seq;
+  uint8_t op;
+} PendingReply;
+
+static bool binaryMode = false;
+static RxState rxState = RX_SYNC;
+static uint8_t rxLen = 0;
+static uint8_t rxCount = 0;
+static uint8_t rxBody[3 + BIN_MAX_PAYLOAD];   // SEQ OP AXIS аргументы
+static uint16_t rxCrc = 0;
+static unsigned long rxLastByteTime = 0;
+
+static PendingReply pendingJobs[STEP_ENGINE_AXES];
+static PendingReply pendingBatch;
+static PendingReply pendingRecipe;
+static uint8_t recipeStepsReported = 0;
+
+// ============== ОТПРАВКА КАДРОВ ==============
+static void sendFrame(uint8_t seq, uint8_t status, uint8_t op, const uint8_t* payload, uint8_t length) {
+  uint8_t header[4] = {(uint8_t)(3 + length), seq, status, op};
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < sizeof(header); i++) crc = _crc_ccitt_update(crc, header[i]);
+  for (uint8_t i = 0; i < length; i++) crc = _crc_ccitt_update(crc, payload[i]);
+
+  Serial.write(BIN_SYNC);
+  Serial.write(header, sizeof(header));
+  if (length) Serial.write(payload, length);
+  Serial.write((uint8_t)(crc & 0xFF));
+  Serial.write((uint8_t)(crc >> 8));
+}
+
+static void sendStatus(uint8_t seq, uint8_t status, uint8_t op) {
+  sendFrame(seq, status, op, nullptr, 0);
+}
+
+static void sendErrorFrame(uint8_t seq, uint8_t op, uint8_t code) {
+  sendFrame(seq, BIN_STATUS_ERR, op, &code, 1);
+}
+
+static void sendValues(uint8_t seq, uint8_t op, const int32_t* values, uint8_t count) {
+  uint8_t payload[BIN_MAX_PAYLOAD];
+  for (uint8_t i = 0; i < count; i++) {
+    uint32_t v = (uint32_t)values[i];
+    payload[i * 4] = v & 0xFF;
+    payload[i * 4 + 1] = (v >> 8) & 0xFF;
+    payload[i * 4 + 2] = (v >> 16) & 0xFF;
+    payload[i * 4 + 3] = v >> 24;
+  }
+  sendFrame(seq, BIN_STATUS_DONE, op, payload, count * 4);
+}
+
+// ============== ЗАДАНИЯ ДВИЖЕНИЯ ==============
+static void startJobReply(StepperType slot, bool started, uint8_t seq, uint8_t op) {
+  if (!started) {
+    sendErrorFrame(seq, op, isAxisBusy(slot) ? BIN_ERR_BUSY : BIN_ERR_PARAM);
+    return;
+  }
+  pendingJobs[slot].active = true;
+  pendingJobs[slot].seq = seq;
+  pendingJobs[slot].op = op;
+  sendStatus(seq, BIN_STATUS_ACK, op);
+}
+
+static void servicePendingReplies() {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    PendingReply& pending = pendingJobs[i];
+    StepperType slot = (StepperType)i;
+    if (!pending.active || isMotionJobActive(slot)) continue;
+
+    pending.active = false;
+    switch (getMotionJobResult(slot)) {
+      case JOB_RESULT_OK: sendStatus(pending.seq, BIN_STATUS_DONE, pending.op); break;
+      case JOB_RESULT_ABORTED: sendErrorFrame(pending.seq, pending.op, BIN_ERR_ABORTED); break;
+      default: sendErrorFrame(pending.seq, pending.op, BIN_ERR_FAILED); break;
+    }
+  }
+
+  if (pendingBatch.active && !isHomingBatchActive()) {
+    pendingBatch.active = false;
+    uint8_t failed = getHomingBatchFailed();
+    if (failed) {
+      uint8_t payload[2] = {BIN_ERR_FAILED, failed};
+      sendFrame(pendingBatch.seq, BIN_STATUS_ERR, pendingBatch.op, payload, sizeof(payload));
+    } else {
+      sendStatus(pendingBatch.seq, BIN_STATUS_DONE, pendingBatch.op);
+    }
+  }
+
+  if (pendingRecipe.active) {
+    // Событие на каждый завершённый шаг, затем итог с тем же SEQ
+    uint8_t done = getRecipeStepsDone();
+    while (recipeStepsReported < done) {
+      recipeStepsReported++;
+      sendBinaryEvent(pendingRecipe.seq, pendingRecipe.op, &recipeStepsReported, 1);
+    }
+    if (!isRecipeActive()) {
+      pendingRecipe.active = false;
+      const char* error = getLastRecipeError();
+      if (error) {
+        uint8_t payload[2] = {(uint8_t)(strcmp(error, MSG_JOB_ABORTED) == 0 ? BIN_ERR_ABORTED : BIN_ERR_FAILED), done};
+        sendFrame(pendingRecipe.seq, BIN_STATUS_ERR, pendingRecipe.op, payload, sizeof(payload));
+      } else {
+        sendStatus(pendingRecipe.seq, BIN_STATUS_DONE, pendingRecipe.op);
+      }
+    }
+  }
+}
+
+static void clearPendingReplies() {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) pendingJobs[i].active = false;
+  pendingBatch.active = false;
+  pendingRecipe.active = false;
+}
+
+// ============== ВЫПОЛНЕНИЕ КОМАНД ==============
+static int32_t readArg(uint8_t index) {
+  const uint8_t* p = &rxBody[3 + index * 4];
+  return (int32_t)((uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24));
+}
+
+static void executeFrame() {
+  uint8_t seq = rxBody[0];
+  uint8_t op = rxBody[1];
+  uint8_t axis = rxBody[2];
+  uint8_t argCount = (rxLen - 3) / 4;
+  const int32_t allAxes = (1 << STEP_ENGINE_AXES) - 1;
+
+  // Операции с осью и обязательные аргументы
+  bool needsAxis = op == BIN_OP_MOVE || op == BIN_OP_HOME || op == BIN_OP_POSITION;
+  uint8_t needsArgs = (op == BIN_OP_MOVE || op == BIN_OP_HOME_MASK || op == BIN_OP_CLAMP ||
+                       op == BIN_OP_OUTPUT) ? 1 : (op == BIN_OP_RECIPE_STEP ? 2 : 0);
+  if ((needsAxis && axis >= STEP_ENGINE_AXES) || argCount < needsArgs) {
+    sendErrorFrame(seq, op, BIN_ERR_PARAM);
+    return;
+  }
+
+  StepperType type = (StepperType)axis;
+  switch (op) {
+    case BIN_OP_PING: {
+      int32_t version = BIN_PROTOCOL_VERSION;
+      sendValues(seq, op, &version, 1);
+      break;
+    }
+
+    case BIN_OP_MOVE:
+      startJobReply(type, startMoveJob(type, readArg(0), false), seq, op);
+      break;
+
+    case BIN_OP_HOME:
+      startJobReply(type, startHomeJob(type, false), seq, op);
+      break;
+
+    case BIN_OP_HOME_MASK: {
+      int32_t mask = readArg(0);
+      if (mask <= 0 || mask > allAxes) {
+        sendErrorFrame(seq, op, BIN_ERR_PARAM);
+      } else if (pendingBatch.active || !startHomingBatch((uint8_t)mask, false)) {
+        sendErrorFrame(seq, op, isHomingBatchActive() ? BIN_ERR_BUSY : BIN_ERR_PARAM);
+      } else {
+        pendingBatch.active = true;
+        pendingBatch.seq = seq;
+        pendingBatch.op = op;
+        sendStatus(seq, BIN_STATUS_ACK, op);
+      }
+      break;
+    }
+
+    case BIN_OP_CLAMP:
+      startJobReply(STEPPER_E0, startClampJob(readArg(0), false), seq, op);
+      break;
+
+    case BIN_OP_CLAMP_ZERO:
+      startJobReply(STEPPER_E0, startClampZeroJob(false), seq, op);
+      break;
+
+    case BIN_OP_STOP: {
+      int32_t mask = argCount ? readArg(0) : 0;
+      abortMotionJobs(mask ? (uint8_t)(mask & allAxes) : (uint8_t)allAxes);
+      sendStatus(seq, BIN_STATUS_DONE, op);
+      break;
+    }
+
+    case BIN_OP_POSITION: {
+      int32_t position = stepEngineGetPosition(type);
+      sendValues(seq, op, &position, 1);
+      break;
+    }
+
+    case BIN_OP_STATUS: {
+      int32_t masks[2] = {0, 0};
+      for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+        if (isAxisBusy((StepperType)i)) masks[0] |= STEP_ENGINE_AXIS_BIT(i);
+        if (isAxisHomed((StepperType)i)) masks[1] |= STEP_ENGINE_AXIS_BIT(i);
+      }
+      sendValues(seq, op, masks, 2);
+      break;
+    }
+
+    case BIN_OP_WEIGHT: {
+      float units = scale.getUnits(5) * 100.0;
+      int32_t weight = (int32_t)(units < 0 ? units - 0.5 : units + 0.5);
+      sendValues(seq, op, &weight, 1);
+      break;
+    }
+
+    case BIN_OP_TELEMETRY:
+      if (argCount < 1 || readArg(0) < 0 || readArg(0) > TELEMETRY_MAX_HZ || !setTelemetryRate((uint8_t)readArg(0))) {
+        sendErrorFrame(seq, op, BIN_ERR_PARAM);
+      } else {
+        sendStatus(seq, BIN_STATUS_DONE, op);
+      }
+      break;
+
+    case BIN_OP_OUTPUT: {
+      bool state = readArg(0) != 0;
+      switch (axis) {
+        case 0: setPumpState(state); break;
+        case 1: setValveState(KL1_PIN, state); break;
+        case 2: setValveState(KL2_PIN, state); break;
+        default: sendErrorFrame(seq, op, BIN_ERR_PARAM); return;
+      }
+      sendStatus(seq, BIN_STATUS_DONE, op);
+      break;
+    }
+
+    case BIN_OP_RECIPE_STEP: {
+      int32_t code = readArg(0);
+      RecipeStep step = {(uint8_t)(code & 0xFF), (uint8_t)((code >> 8) & 0xFF), readArg(1)};
+      // Шаги передаются по порядку, шаг 0 начинает новый рецепт
+      if (axis == 0 && !clearRecipeBuffer()) {
+        sendErrorFrame(seq, op, BIN_ERR_BUSY);
+      } else if (axis != getRecipeLength(RECIPE_RAM_ID) || !appendRecipeStep(step)) {
+        sendErrorFrame(seq, op, BIN_ERR_PARAM);
+      } else {
+        sendStatus(seq, BIN_STATUS_DONE, op);
+      }
+      break;
+    }
+
+    case BIN_OP_RECIPE_SAVE:
+      if (axis >= RECIPE_SLOTS || getRecipeLength(RECIPE_RAM_ID) == 0) {
+        sendErrorFrame(seq, op, BIN_ERR_PARAM);
+      } else if (!saveRecipe(axis)) {
+        sendErrorFrame(seq, op, BIN_ERR_BUSY);
+      } else {
+        sendStatus(seq, BIN_STATUS_DONE, op);
+      }
+      break;
+
+    case BIN_OP_RECIPE_RUN:
+      if (!startRecipe(axis, false)) {
+        sendErrorFrame(seq, op, isRecipeActive() ? BIN_ERR_BUSY : BIN_ERR_PARAM);
+      } else {
+        pendingRecipe.active = true;
+        pendingRecipe.seq = seq;
+        pendingRecipe.op = op;
+        recipeStepsReported = 0;
+        sendStatus(seq, BIN_STATUS_ACK, op);
+      }
+      break;
+
+    case BIN_OP_RECIPE_STOP:
+      abortRecipe();
+      sendStatus(seq, BIN_STATUS_DONE, op);
+      break;
+
+    case BIN_OP_TEXT_MODE:
+      sendStatus(seq, BIN_STATUS_DONE, op);
+      Serial.flush();
+      binaryMode = false;
+      setLogMuted(false);
+      clearPendingReplies();
+      break;
+
+    default:
+      sendErrorFrame(seq, op, BIN_ERR_UNKNOWN_OP);
+      break;
+  }
+}
+
+// ============== ПРИЁМ КАДРОВ ==============
+static void receiveByte(uint8_t b) {
+  switch (rxState) {
+    case RX_SYNC:
+      if (b == BIN_SYNC) rxState = RX_LEN;
+      break;
+
+    case RX_LEN:
+      // SEQ OP AXIS и целое число аргументов int32
+      if (b < 3 || b > sizeof(rxBody) || (b - 3) % 4 != 0) {
+        rxState = (b == BIN_SYNC) ? RX_LEN : RX_SYNC;
+        break;
+      }
+      rxLen = b;
+      rxCount = 0;
+      rxCrc = _crc_ccitt_update(0xFFFF, b);
+      rxState = RX_BODY;
+      break;
+
+    case RX_BODY:
+      rxBody[rxCount++] = b;
+      rxCrc = _crc_ccitt_update(rxCrc, b);
+      if (rxCount == rxLen) rxState = RX_CRC_LO;
+      break;
+
+    case RX_CRC_LO:
+      rxCrc ^= b;
+      rxState = RX_CRC_HI;
+      break;
+
+    case RX_CRC_HI:
+      rxCrc ^= (uint16_t)b << 8;
+      rxState = RX_SYNC;
+      if (rxCrc == 0) {
+        executeFrame();
+      } else {
+        uint8_t code = BIN_ERR_CRC;
+        sendFrame(rxBody[0], BIN_STATUS_NAK, rxBody[1], &code, 1);
+      }
+      break;
+  }
+}
+
+// ============== ИНТЕРФЕЙС ==============
+void sendBinaryEvent(uint8_t seq, uint8_t op, const uint8_t* payload, uint8_t length) {
+  sendFrame(seq, BIN_STATUS_EVENT, op, payload, length);
+}
+
+void enterBinaryMode() {
+  clearPendingReplies();
+  rxState = RX_SYNC;
+  binaryMode = true;
+  setLogMuted(true);
+}
+
+bool isBinaryMode() {
+  return binaryMode;
+}
+
+void serviceBinaryProtocol() {
+  if (!binaryMode) return;
+
+  // Оборванный кадр - ждём новый байт синхронизации
+  if (rxState != RX_SYNC && millis() - rxLastByteTime > BIN_BYTE_TIMEOUT_MS) {
+    rxState = RX_SYNC;
+  }
+
+  while (binaryMode && Serial.available() > 0) {
+    rxLastByteTime = millis();
+    receiveByte((uint8_t)Serial.read());
+  }
+
+  if (binaryMode) servicePendingReplies();
+}
+
+uint16_t getBinaryProtocolMemory() {
+  return sizeof(rxBody) + sizeof(pendingJobs) + sizeof(pendingBatch) + sizeof(pendingRecipe);
+}
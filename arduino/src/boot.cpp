@@ -0,0 +1,126 @@
+/**
+ * @file: boot.cpp
+ * @description: Быстрый старт: калибровка весов в EEPROM и фоновая самопроверка датчика
+ * @dependencies: weight_sampler, binary_protocol, NBHX711, EEPROM, config.h
+ * @created: 2026-10-14
+ *
+ * Раньше каждое включение ждало отсчётов HX711 и снимало тару заново, а коэффициент
+ * calibrate_weight_factor терялся при сбросе. Теперь коэффициент и тара читаются из EEPROM
+ * сразу, и контроллер отвечает на команды, пока датчик веса проверяется в фоне из loop().
+ * Без записи калибровки тара снимается по отсчётам самопроверки, как прежде при старте.
+ */
+
+#include "boot.h"
+#include "weight_sampler.h"
+#include "binary_protocol.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <NBHX711.h>
+#include <util/crc16.h>
+
+extern NBHX711 scale;
+
+// Запись EEPROM: WEIGHT_CAL_MAGIC, WeightCalibration, CRC16 LE по WeightCalibration
+#define WEIGHT_CAL_MAGIC 0x3C
+
+typedef struct {
+  float factor;
+  int32_t offset;
+} WeightCalibration;
+
+#define WEIGHT_CAL_RECORD_SIZE (1 + sizeof(WeightCalibration) + 2)
+
+static_assert(WEIGHT_CAL_EEPROM_BASE + WEIGHT_CAL_RECORD_SIZE <= TUNE_EEPROM_BASE,
+              "Калибровка весов заходит на пределы осей");
+
+static bool calibrationStored = false;
+static SelfTestState selfTestState = SELFTEST_OK;
+static uint32_t selfTestTarget = 0;
+static unsigned long selfTestStart = 0;
+
+// ============== КАЛИБРОВКА ВЕСОВ ==============
+static uint16_t calibrationCrc(const WeightCalibration& calibration) {
+  const uint8_t* bytes = (const uint8_t*)&calibration;
+  uint16_t crc = 0xFFFF;
+  for (uint8_t i = 0; i < sizeof(WeightCalibration); i++) crc = _crc_ccitt_update(crc, bytes[i]);
+  return crc;
+}
+
+bool loadWeightCalibration() {
+  WeightCalibration calibration;
+  EEPROM.get(WEIGHT_CAL_EEPROM_BASE + 1, calibration);
+  int crcAddress = WEIGHT_CAL_EEPROM_BASE + 1 + sizeof(WeightCalibration);
+  uint16_t stored = EEPROM.read(crcAddress) | ((uint16_t)EEPROM.read(crcAddress + 1) << 8);
+
+  calibrationStored = EEPROM.read(WEIGHT_CAL_EEPROM_BASE) == WEIGHT_CAL_MAGIC &&
+                      stored == calibrationCrc(calibration) && calibration.factor != 0.0;
+  if (calibrationStored) {
+    scale.setScale(calibration.factor);
+    scale.setOffset(calibration.offset);
+  } else {
+    scale.setScale(WEIGHT_SCALE_FACTOR);
+  }
+  return calibrationStored;
+}
+
+void saveWeightCalibration() {
+  WeightCalibration calibration = {scale.getScale(), (int32_t)scale.getOffset()};
+  uint16_t crc = calibrationCrc(calibration);
+  int crcAddress = WEIGHT_CAL_EEPROM_BASE + 1 + sizeof(WeightCalibration);
+
+  EEPROM.put(WEIGHT_CAL_EEPROM_BASE + 1, calibration);
+  EEPROM.update(crcAddress, crc & 0xFF);
+  EEPROM.update(crcAddress + 1, crc >> 8);
+  EEPROM.update(WEIGHT_CAL_EEPROM_BASE, WEIGHT_CAL_MAGIC);
+  calibrationStored = true;
+}
+
+bool isWeightCalibrationStored() {
+  return calibrationStored;
+}
+
+// ============== САМОПРОВЕРКА ==============
+void startSelfTest() {
+  selfTestTarget = getWeightSampleCount() + SELFTEST_WEIGHT_SAMPLES;
+  selfTestStart = millis();
+  selfTestState = SELFTEST_PENDING;
+}
+
+void serviceSelfTest() {
+  if (selfTestState != SELFTEST_PENDING) return;
+
+  if ((int32_t)(getWeightSampleCount() - selfTestTarget) >= 0) {
+    // tare() усредняет последние отсчёты истории - все они сняты после старта
+    if (!calibrationStored) scale.tare();
+    selfTestState = SELFTEST_OK;
+  } else if (millis() - selfTestStart > SELFTEST_TIMEOUT_MS) {
+    selfTestState = SELFTEST_FAILED;
+  } else {
+    return;
+  }
+
+  if (!isBinaryMode()) printSelfTest();
+}
+
+bool waitSelfTest() {
+  while (selfTestState == SELFTEST_PENDING) {
+    serviceWeightSampler();
+    serviceSelfTest();
+  }
+  return selfTestState == SELFTEST_OK;
+}
+
+SelfTestState getSelfTestState() {
+  return selfTestState;
+}
+
+void printSelfTest() {
+  Serial.print(F("SELFTEST weight="));
+  switch (selfTestState) {
+    case SELFTEST_PENDING: Serial.print(F("pending")); break;
+    case SELFTEST_OK: Serial.print(F("ok")); break;
+    default: Serial.print(F("fail")); break;
+  }
+  Serial.print(F(" calibration="));
+  Serial.println(calibrationStored ? F("eeprom") : F("default"));
+}
@@ -1,7 +1,7 @@
 /**
  * @file: commands.cpp
  * @description: Модуль обработки команд с улучшенной архитектурой и обработкой ошибок
- * @dependencies: SerialCommand, NBHX711, stepper_control, sensors, valves
+ * @dependencies: SerialCommand, NBHX711, stepper_control, motion_jobs, sensors, valves, binary_protocol, weight_sampler, dosing, telemetry
  * @created: 2024-12-19
  */
 
@@ -11,15 +11,23 @@
 #include <GyverStepper2.h>
 #include "config.h"
 #include "stepper_control.h"
+#include "step_engine.h"
+#include "motion_jobs.h"
 #include "sensors.h"
 #include "valves.h"
+#include "binary_protocol.h"
+#include "weight_sampler.h"
+#include "dosing.h"
+#include "telemetry.h"
+#include "recipe.h"
+#include "axis_tune.h"
+#include "boot.h"
+#include "perf.h"
+#include "log.h"
 #include <SerialCommand.h>
 
 // ============== ВНЕШНИЕ ПЕРЕМЕННЫЕ ==============
 extern NBHX711 scale;
-extern bool autoReportWeight;
-extern void enableWeightReport();
-extern void disableWeightReport();
 extern void resetClampFlag();
 
 // Обработчики команд
@@ -28,16 +36,27 @@ void handleClampStop();
 // Экземпляр обработчика команд
 SerialCommand sCmd;
 
+// Шаг пакета: ответы обработчика не выводятся, первая ошибка запоминается
+static bool batchActive = false;
+static const char* batchStepError = nullptr;
+
 // ============== СЛУЖЕБНЫЕ ФУНКЦИИ ==============
 void sendReceived() {
+  if (batchActive) return;
+  perfCommandDispatched();
   Serial.println(MSG_RECEIVED);
 }
 
 void sendCompleted() {
+  if (batchActive) return;
   Serial.println(MSG_COMPLETED);
 }
 
 void sendError(const char* errorMsg) {
+  if (batchActive) {
+    if (!batchStepError) batchStepError = errorMsg;
+    return;
+  }
   Serial.print(MSG_ERROR);
   Serial.print(": ");
   Serial.println(errorMsg);
@@ -48,6 +67,79 @@ void handleUnrecognized(const char* command) {
   Serial.println(command);
 }
 
+// ============== ПАКЕТЫ КОМАНД ==============
+// "kl1_on; pump_on; move_multi 1200; kl1_off": один RECEIVED, шаги по порядку,
+// итог "COMPLETED batch" или "ERR: <код> <номер шага> batch" (шаги с 1).
+// На первой ошибке пакет останавливается, следующие шаги не выполняются.
+// В асинхронном режиме команды движения только запускают задания, поэтому
+// движения разных осей из одного пакета идут одновременно.
+static void finishBatch(const char* error, uint8_t stepNumber) {
+  if (error) {
+    Serial.print(MSG_ERROR);
+    Serial.print(F(": "));
+    Serial.print(error);
+    Serial.print(' ');
+    Serial.print(stepNumber);
+  } else {
+    Serial.print(MSG_COMPLETED);
+  }
+  Serial.println(F(" batch"));
+}
+
+// binary переключает порт в двоичный режим - в середине пакета ответ бы потерялся
+static bool isBatchStepAllowed(const char* step) {
+  if (strncmp(step, "binary", 6) == 0 && (step[6] == ' ' || step[6] == '\0')) return false;
+  return sCmd.hasCommand(step);
+}
+
+static void runBatch(char* line) {
+  char* steps[COMMAND_BATCH_MAX_STEPS];
+  uint8_t count = 0;
+  const char separator[2] = {COMMAND_BATCH_SEPARATOR, '\0'};
+  char* save = nullptr;
+  
+  sendReceived();
+  
+  // Разбор и проверка имён до выполнения: неизвестная команда не оставляет пакет выполненным наполовину
+  for (char* step = strtok_r(line, separator, &save); step; step = strtok_r(nullptr, separator, &save)) {
+    while (*step == ' ') step++;
+    if (*step == '\0') continue;
+    if (count == COMMAND_BATCH_MAX_STEPS) {
+      finishBatch(MSG_BATCH_TOO_LONG, count + 1);
+      return;
+    }
+    if (!isBatchStepAllowed(step)) {
+      finishBatch(MSG_UNKNOWN_COMMAND, count + 1);
+      return;
+    }
+    steps[count++] = step;
+  }
+  
+  const char* error = nullptr;
+  uint8_t index = 0;
+  batchActive = true;
+  for (; index < count && !error; index++) {
+    batchStepError = nullptr;
+    sCmd.dispatch(steps[index]);
+    error = batchStepError;
+  }
+  batchActive = false;
+  
+  finishBatch(error, index);
+}
+
+static void handleCommandLine(char* line) {
+  if (strchr(line, COMMAND_BATCH_SEPARATOR)) {
+    runBatch(line);
+  } else {
+    sCmd.dispatch(line);
+  }
+}
+
+static void handleLineOverflow() {
+  sendError(MSG_LINE_TOO_LONG);
+}
+
 void testCommand() {
   Serial.println(F("RECEIVED"));
   Serial.println(F("Test command successful!"));
@@ -76,6 +168,8 @@ void setupCommandHandlers() {
   sCmd.addCommand("zero_rright", handleZeroRRight);
   sCmd.addCommand("zero_e0", handleZeroE0);
   sCmd.addCommand("zero_e1", handleZeroE1);
+  sCmd.addCommand("zero_all", handleZeroAll);
+  sCmd.addCommand("zero", handleZeroMask);
   
   // Команды насоса
   sCmd.addCommand("pump_on", handlePumpOn);
@@ -88,12 +182,23 @@ void setupCommandHandlers() {
   sCmd.addCommand("kl2_on", handleKl2On);
   sCmd.addCommand("kl1_off", handleKl1Off);
   sCmd.addCommand("kl2_off", handleKl2Off);
+  sCmd.addCommand("pulse", handlePulse);
 
   // Команды датчиков
   sCmd.addCommand("weight", handleWeight);
   sCmd.addCommand("raw_weight", handleRawWeight);
   sCmd.addCommand("calibrate_weight", handleCalibrateWeight);
   sCmd.addCommand("calibrate_weight_factor", handleCalibrateWeightFactor);
+  sCmd.addCommand("selftest", handleSelfTest);
+  sCmd.addCommand("weight_filter", handleWeightFilter);
+  sCmd.addCommand("weight_outlier", handleWeightOutlier);
+  sCmd.addCommand("weight_report_on", handleWeightReportOn);
+  sCmd.addCommand("weight_report_off", handleWeightReportOff);
+  sCmd.addCommand("telemetry", handleTelemetry);
+  
+  // Дозирование
+  sCmd.addCommand("dose", handleDose);
+  sCmd.addCommand("dose_stop", handleDoseStop);
   sCmd.addCommand("staterotor", handleStateRotor);
   sCmd.addCommand("waste", handleWaste);
   
@@ -103,41 +208,86 @@ void setupCommandHandlers() {
   sCmd.addCommand("check_rright_endstop", handleCheckRRightEndstop);
   sCmd.addCommand("check_all_endstops", handleCheckAllEndstops);
   sCmd.addCommand("check_enable_pins", handleCheckEnablePins);
+  sCmd.addCommand("engine_stats", handleEngineStats);
+  sCmd.addCommand("perf", handlePerf);
+  sCmd.addCommand("mem", handleMem);
+
+  // Асинхронные задания движения
+  sCmd.addCommand("async_on", handleAsyncOn);
+  sCmd.addCommand("async_off", handleAsyncOff);
+  sCmd.addCommand("jobs", handleJobs);
+  sCmd.addCommand("binary", handleBinaryMode);
+
+  // Команды рецептов
+  sCmd.addCommand("recipe_new", handleRecipeNew);
+  sCmd.addCommand("recipe_add", handleRecipeAdd);
+  sCmd.addCommand("recipe_save", handleRecipeSave);
+  sCmd.addCommand("recipe_list", handleRecipeList);
+  sCmd.addCommand("run_recipe", handleRunRecipe);
+  sCmd.addCommand("stop_recipe", handleStopRecipe);
+
+  // Перемешивание
+  sCmd.addCommand("agitate", handleAgitate);
+  sCmd.addCommand("agitate_stop", handleAgitateStop);
+
+  // Подбор пределов осей
+  sCmd.addCommand("tune", handleTune);
+  sCmd.addCommand("tune_stop", handleTuneStop);
+  sCmd.addCommand("tune_limits", handleTuneLimits);
 
-  // Тестовая команда
+  // Тестовая команда и справка
   sCmd.addCommand("test", testCommand);
+  sCmd.addCommand("help", handleHelp);
 
   sCmd.setDefaultHandler(handleUnrecognized);
+  sCmd.setLineHandler(handleCommandLine);
+  sCmd.setOverflowHandler(handleLineOverflow);
   
+  if (sCmd.getDroppedCount()) {
+    Serial.print(F("Ошибка: не зарегистрировано команд (SERIALCOMMAND_MAX_COMMANDS): "));
+    Serial.println(sCmd.getDroppedCount());
+  }
   Serial.println(F("Регистрация обработчиков завершена."));
 }
 
-// ============== ОБРАБОТЧИКИ КОМАНД ДВИЖЕНИЯ ==============
-void handleMoveMulti() {
-  sendReceived();
-  char* arg = sCmd.next();
-  if (!arg) {
-    sendError(MSG_MISSING_PARAMETER);
-    return;
-  }
-  
-  long position = atol(arg);
-  if (position == 0) {
-    sendError(MSG_INVALID_PARAMETER);
+// ============== ЗАДАНИЯ ДВИЖЕНИЯ ==============
+// Завершение команды движения: в асинхронном режиме ответ придёт событием
+// "COMPLETED <ось>", в обычном - ожидаем задание как раньше
+static void finishMotionCommand(StepperType slot, bool started, const char* errorCode) {
+  if (!started) {
+    sendError(isAxisBusy(slot) ? MSG_AXIS_BUSY : errorCode);
     return;
   }
   
-  Serial.print(F("Движение Multi к позиции: "));
-  Serial.println(position);
+  if (isAsyncMode()) return;
   
-  if (setStepperPosition(multiStepper, position)) {
+  if (waitMotionJob(slot)) {
     sendCompleted();
   } else {
-    sendError("MOVE_FAILED");
+    sendError(errorCode);
   }
 }
 
-void handleMoveMultizone() {
+// Событие движения "<выход>@<шаг>=<0|1>": kl1@300=1 - открыть KL1 на 300-м шаге движения
+static bool parseMoveEvent(char* arg, StepEngineEvent& event) {
+  char* at = strchr(arg, '@');
+  char* eq = at ? strchr(at, '=') : nullptr;
+  if (!eq || eq[2] != '\0' || (eq[1] != '0' && eq[1] != '1')) return false;
+  
+  *at = '\0';
+  if (strcmp(arg, "kl1") == 0) event.pin = KL1_PIN;
+  else if (strcmp(arg, "kl2") == 0) event.pin = KL2_PIN;
+  else if (strcmp(arg, "pump") == 0) event.pin = PUMP_PIN;
+  else return false;
+  
+  long step = atol(at + 1);
+  if (step <= 0) return false;
+  event.step = step;
+  event.state = eq[1] == '1';
+  return true;
+}
+
+static void handleMoveAxis(StepperType type) {
   sendReceived();
   char* arg = sCmd.next();
   if (!arg) {
@@ -151,17 +301,75 @@ void handleMoveMultizone() {
     return;
   }
   
-  Serial.print(F("Движение Multizone к позиции: "));
-  Serial.println(position);
+  // События выходов по шагам движения, шаг не дальше длины пути
+  StepEngineEvent events[STEP_ENGINE_MAX_EVENTS];
+  uint8_t eventCount = 0;
+  long distance = labs(position - stepEngineGetPosition(type));
+  while ((arg = sCmd.next()) != nullptr) {
+    if (eventCount == STEP_ENGINE_MAX_EVENTS || !parseMoveEvent(arg, events[eventCount]) ||
+        (long)events[eventCount].step > distance) {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+    eventCount++;
+  }
   
-  if (setStepperPosition(multizoneSteper, position)) {
+  if (eventCount) {
+    // Дозирование само управляет насосом и клапанами
+    if (isDoseActive()) {
+      sendError(MSG_DOSE_BUSY);
+      return;
+    }
+    for (uint8_t i = 0; i < eventCount; i++) releaseValvePulse(events[i].pin);
+  }
+  
+  finishMotionCommand(type, startMoveJob(type, position, isAsyncMode(), events, eventCount), MSG_MOVE_FAILED);
+}
+
+static void handleZeroAxis(StepperType type) {
+  sendReceived();
+  finishMotionCommand(type, startHomeJob(type, isAsyncMode()), MSG_HOMING_TIMEOUT);
+}
+
+// ============== ОБРАБОТЧИКИ КОМАНД ДВИЖЕНИЯ ==============
+void handleMoveMulti() { handleMoveAxis(STEPPER_MULTI); }
+void handleMoveMultizone() { handleMoveAxis(STEPPER_MULTIZONE); }
+void handleMoveRRight() { handleMoveAxis(STEPPER_RRIGHT); }
+void handleMoveE0() { handleMoveAxis(STEPPER_E0); }
+void handleMoveE1() { handleMoveAxis(STEPPER_E1); }
+
+// ============== ОБРАБОТЧИКИ КОМАНД ХОМИНГА ==============
+void handleZeroMulti() { handleZeroAxis(STEPPER_MULTI); }
+void handleZeroMultizone() { handleZeroAxis(STEPPER_MULTIZONE); }
+void handleZeroRRight() { handleZeroAxis(STEPPER_RRIGHT); }
+void handleZeroE0() { handleZeroAxis(STEPPER_E0); }
+void handleZeroE1() { handleZeroAxis(STEPPER_E1); }
+
+static void runHomingBatch(uint8_t axisMask) {
+  if (!startHomingBatch(axisMask, isAsyncMode())) {
+    sendError(isHomingBatchActive() ? MSG_AXIS_BUSY : MSG_INVALID_PARAMETER);
+    return;
+  }
+  
+  if (isAsyncMode()) return;
+  
+  if (waitHomingBatch()) {
     sendCompleted();
   } else {
-    sendError("MOVE_FAILED");
+    Serial.print(F("Не обнулены оси, маска: "));
+    Serial.println(getHomingBatchFailed());
+    sendError(MSG_HOMING_TIMEOUT);
   }
 }
 
-void handleMoveRRight() {
+// zero_all - одновременный хоминг всех осей (E0/E1 - процедурой clamp_zero)
+void handleZeroAll() {
+  sendReceived();
+  runHomingBatch((1 << STEP_ENGINE_AXES) - 1);
+}
+
+// zero <маска> - хоминг выбранных осей: 1 Multi, 2 Multizone, 4 RRight, 8 E0, 16 E1
+void handleZeroMask() {
   sendReceived();
   char* arg = sCmd.next();
   if (!arg) {
@@ -169,153 +377,422 @@ void handleMoveRRight() {
     return;
   }
   
-  long position = atol(arg);
-  if (position == 0) {
+  int mask = atoi(arg);
+  if (mask <= 0 || mask >= (1 << STEP_ENGINE_AXES)) {
     sendError(MSG_INVALID_PARAMETER);
     return;
   }
   
-  Serial.print(F("Движение RRight к позиции: "));
-  Serial.println(position);
+  runHomingBatch((uint8_t)mask);
+}
+
+// async_on / async_off - режим ответа командами движения
+void handleAsyncOn() {
+  sendReceived();
+  setAsyncMode(true);
+  Serial.println(F("Асинхронный режим: команды движения отвечают COMPLETED <ось>"));
+  sendCompleted();
+}
+
+void handleAsyncOff() {
+  sendReceived();
+  setAsyncMode(false);
+  Serial.println(F("Асинхронный режим выключен"));
+  sendCompleted();
+}
+
+// jobs - активные задания движения по осям
+void handleJobs() {
+  sendReceived();
+  Serial.print(F("async="));
+  Serial.println(isAsyncMode() ? 1 : 0);
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    StepperType type = (StepperType)i;
+    if (!isMotionJobActive(type)) continue;
+    Serial.print(getMotionJobName(type));
+    Serial.print(F(": "));
+    switch (getMotionJobKind(type)) {
+      case JOB_MOVE: Serial.print(F("move")); break;
+      case JOB_HOME: Serial.print(F("zero")); break;
+      case JOB_CLAMP: Serial.print(F("clamp")); break;
+      case JOB_CLAMP_ZERO: Serial.print(F("clamp_zero")); break;
+      case JOB_AGITATE:
+        Serial.print(F("agitate, cycles="));
+        Serial.print(getAgitateCycles(type));
+        break;
+      default: break;
+    }
+    Serial.print(F(", pos="));
+    Serial.println(stepEngineGetPosition(type));
+  }
   
-  if (setStepperPosition(rRightStepper, position)) {
-    sendCompleted();
-  } else {
-    sendError("MOVE_FAILED");
+  Serial.print(F("homed="));
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    Serial.print(isAxisHomed((StepperType)i) ? '1' : '0');
+  }
+  Serial.println();
+  if (isHomingBatchActive()) Serial.println(F("zero: active"));
+  if (isDoseActive()) Serial.println(F("dose: active"));
+  if (isRecipeActive()) {
+    Serial.print(F("recipe: step "));
+    Serial.println(getRecipeStepsDone());
+  }
+  if (isAxisTuneActive()) Serial.println(F("tune: active"));
+  sendCompleted();
+}
+
+// binary - переход на двоичный протокол (binary_protocol.h), ответ COMPLETED - последняя текстовая строка
+void handleBinaryMode() {
+  sendReceived();
+  sendCompleted();
+  Serial.flush();
+  enterBinaryMode();
+}
+
+// ============== ОБРАБОТЧИКИ КОМАНД РЕЦЕПТОВ ==============
+// Выход по имени: 0 насос, 1 KL1, 2 KL2 (совпадает с порядком DoseActuator), -1 - неизвестен
+static int parseOutputName(const char* name) {
+  if (strcmp(name, "pump") == 0) return 0;
+  if (strcmp(name, "kl1") == 0) return 1;
+  if (strcmp(name, "kl2") == 0) return 2;
+  return -1;
+}
+
+// Ось по имени события (multi, multizone, rright, e0, e1), -1 - неизвестна
+static int parseAxisName(const char* name) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if (strcmp_P(name, (PGM_P)getAxisEventName((StepperType)i)) == 0) return i;
   }
+  return -1;
+}
+
+// Номер слота EEPROM, -1 - недопустим
+static int parseRecipeSlot(const char* arg) {
+  int id = atoi(arg);
+  if (id < 0 || id >= RECIPE_SLOTS || (id == 0 && arg[0] != '0')) return -1;
+  return id;
 }
 
-void handleMoveE0() {
+static long gramsToCentigrams(const char* arg) {
+  float centigrams = atof(arg) * 100.0;
+  return (long)(centigrams < 0 ? centigrams - 0.5 : centigrams + 0.5);
+}
+
+// recipe_new [слот] - очистка буфера рецепта или копия слота EEPROM для правки
+void handleRecipeNew() {
   sendReceived();
   char* arg = sCmd.next();
-  if (!arg) {
+  if (arg) {
+    int id = parseRecipeSlot(arg);
+    if (id < 0 || !loadRecipe(id)) {
+      sendError(id < 0 ? MSG_INVALID_PARAMETER : MSG_RECIPE_EMPTY);
+      return;
+    }
+  } else if (!clearRecipeBuffer()) {
+    sendError(MSG_RECIPE_BUSY);
+    return;
+  }
+  Serial.print(F("Шагов в буфере: "));
+  Serial.println(getRecipeLength(RECIPE_RAM_ID));
+  sendCompleted();
+}
+
+// recipe_add <шаг> [параметры] - шаг в конец буфера:
+//   move <ось> <позиция>, zero <маска>, clamp <позиция>, clamp_zero,
+//   output <pump|kl1|kl2> <0|1>, pulse <pump|kl1|kl2> <мс>, dose <pump|kl1|kl2> <г>,
+//   wait_weight <г>, delay <мс>
+void handleRecipeAdd() {
+  sendReceived();
+  char* opArg = sCmd.next();
+  if (!opArg) {
     sendError(MSG_MISSING_PARAMETER);
     return;
   }
-  
-  long position = atol(arg);
-  if (position == 0) {
+
+  RecipeStep step = {findRecipeOp(opArg), 0, 0};
+  char* first = sCmd.next();
+  char* second = sCmd.next();
+  bool needsFirst = step.op != RECIPE_CLAMP_ZERO;
+  bool needsSecond = step.op == RECIPE_MOVE || step.op == RECIPE_OUTPUT ||
+                     step.op == RECIPE_PULSE || step.op == RECIPE_DOSE;
+  if ((needsFirst && !first) || (needsSecond && !second)) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
+  }
+
+  int target = 0;
+  switch (step.op) {
+    case RECIPE_MOVE:
+      target = parseAxisName(first);
+      step.value = atol(second);
+      break;
+    case RECIPE_ZERO:
+      target = atoi(first);
+      break;
+    case RECIPE_CLAMP:
+    case RECIPE_DELAY:
+      step.value = atol(first);
+      break;
+    case RECIPE_OUTPUT:
+    case RECIPE_PULSE:
+      target = parseOutputName(first);
+      step.value = atol(second);
+      break;
+    case RECIPE_DOSE:
+      target = parseOutputName(first);
+      step.value = gramsToCentigrams(second);
+      break;
+    case RECIPE_WAIT_WEIGHT:
+      step.value = gramsToCentigrams(first);
+      break;
+    default:
+      break;
+  }
+
+  if (target < 0 || target > 255) {
     sendError(MSG_INVALID_PARAMETER);
     return;
   }
-  
-  Serial.print(F("Индивидуальное движение E0 к позиции: "));
-  Serial.println(position);
-  
-  if (moveE0(position)) {
-    sendCompleted();
-  } else {
-    sendError("MOVE_FAILED");
+  step.arg = (uint8_t)target;
+  if (!appendRecipeStep(step)) {
+    sendError(isRecipeActive() ? MSG_RECIPE_BUSY : MSG_INVALID_PARAMETER);
+    return;
   }
+
+  Serial.print(F("Шагов в буфере: "));
+  Serial.println(getRecipeLength(RECIPE_RAM_ID));
+  sendCompleted();
 }
 
-void handleMoveE1() {
+// recipe_save <слот> - запись буфера в EEPROM
+void handleRecipeSave() {
   sendReceived();
   char* arg = sCmd.next();
   if (!arg) {
     sendError(MSG_MISSING_PARAMETER);
     return;
   }
-  
-  long position = atol(arg);
-  if (position == 0) {
-    sendError(MSG_INVALID_PARAMETER);
+  int id = parseRecipeSlot(arg);
+  if (id < 0 || getRecipeLength(RECIPE_RAM_ID) == 0) {
+    sendError(id < 0 ? MSG_INVALID_PARAMETER : MSG_RECIPE_EMPTY);
     return;
   }
-  
-  Serial.print(F("Индивидуальное движение E1 к позиции: "));
-  Serial.println(position);
-  
-  if (moveE1(position)) {
-    sendCompleted();
-  } else {
-    sendError("MOVE_FAILED");
+  if (!saveRecipe(id)) {
+    sendError(MSG_RECIPE_BUSY);
+    return;
   }
+  Serial.print(F("Рецепт сохранён в слот "));
+  Serial.println(id);
+  sendCompleted();
 }
 
-// ============== ОБРАБОТЧИКИ КОМАНД ХОМИНГА ==============
-void handleZeroMulti() {
+// recipe_list [слот] - шаги рецепта (без параметра - буфер и занятость слотов)
+void handleRecipeList() {
   sendReceived();
-  Serial.println(F("Начало хоминга Multi..."));
-  
-  if (homeStepperMotor(multiStepper, MULTI_ENDSTOP_PIN)) {
-    Serial.println(F("Хоминг Multi завершен"));
-    sendCompleted();
+  char* arg = sCmd.next();
+  uint8_t id = RECIPE_RAM_ID;
+  if (arg) {
+    int slot = parseRecipeSlot(arg);
+    if (slot < 0) {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+    id = slot;
   } else {
-    sendError(MSG_HOMING_TIMEOUT);
+    Serial.print(F("Слоты:"));
+    for (uint8_t i = 0; i < RECIPE_SLOTS; i++) {
+      Serial.print(' ');
+      Serial.print(getRecipeLength(i));
+    }
+    Serial.println();
+  }
+
+  uint8_t length = getRecipeLength(id);
+  for (uint8_t i = 0; i < length; i++) {
+    RecipeStep step;
+    if (!getRecipeStep(id, i, step)) break;
+    Serial.print(i);
+    Serial.print(' ');
+    Serial.print(getRecipeOpName(step.op));
+    Serial.print(' ');
+    Serial.print(step.arg);
+    Serial.print(' ');
+    Serial.println(step.value);
   }
+  Serial.print(F("Шагов: "));
+  Serial.println(length);
+  sendCompleted();
 }
 
-void handleZeroMultizone() {
+// run_recipe [слот] - выполнение рецепта из EEPROM (без параметра - буфера),
+// строка "STEP <номер> <шаг>" после каждого шага
+void handleRunRecipe() {
   sendReceived();
-  Serial.println(F("Начало хоминга Multizone..."));
-  
-  if (homeStepperMotor(multizoneSteper, MULTIZONE_ENDSTOP_PIN)) {
-    Serial.println(F("Хоминг Multizone завершен"));
+  char* arg = sCmd.next();
+  int id = arg ? parseRecipeSlot(arg) : RECIPE_RAM_ID;
+  if (id < 0) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  if (!startRecipe(id, isAsyncMode())) {
+    sendError(getLastRecipeError());
+    return;
+  }
+
+  if (isAsyncMode()) return;
+
+  if (waitRecipe()) {
     sendCompleted();
   } else {
-    sendError(MSG_HOMING_TIMEOUT);
+    sendError(getLastRecipeError());
   }
 }
 
-void handleZeroRRight() {
+// stop_recipe - прерывание рецепта (в асинхронном режиме)
+void handleStopRecipe() {
   sendReceived();
-  Serial.println(F("Начало хоминга RRight..."));
-  
-  if (homeStepperMotor(rRightStepper, RRIGHT_ENDSTOP_PIN)) {
-    Serial.println(F("Хоминг RRight завершен"));
-    sendCompleted();
-  } else {
-    sendError(MSG_HOMING_TIMEOUT);
+  abortRecipe();
+  sendCompleted();
+}
+
+// ============== ОБРАБОТЧИКИ ПЕРЕМЕШИВАНИЯ ==============
+// agitate <ось> <ход> <скорость> <циклы|<время>ms> - ходы туда-обратно на <ход> шагов от
+// текущей позиции; ход 0 - вращение (знак скорости - направление), циклы - обороты.
+// Завершение - "COMPLETED <ось>", как у move; в асинхронном режиме ось работает в фоне
+void handleAgitate() {
+  sendReceived();
+  char* name = sCmd.next();
+  char* amplitude = sCmd.next();
+  char* speed = sCmd.next();
+  char* count = sCmd.next();
+  if (!name || !amplitude || !speed || !count) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
   }
+
+  int axis = parseAxisName(name);
+  char* unit;
+  unsigned long value = strtoul(count, &unit, 10);
+  bool timed = strcmp(unit, "ms") == 0;
+  if (axis < 0 || value == 0 || (*unit && !timed) || (!timed && value > 0xFFFF) || atoi(speed) == 0) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+
+  bool started = startAgitateJob((StepperType)axis, atol(amplitude), atoi(speed), timed ? 0 : value,
+                                 timed ? value : 0, isAsyncMode());
+  finishMotionCommand((StepperType)axis, started, MSG_AGITATE_FAILED);
 }
 
-void handleZeroE0() {
+// agitate_stop <ось> - завершение после текущего цикла (вращение - торможением)
+void handleAgitateStop() {
   sendReceived();
-  Serial.println(F("Начало индивидуального хоминга E0..."));
-  
-  if (homeE0()) {
-    Serial.println(F("Хоминг E0 завершен"));
-    sendCompleted();
-  } else {
-    sendError(MSG_HOMING_TIMEOUT);
+  char* name = sCmd.next();
+  int axis = name ? parseAxisName(name) : -1;
+  if (axis < 0) {
+    sendError(name ? MSG_INVALID_PARAMETER : MSG_MISSING_PARAMETER);
+    return;
   }
+  stopAgitateJob((StepperType)axis);
+  sendCompleted();
 }
 
-void handleZeroE1() {
+// ============== ОБРАБОТЧИКИ ПОДБОРА ПРЕДЕЛОВ ==============
+// tune <ось> <ход> [save] - подбор ускорения и скорости оси ходами между 1 и <ход>,
+// строка "TUNE <ось> accel=<a> speed=<v> drift=<d> ok|lost" после каждого уровня.
+// save - записать найденные пределы в EEPROM и применить
+void handleTune() {
   sendReceived();
-  Serial.println(F("Начало индивидуального хоминга E1..."));
-  
-  if (homeE1()) {
-    Serial.println(F("Хоминг E1 завершен"));
+  char* name = sCmd.next();
+  char* arg = sCmd.next();
+  if (!name || !arg) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
+  }
+  int axis = parseAxisName(name);
+  char* option = sCmd.next();
+  if (axis < 0 || (option && strcmp(option, "save") != 0)) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  if (!startAxisTune((StepperType)axis, atol(arg), option != nullptr, isAsyncMode())) {
+    sendError(getLastAxisTuneError());
+    return;
+  }
+
+  if (isAsyncMode()) return;
+
+  if (waitAxisTune()) {
     sendCompleted();
   } else {
-    sendError(MSG_HOMING_TIMEOUT);
+    sendError(getLastAxisTuneError());
+  }
+}
+
+// tune_stop - прерывание подбора (в асинхронном режиме)
+void handleTuneStop() {
+  sendReceived();
+  abortAxisTune();
+  sendCompleted();
+}
+
+// tune_limits [clear] - действующие скорость и ускорение осей и предел скорости таблицы
+// разгона; clear - вернуть значения config.h и стереть пределы в EEPROM
+void handleTuneLimits() {
+  sendReceived();
+  char* arg = sCmd.next();
+  if (arg) {
+    if (strcmp(arg, "clear") != 0) {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+    if (isAxisTuneActive()) {
+      sendError(MSG_AXIS_BUSY);
+      return;
+    }
+    clearAxisLimits();
+  }
+
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    StepperConfig config;
+    readStepperConfig((StepperType)i, config);
+    Serial.print(getAxisEventName((StepperType)i));
+    Serial.print(F(" max_speed="));
+    Serial.print(config.maxSpeed);
+    Serial.print(F(" acceleration="));
+    Serial.print(config.acceleration);
+    Serial.print(F(" ceiling="));
+    Serial.println(stepEngineGetSpeedCeiling((StepperType)i));
   }
+  sendCompleted();
 }
 
 // ============== ОБРАБОТЧИКИ КОМАНД НАСОСА ==============
 void handlePumpOn() {
   sendReceived();
-  Serial.print(F("Включение насоса (пин "));
-  Serial.print(PUMP_PIN);
-  Serial.println(F(")..."));
+  LOG_INFO({
+    Log.print(F("Включение насоса (пин "));
+    Log.print(PUMP_PIN);
+    Log.println(F(")..."));
+  });
   
   setPumpState(true);
   
-  Serial.println(F("Насос включен"));
+  LOG_INFO(Log.println(F("Насос включен")));
   sendCompleted();
 }
 
 void handlePumpOff() {
   sendReceived();
-  Serial.print(F("Выключение насоса (пин "));
-  Serial.print(PUMP_PIN);
-  Serial.println(F(")..."));
+  LOG_INFO({
+    Log.print(F("Выключение насоса (пин "));
+    Log.print(PUMP_PIN);
+    Log.println(F(")..."));
+  });
   
   setPumpState(false);
   
-  Serial.println(F("Насос выключен"));
+  LOG_INFO(Log.println(F("Насос выключен")));
   sendCompleted();
 }
 
@@ -334,13 +811,23 @@ void handleKl1() {
     return;
   }
   
-  Serial.print(F("Открытие клапана KL1 на "));
-  Serial.print(time);
-  Serial.println(F(" сотых секунды"));
+  LOG_INFO({
+    Log.print(F("Открытие клапана KL1 на "));
+    Log.print(time);
+    Log.println(F(" сотых секунды"));
+  });
   
-  openValveForTime(KL1_PIN, time);
+  if (!openValveForTime(KL1_PIN, time, isAsyncMode())) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  if (isAsyncMode()) return;
   
-  Serial.println(F("Клапан KL1 закрыт"));
+  if (!waitValvePulse(KL1_PIN)) {
+    sendError(MSG_JOB_ABORTED);
+    return;
+  }
+  LOG_INFO(Log.println(F("Клапан KL1 закрыт")));
   sendCompleted();
 }
 
@@ -358,68 +845,201 @@ void handleKl2() {
     return;
   }
   
-  Serial.print(F("Открытие клапана KL2 на "));
-  Serial.print(time);
-  Serial.println(F(" сотых секунды"));
+  LOG_INFO({
+    Log.print(F("Открытие клапана KL2 на "));
+    Log.print(time);
+    Log.println(F(" сотых секунды"));
+  });
   
-  openValveForTime(KL2_PIN, time);
+  if (!openValveForTime(KL2_PIN, time, isAsyncMode())) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  if (isAsyncMode()) return;
   
-  Serial.println(F("Клапан KL2 закрыт"));
+  if (!waitValvePulse(KL2_PIN)) {
+    sendError(MSG_JOB_ABORTED);
+    return;
+  }
+  LOG_INFO(Log.println(F("Клапан KL2 закрыт")));
   sendCompleted();
 }
 
 void handleKl1On() {
   sendReceived();
-  Serial.print(F("Включение клапана KL1 (пин "));
-  Serial.print(KL1_PIN);
-  Serial.println(F(")"));
+  LOG_INFO({
+    Log.print(F("Включение клапана KL1 (пин "));
+    Log.print(KL1_PIN);
+    Log.println(F(")"));
+  });
   
   turnValveOn(KL1_PIN);
   
-  Serial.println(F("Клапан KL1 включен"));
+  LOG_INFO(Log.println(F("Клапан KL1 включен")));
   sendCompleted();
 }
 
 void handleKl2On() {
   sendReceived();
-  Serial.print(F("Включение клапана KL2 (пин "));
-  Serial.print(KL2_PIN);
-  Serial.println(F(")"));
+  LOG_INFO({
+    Log.print(F("Включение клапана KL2 (пин "));
+    Log.print(KL2_PIN);
+    Log.println(F(")"));
+  });
   
   turnValveOn(KL2_PIN);
   
-  Serial.println(F("Клапан KL2 включен"));
+  LOG_INFO(Log.println(F("Клапан KL2 включен")));
   sendCompleted();
 }
 
 void handleKl1Off() {
   sendReceived();
-  Serial.print(F("Выключение клапана KL1 (пин "));
-  Serial.print(KL1_PIN);
-  Serial.println(F(")"));
+  LOG_INFO({
+    Log.print(F("Выключение клапана KL1 (пин "));
+    Log.print(KL1_PIN);
+    Log.println(F(")"));
+  });
   
   turnValveOff(KL1_PIN);
   
-  Serial.println(F("Клапан KL1 выключен"));
+  LOG_INFO(Log.println(F("Клапан KL1 выключен")));
   sendCompleted();
 }
 
 void handleKl2Off() {
   sendReceived();
-  Serial.print(F("Выключение клапана KL2 (пин "));
-  Serial.print(KL2_PIN);
-  Serial.println(F(")"));
+  LOG_INFO({
+    Log.print(F("Выключение клапана KL2 (пин "));
+    Log.print(KL2_PIN);
+    Log.println(F(")"));
+  });
   
   turnValveOff(KL2_PIN);
   
-  Serial.println(F("Клапан KL2 выключен"));
+  LOG_INFO(Log.println(F("Клапан KL2 выключен")));
+  sendCompleted();
+}
+
+// pulse <kl1|kl2|pump> <мс> [количество] [период мс] - серия импульсов по расписанию
+void handlePulse() {
+  sendReceived();
+  char* outputArg = sCmd.next();
+  char* onArg = sCmd.next();
+  if (!outputArg || !onArg) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
+  }
+  
+  int pin;
+  if (strcmp(outputArg, "kl1") == 0) {
+    pin = KL1_PIN;
+  } else if (strcmp(outputArg, "kl2") == 0) {
+    pin = KL2_PIN;
+  } else if (strcmp(outputArg, "pump") == 0) {
+    pin = PUMP_PIN;
+  } else {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  
+  char* countArg = sCmd.next();
+  char* periodArg = sCmd.next();
+  long onMs = atol(onArg);
+  long count = countArg ? atol(countArg) : 1;
+  // Период важен только для серии: одиночный импульс ограничен VALVE_PULSE_MAX_MS
+  long periodMs = count > 1 ? (periodArg ? atol(periodArg) : 2 * onMs) : 0;
+  if (onMs <= 0 || onMs > VALVE_PULSE_MAX_MS || count <= 0 || count > 65535 ||
+      periodMs > 65535 || !startValvePulse(pin, onMs, count, periodMs, isAsyncMode())) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  if (isAsyncMode()) return;
+  
+  if (waitValvePulse(pin)) {
+    sendCompleted();
+  } else {
+    sendError(MSG_JOB_ABORTED);
+  }
+}
+
+// ============== СПРАВКА И САМОПРОВЕРКА ==============
+void printHelp() {
+  Serial.println(F("Каждая команда выполняется полностью до завершения"));
+  Serial.println(F("async_on - команды движения отвечают сразу, затем COMPLETED <ось>"));
+  Serial.println();
+  Serial.println(F("Доступные команды:"));
+  Serial.println(F("Движение:"));
+  Serial.println(F("  - move_multi <позиция>"));
+  Serial.println(F("  - move_multizone <позиция>"));
+  Serial.println(F("  - move_rright <позиция>"));
+  Serial.println(F("  - move_e0 <позиция> (индивидуальное управление)"));
+  Serial.println(F("  - move_e1 <позиция> (индивидуальное управление)"));
+  Serial.println(F("Хоминг:"));
+  Serial.println(F("  - zero_multi, zero_multizone, zero_rright"));
+  Serial.println(F("  - zero_e0, zero_e1 (индивидуальный хоминг)"));
+  Serial.println(F("  - zero_all, zero <маска> (одновременный хоминг)"));
+  Serial.println(F("Clamp (E0/E1 синхронно):"));
+  Serial.println(F("  - clamp <позиция> (временное питание)"));
+  Serial.println(F("  - clamp_zero (временное питание)"));
+  Serial.println(F("  - clamp_stop"));
+  Serial.println(F("Клапаны:"));
+  Serial.println(F("  - kl1 <время>, kl2 <время>"));
+  Serial.println(F("  - kl1_on/off, kl2_on/off"));
+  Serial.println(F("  - pulse <kl1|kl2|pump> <мс> [количество] [период мс]"));
+  Serial.println(F("Насос:"));
+  Serial.println(F("  - pump_on/off"));
+  Serial.println(F("Дозирование:"));
+  Serial.println(F("  - dose <граммы> <pump|kl1|kl2>, dose_stop"));
+  Serial.println(F("Рецепты:"));
+  Serial.println(F("  - recipe_new [слот], recipe_add <шаг> [параметры]"));
+  Serial.println(F("  - recipe_save <слот>, recipe_list [слот]"));
+  Serial.println(F("  - run_recipe [слот], stop_recipe"));
+  Serial.println(F("Перемешивание:"));
+  Serial.println(F("  - agitate <ось> <ход> <скорость> <циклы|<мс>ms> (ход 0 - вращение), agitate_stop <ось>"));
+  Serial.println(F("Подбор пределов осей:"));
+  Serial.println(F("  - tune <ось> <ход> [save], tune_stop, tune_limits [clear]"));
+  Serial.println(F("Датчики:"));
+  Serial.println(F("  - weight, raw_weight"));
+  Serial.println(F("  - calibrate_weight, calibrate_weight_factor <коэффициент> (записываются в EEPROM)"));
+  Serial.println(F("  - selftest (итог самопроверки датчика веса при старте)"));
+  Serial.println(F("  - weight_report_on/off (телеметрия 1 Гц)"));
+  Serial.println(F("  - telemetry <гц> (0 - выключить)"));
+  Serial.println(F("  - weight_filter [mean|median|iir] [shift], weight_outlier <порог>"));
+  Serial.println(F("  - staterotor, waste"));
+  Serial.println(F("Диагностика:"));
+  Serial.println(F("  - check_all_endstops"));
+  Serial.println(F("  - check_enable_pins"));
+  Serial.println(F("  - engine_stats [reset]"));
+  Serial.println(F("  - perf [reset] (время цикла, команд, HX711, обработчиков шагов, ОЗУ)"));
+  Serial.println(F("  - mem (статическое ОЗУ по модулям, куча, свободная память)"));
+  Serial.println(F("  - async_on/off, jobs"));
+  Serial.println(F("  - binary (двоичный протокол, выход - кадр TEXT_MODE)"));
+  Serial.println(F("  - test, help"));
+  Serial.println();
+}
+
+// help - список команд (при FAST_BOOT при старте не выводится)
+void handleHelp() {
+  sendReceived();
+  printHelp();
+  sendCompleted();
+}
+
+// selftest - итог фоновой самопроверки датчика веса после старта
+void handleSelfTest() {
+  sendReceived();
+  printSelfTest();
   sendCompleted();
 }
 
 // ============== ОБРАБОТЧИКИ КОМАНД ДАТЧИКОВ ==============
 void handleWeight() {
   sendReceived();
-  Serial.println(F("Чтение веса..."));
+  LOG_INFO(Log.println(F("Чтение веса...")));
+  if (getWeightSampleAge() > WEIGHT_SAMPLE_STALE_MS) {
+    LOG_WARN(Log.println(F("Предупреждение: нет свежих отсчётов HX711")));
+  }
   float weight = scale.getUnits(5);
   Serial.println(weight, 2);
   sendCompleted();
@@ -427,7 +1047,7 @@ void handleWeight() {
 
 void handleRawWeight() {
   sendReceived();
-  Serial.println(F("Чтение сырого значения датчика веса..."));
+  LOG_INFO(Log.println(F("Чтение сырого значения датчика веса...")));
   long raw = scale.getRaw();
   Serial.println(raw);
   sendCompleted();
@@ -435,13 +1055,21 @@ void handleRawWeight() {
 
 void handleCalibrateWeight() {
   sendReceived();
-  Serial.println(F("Запуск процедуры обнуления датчика веса..."));
-  Serial.println(F("Убедитесь, что на весах ничего нет"));
+  LOG_INFO({
+    Log.println(F("Запуск процедуры обнуления датчика веса..."));
+    Log.println(F("Убедитесь, что на весах ничего нет"));
+  });
   
   delay(2000);
-  Serial.println(F("Начинаю обнуление..."));
+  LOG_INFO(Log.println(F("Начинаю обнуление...")));
+  // tare() усредняет 10 последних отсчётов - все они должны быть сняты после паузы
+  if (!waitWeightSamples(10, 2000)) {
+    sendError(MSG_WEIGHT_SENSOR);
+    return;
+  }
   scale.tare();
-  Serial.println(F("Датчик веса успешно обнулен!"));
+  saveWeightCalibration();
+  LOG_INFO(Log.println(F("Датчик веса успешно обнулен!")));
   
   sendCompleted();
 }
@@ -465,10 +1093,117 @@ void handleCalibrateWeightFactor() {
   Serial.println(factor);
   
   scale.setScale(factor);
+  saveWeightCalibration();
   
   sendCompleted();
 }
 
+static void printWeightFilter() {
+  Serial.print(F("Фильтр: "));
+  switch (scale.getFilter()) {
+    case FilterMedian: Serial.print(F("median")); break;
+    case FilterIIR: Serial.print(F("iir")); break;
+    default: Serial.print(F("mean")); break;
+  }
+  Serial.print(F(", отброшено выбросов: "));
+  Serial.println(scale.getRejectCount());
+}
+
+// weight_filter [mean|median|iir] [shift] - фильтр для weight/getUnits, без параметров - текущий
+void handleWeightFilter() {
+  sendReceived();
+  
+  char* arg = sCmd.next();
+  if (arg) {
+    char* shiftArg = sCmd.next();
+    int shift = shiftArg ? atoi(shiftArg) : WEIGHT_FILTER_IIR_SHIFT;
+    if (shift < 1 || shift > NBHX711_IIR_FRACTION) {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+    
+    if (strcmp(arg, "mean") == 0) {
+      scale.setFilter(FilterMean);
+    } else if (strcmp(arg, "median") == 0) {
+      scale.setFilter(FilterMedian);
+    } else if (strcmp(arg, "iir") == 0) {
+      scale.setFilter(FilterIIR, (byte)shift);
+    } else {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+  }
+  
+  printWeightFilter();
+  sendCompleted();
+}
+
+// weight_outlier <порог> - отбрасывать одиночные скачки больше порога (сырых единиц), 0 - выключить
+void handleWeightOutlier() {
+  sendReceived();
+  
+  char* arg = sCmd.next();
+  if (!arg) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
+  }
+  
+  long limit = atol(arg);
+  if (limit < 0) {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  
+  scale.setOutlierLimit(limit);
+  Serial.print(F("Порог выбросов: "));
+  Serial.println(limit);
+  sendCompleted();
+}
+
+// ============== ОБРАБОТЧИКИ КОМАНД ДОЗИРОВАНИЯ ==============
+// dose <граммы> <pump|kl1|kl2> - включение устройства и отсечка по весу
+void handleDose() {
+  sendReceived();
+  char* gramsArg = sCmd.next();
+  char* actuatorArg = sCmd.next();
+  if (!gramsArg || !actuatorArg) {
+    sendError(MSG_MISSING_PARAMETER);
+    return;
+  }
+  
+  DoseActuator actuator;
+  if (strcmp(actuatorArg, "pump") == 0) {
+    actuator = DOSE_PUMP;
+  } else if (strcmp(actuatorArg, "kl1") == 0) {
+    actuator = DOSE_KL1;
+  } else if (strcmp(actuatorArg, "kl2") == 0) {
+    actuator = DOSE_KL2;
+  } else {
+    sendError(MSG_INVALID_PARAMETER);
+    return;
+  }
+  
+  if (!startDose(atof(gramsArg), actuator, isAsyncMode())) {
+    sendError(getLastDoseError());
+    return;
+  }
+  
+  if (isAsyncMode()) return;
+  
+  if (waitDose()) {
+    sendCompleted();
+  } else {
+    sendError(getLastDoseError());
+  }
+}
+
+// dose_stop - прерывание дозирования (в асинхронном режиме)
+void handleDoseStop() {
+  sendReceived();
+  abortDose();
+  sendCompleted();
+}
+
 void handleStateRotor() {
   sendReceived();
   char state[5];
@@ -496,28 +1231,47 @@ void handleWeightReportOff() {
   sendCompleted();
 }
 
+// telemetry <гц> - поток TLM-строк (в двоичном режиме - кадров), 0 - выключить; без параметра - текущая частота
+void handleTelemetry() {
+  sendReceived();
+  char* arg = sCmd.next();
+  if (arg) {
+    int hz = atoi(arg);
+    if (hz < 0 || (hz == 0 && arg[0] != '0') || !setTelemetryRate((uint8_t)min(hz, 255))) {
+      sendError(MSG_INVALID_PARAMETER);
+      return;
+    }
+  }
+  
+  Serial.print(F("Телеметрия: "));
+  Serial.print(getTelemetryRate());
+  Serial.print(F(" Гц, пропущено кадров: "));
+  Serial.println(getTelemetryDropped());
+  sendCompleted();
+}
+
 // ============== ОБРАБОТЧИКИ ДИАГНОСТИЧЕСКИХ КОМАНД ==============
+static void printAxisEndstop(StepperType type, const __FlashStringHelper* separator, bool state) {
+  Serial.print(getAxisName(type));
+  Serial.print(separator);
+  Serial.println(state ? F("TRIGGERED") : F("NOT TRIGGERED"));
+}
+
 void handleCheckMultiEndstop() {
   sendReceived();
-  bool state = readEndstopState(MULTI_ENDSTOP_PIN);
-  Serial.print("Multi endstop: ");
-  Serial.println(state ? "TRIGGERED" : "NOT TRIGGERED");
+  printAxisEndstop(STEPPER_MULTI, F(" endstop: "), readAxisEndstop(STEPPER_MULTI));
   sendCompleted();
 }
 
 void handleCheckMultizoneEndstop() {
   sendReceived();
-  bool state = readEndstopState(MULTIZONE_ENDSTOP_PIN);
-  Serial.print("Multizone endstop: ");
-  Serial.println(state ? "TRIGGERED" : "NOT TRIGGERED");
+  printAxisEndstop(STEPPER_MULTIZONE, F(" endstop: "), readAxisEndstop(STEPPER_MULTIZONE));
   sendCompleted();
 }
 
 void handleCheckRRightEndstop() {
   sendReceived();
-  bool state = readEndstopState(RRIGHT_ENDSTOP_PIN);
-  Serial.print("RRight endstop: ");
-  Serial.println(state ? "TRIGGERED" : "NOT TRIGGERED");
+  printAxisEndstop(STEPPER_RRIGHT, F(" endstop: "), readAxisEndstop(STEPPER_RRIGHT));
   sendCompleted();
 }
 
@@ -525,16 +1279,11 @@ void handleCheckAllEndstops() {
   sendReceived();
   Serial.println(F("Проверка всех концевых выключателей:"));
   
-  bool multiState = readEndstopState(MULTI_ENDSTOP_PIN);
-  bool multizoneState = readEndstopState(MULTIZONE_ENDSTOP_PIN);
-  bool rrightState = readEndstopState(RRIGHT_ENDSTOP_PIN);
-  
-  Serial.print("Multi: ");
-  Serial.println(multiState ? "TRIGGERED" : "NOT TRIGGERED");
-  Serial.print("Multizone: ");
-  Serial.println(multizoneState ? "TRIGGERED" : "NOT TRIGGERED");
-  Serial.print("RRight: ");
-  Serial.println(rrightState ? "TRIGGERED" : "NOT TRIGGERED");
+  // Один снимок - все концевики на один момент
+  SensorSnapshot inputs = readSensorSnapshot();
+  printAxisEndstop(STEPPER_MULTI, F(": "), inputs.bits & SENSOR_BIT_ENDSTOP(STEPPER_MULTI));
+  printAxisEndstop(STEPPER_MULTIZONE, F(": "), inputs.bits & SENSOR_BIT_ENDSTOP(STEPPER_MULTIZONE));
+  printAxisEndstop(STEPPER_RRIGHT, F(": "), inputs.bits & SENSOR_BIT_ENDSTOP(STEPPER_RRIGHT));
   
   sendCompleted();
 }
@@ -571,7 +1320,150 @@ void handleCheckEnablePins() {
   sendCompleted();
 }
 
+// Вывод статистики одного канала движка шагов
+static void printEngineStats(StepperType type) {
+  StepEngineStats stats;
+  stepEngineGetStats(type, &stats);
+  
+  unsigned long maxRate = 0;
+  if (stats.minPeriodUs != 0 && stats.minPeriodUs != 0xFFFFFFFFUL) {
+    maxRate = 1000000UL / stats.minPeriodUs;
+  }
+  
+  Serial.print(getAxisName(type));
+  Serial.print(F(": steps="));
+  Serial.print(stats.steps);
+  Serial.print(F(", max_rate="));
+  Serial.print(maxRate);
+  Serial.print(F(" steps/s, late="));
+  Serial.println(stats.lateSteps);
+}
+
+// engine_stats [reset] - максимальная частота шагов без опозданий по каждой оси
+void handleEngineStats() {
+  sendReceived();
+  
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    printEngineStats((StepperType)i);
+  }
+  Serial.print(F("Clamp E0/E1 skew: last="));
+  Serial.print(stepEngineGetClampSkew());
+  Serial.print(F(", max="));
+  Serial.print(stepEngineGetClampSkewMax());
+  Serial.println(F(" steps"));
+  
+  char* arg = sCmd.next();
+  if (arg && strcmp(arg, "reset") == 0) {
+    stepEngineResetStats();
+    Serial.println(F("Статистика движка сброшена"));
+  }
+  
+  sendCompleted();
+}
+
+#if PERF_ENABLED
+static void printPerfCounter(const __FlashStringHelper* name, PerfCounterId id) {
+  PerfCounter counter;
+  perfGetCounter(id, &counter);
+  Serial.print(name);
+  Serial.print(F(": n="));
+  Serial.print(counter.count);
+  Serial.print(F(", avg="));
+  Serial.print(counter.count ? counter.totalUs / counter.count : 0);
+  Serial.print(F(" us, max="));
+  Serial.print(counter.maxUs);
+  Serial.println(F(" us"));
+}
+
+static void printAxisPerf(StepperType type) {
+  StepEngineStats stats;
+  stepEngineGetStats(type, &stats);
+  
+  Serial.print(getAxisName(type));
+  Serial.print(F(": isr n="));
+  Serial.print(stats.isrCalls);
+  Serial.print(F(", avg="));
+  Serial.print(stats.isrCalls ? (float)stats.isrTicks / stats.isrCalls / STEP_ENGINE_TICKS_PER_US : 0.0, 1);
+  Serial.print(F(" us, max="));
+  Serial.print((float)stats.isrMaxTicks / STEP_ENGINE_TICKS_PER_US, 1);
+  Serial.print(F(" us, late="));
+  Serial.println(stats.lateSteps);
+}
+#endif
+
+// perf [reset] - длительность основного цикла, разбора команд, чтения HX711, расчёта
+// планировщика, обработчиков шагов по осям и минимальный запас ОЗУ
+void handlePerf() {
+  sendReceived();
+#if PERF_ENABLED
+  printPerfCounter(F("loop"), PERF_LOOP);
+  printPerfCounter(F("command"), PERF_COMMAND);
+  printPerfCounter(F("hx711"), PERF_HX711);
+  printPerfCounter(F("planner"), PERF_PLANNER);
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    printAxisPerf((StepperType)i);
+  }
+  Serial.print(F("ram: free="));
+  Serial.print(getFreeMemory());
+  Serial.print(F(", min_free="));
+  Serial.println(getMinFreeMemory());
+  Serial.print(F("log: queued="));
+  Serial.print(getLogQueued());
+  Serial.print(F(", dropped="));
+  Serial.println(getLogDropped());
+  
+  char* arg = sCmd.next();
+  if (arg && strcmp(arg, "reset") == 0) {
+    perfReset();
+    stepEngineResetStats();
+    Serial.println(F("Счётчики perf сброшены"));
+  }
+  sendCompleted();
+#else
+  sendError(MSG_INVALID_PARAMETER);
+#endif
+}
+
+static void printMemoryLine(const __FlashStringHelper* name, uint16_t bytes) {
+  Serial.print(name);
+  Serial.print(F(": "));
+  Serial.println(bytes);
+}
+
+// mem - бюджет ОЗУ: буферы модулей заданы в config.h и на этапе сборки, куча не используется
+void handleMem() {
+  sendReceived();
+#if PERF_ENABLED
+  Serial.print(F("ram: static="));
+  Serial.print(getStaticMemory());
+  Serial.print(F(", heap="));
+  Serial.print(getHeapMemory());
+  Serial.print(F(", free="));
+  Serial.print(getFreeMemory());
+  Serial.print(F(", min_free="));
+  Serial.println(getMinFreeMemory());
+#endif
+  printMemoryLine(F("steppers"), STEPPER_AXIS_COUNT * sizeof(GStepper2<STEPPER2WIRE>));
+  printMemoryLine(F("step_engine"), stepEngineGetMemory());
+  printMemoryLine(F("motion_jobs"), getMotionJobsMemory());
+  printMemoryLine(F("hx711"), sizeof(NBHX711) + sizeof(NBHX711History<WEIGHT_HISTORY_DEPTH>));
+  printMemoryLine(F("recipe"), getRecipeMemory());
+  printMemoryLine(F("log"), getLogMemory());
+  printMemoryLine(F("valves"), getValvesMemory());
+  printMemoryLine(F("binary"), getBinaryProtocolMemory());
+  printMemoryLine(F("serial"), sizeof(Serial));
+  Serial.print(F("commands: "));
+  Serial.print(sizeof(SerialCommand));
+  Serial.print(F(" ("));
+  Serial.print(sCmd.getCommandCount());
+  Serial.print(F("/"));
+  Serial.print(SERIALCOMMAND_MAX_COMMANDS);
+  Serial.println(F(")"));
+  sendCompleted();
+}
+
 // ============== ОБРАБОТЧИКИ КОМАНД ДЛЯ ДВИГАТЕЛЕЙ E0 И E1 ==============
+// При ошибке задание само сбрасывает позиции E0/E1 и флаг занятости clamp
 void handleClamp() {
   sendReceived();
   char* arg = sCmd.next();
@@ -581,48 +1473,29 @@ void handleClamp() {
   }
   
   long position = atol(arg);
-  Serial.print(F("Выполнение команды clamp к позиции: "));
-  Serial.println(position);
+  LOG_INFO({
+    Log.print(F("Выполнение команды clamp к позиции: "));
+    Log.println(position);
+  });
   
-  if (clampMotors(position)) {
-    Serial.println(F("Команда clamp успешно выполнена"));
-    sendCompleted();
-  } else {
-    Serial.println(F("Ошибка выполнения команды clamp"));
-    sendError("CLAMP_FAILED");
-    
-    // Безопасность: сброс состояния
-    e0Stepper.reset();
-    e1Stepper.reset();
-    resetClampFlag();
-  }
+  finishMotionCommand(STEPPER_E0, startClampJob(position, isAsyncMode()), MSG_CLAMP_FAILED);
 }
 
 void handleClampZero() {
   sendReceived();
-  Serial.println(F("Начало процедуры обнуления двигателей E0 и E1..."));
+  LOG_INFO(Log.println(F("Начало процедуры обнуления двигателей E0 и E1...")));
   
-  if (clampZeroMotors()) {
-    Serial.println(F("Обнуление двигателей E0 и E1 успешно выполнено"));
-    sendCompleted();
-  } else {
-    Serial.println(F("Ошибка при выполнении обнуления"));
-    sendError("CLAMP_ZERO_FAILED");
-    
-    // Безопасность: сброс состояния
-    e0Stepper.reset();
-    e1Stepper.reset();
-    resetClampFlag();
-  }
+  finishMotionCommand(STEPPER_E0, startClampZeroJob(isAsyncMode()), MSG_CLAMP_ZERO_FAILED);
 }
 
 void handleClampStop() {
   sendReceived();
-  Serial.println(F("Выполнение аварийной остановки двигателей E0 и E1..."));
+  LOG_INFO(Log.println(F("Выполнение аварийной остановки двигателей E0 и E1...")));
   
-  // Остановка двигателей
-  e0Stepper.brake();
-  e1Stepper.brake();
+  // Прерывание заданий E0/E1 и остановка двигателей
+  abortMotionJobs(STEP_ENGINE_AXIS_BIT(STEPPER_E0) | STEP_ENGINE_AXIS_BIT(STEPPER_E1));
+  stepEngineStop(STEPPER_E0);
+  stepEngineStop(STEPPER_E1);
   
   // Сброс позиций в текущее положение
   e0Stepper.reset();
@@ -631,6 +1504,6 @@ void handleClampStop() {
   // Сброс состояния
   resetClampFlag();
   
-  Serial.println(F("Двигатели E0 и E1 остановлены"));
+  LOG_INFO(Log.println(F("Двигатели E0 и E1 остановлены")));
   sendCompleted();
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+/**
+ * @file: dosing.cpp
+ * @description: Дозирование по весу с отсечкой насоса или клапана на целевой массе
+ * @dependencies: weight_sampler, valves, NBHX711, motion_jobs, config.h
+ * @created: 2026-10-14
+ *
+ * Решение об отсечке принимается в обработчике каждого нового отсчёта HX711 (weight_sampler),
+ * то есть не позже одного периода датчика и независимо от занятости loop().
+ * Масса считается в отсчётах АЦП от базовой линии на старте, расход - сглаженная производная.
+ * Устройство выключается, когда масса плюс расход за время DOSE_INFLIGHT_MS достигает цели:
+ * столько материала ещё в полёте и успеет выйти, пока закрывается клапан. Если цель будет
+ * достигнута раньше следующего отсчёта, момент отсечки интерполируется и выполняется из loop().
+ * После успокоения весов фактически долетевшая масса уточняет упреждение для следующей дозы.
+ */
+
+#include "dosing.h"
+#include "weight_sampler.h"
+#include "motion_jobs.h"
+#include "valves.h"
+#include "binary_protocol.h"
+#include "log.h"
+#include <Arduino.h>
+#include <NBHX711.h>
+#include <util/atomic.h>
+
+extern NBHX711 scale;
+
+// Ограничение скачка между отсчётами при оценке расхода, отсчётов АЦП
+#define DOSE_DELTA_LIMIT 1000000L
+
+typedef enum {
+  DOSE_IDLE,
+  DOSE_RUNNING,     // устройство включено, отсечку выполняет обработчик отсчётов
+  DOSE_SETTLING     // устройство выключено, ждём успокоения весов
+} DoseState;
+
+static volatile DoseState state = DOSE_IDLE;
+static volatile DoseActuator actuator = DOSE_PUMP;
+static volatile long baseline = 0;
+static volatile int8_t direction = 1;            // знак коэффициента весов
+static volatile long targetCounts = 0;
+static volatile long lastMass = 0;
+static volatile unsigned long lastSampleTime = 0;
+static volatile long flowRate = 0;               // отсчётов АЦП в секунду
+static volatile long cutoffMass = 0;
+static volatile long cutoffRate = 0;
+static volatile unsigned long cutoffTime = 0;
+static volatile bool cutoffPlanned = false;
+static volatile unsigned long plannedCutoff = 0;
+
+static unsigned long startTime = 0;
+static float countsPerGram = 1.0;
+static bool notifyHost = false;
+static uint16_t inflightMs[DOSE_ACTUATOR_COUNT];
+static float lastDoseGrams = 0;
+static const char* lastDoseError = nullptr;
+
+static void setActuator(DoseActuator target, bool on) {
+  switch (target) {
+    case DOSE_PUMP: setPumpState(on); break;
+    case DOSE_KL1: setValveState(KL1_PIN, on); break;
+    case DOSE_KL2: setValveState(KL2_PIN, on); break;
+    default: break;
+  }
+}
+
+// ============== ОТСЕЧКА ПО ОТСЧЁТУ ==============
+// Вызывается с запрещёнными прерываниями или из обработчика отсчёта
+static void cutOff(long mass, unsigned long now) {
+  setActuator(actuator, false);
+  cutoffMass = mass;
+  cutoffRate = flowRate;
+  cutoffTime = now;
+  cutoffPlanned = false;
+  state = DOSE_SETTLING;
+}
+
+static void doseOnSample(long raw) {
+  if (state != DOSE_RUNNING) return;
+
+  unsigned long now = millis();
+  long mass = (raw - baseline) * direction;
+  unsigned long dt = now - lastSampleTime;
+  if (dt > 0) {
+    long delta = constrain(mass - lastMass, -DOSE_DELTA_LIMIT, DOSE_DELTA_LIMIT);
+    long instant = delta * 1000L / (long)dt;
+    flowRate += (instant - flowRate) >> DOSE_RATE_SHIFT;
+  }
+  lastMass = mass;
+  lastSampleTime = now;
+
+  float inflight = flowRate > 0 ? flowRate * (inflightMs[actuator] / 1000.0) : 0;
+  float remaining = targetCounts - mass - inflight;
+  if (remaining <= 0) {
+    cutOff(mass, now);
+    return;
+  }
+
+  // Цель между отсчётами: отсечка по времени из serviceDosing(), этот же обработчик - запасной вариант
+  float eta = flowRate > 0 ? remaining * 1000.0 / flowRate : dt + 1;
+  cutoffPlanned = eta < dt;
+  if (cutoffPlanned) plannedCutoff = now + (unsigned long)eta;
+}
+
+// ============== ЗАВЕРШЕНИЕ ==============
+static long readMassCounts() {
+  return (scale.readAverage(5) - baseline) * direction;
+}
+
+static void finishDose(const char* error) {
+  lastDoseGrams = readMassCounts() / countsPerGram;
+  lastDoseError = error;
+  state = DOSE_IDLE;
+
+  if (notifyHost) {
+    if (error) {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(error);
+    } else {
+      Serial.print(MSG_COMPLETED);
+    }
+    Serial.println(F(" dose"));
+  }
+}
+
+// Досыпанное после отсечки - фактическая масса "в полёте", подстраиваем упреждение
+static void adaptInflight(long finalMass) {
+  long fallen = finalMass - cutoffMass;
+  if (cutoffRate <= 0 || fallen <= 0) return;
+
+  float observed = fallen * 1000.0 / cutoffRate;
+  float adapted = (3.0 * inflightMs[actuator] + observed) / 4.0;
+  inflightMs[actuator] = (uint16_t)constrain(adapted, 0.0, (float)DOSE_INFLIGHT_MAX_MS);
+}
+
+// Строка данных дозы - в текстовом режиме; в двоичном итог отдаёт кадр, текст рвал бы поток
+static void reportDose(long finalMass) {
+  if (isBinaryMode()) return;
+  float grams = finalMass / countsPerGram;
+  Serial.print(F("Доза: "));
+  Serial.print(grams, 2);
+  Serial.print(F(" г, цель "));
+  Serial.print(targetCounts / countsPerGram, 2);
+  Serial.print(F(" г, отклонение "));
+  Serial.print((finalMass - targetCounts) / countsPerGram, 2);
+  Serial.print(F(" г, упреждение "));
+  Serial.print(inflightMs[actuator]);
+  Serial.println(F(" мс"));
+}
+
+// ============== ИНТЕРФЕЙС ==============
+void initializeDosing() {
+  for (uint8_t i = 0; i < DOSE_ACTUATOR_COUNT; i++) inflightMs[i] = DOSE_INFLIGHT_MS;
+  setWeightSampleHandler(doseOnSample);
+}
+
+bool startDose(float grams, DoseActuator target, bool notify) {
+  if (state != DOSE_IDLE) {
+    lastDoseError = MSG_DOSE_BUSY;
+    return false;
+  }
+  if (grams <= 0 || grams > DOSE_MAX_GRAMS || target >= DOSE_ACTUATOR_COUNT || scale.getScale() == 0) {
+    lastDoseError = MSG_INVALID_PARAMETER;
+    return false;
+  }
+  if (getWeightSampleAge() > WEIGHT_SAMPLE_STALE_MS) {
+    lastDoseError = MSG_DOSE_SENSOR;
+    return false;
+  }
+
+  float factor = scale.getScale();
+  countsPerGram = fabs(factor);
+  notifyHost = notify;
+  lastDoseError = nullptr;
+  startTime = millis();
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    actuator = target;
+    direction = factor < 0 ? -1 : 1;
+    baseline = scale.readAverage(3);
+    targetCounts = (long)(grams * countsPerGram + 0.5);
+    lastMass = 0;
+    lastSampleTime = startTime;
+    flowRate = 0;
+    cutoffPlanned = false;
+    state = DOSE_RUNNING;
+  }
+  setActuator(target, true);
+  return true;
+}
+
+void serviceDosing() {
+  DoseState current = state;
+  if (current == DOSE_IDLE) return;
+
+  if (current == DOSE_RUNNING) {
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      unsigned long now = millis();
+      if (state == DOSE_RUNNING && cutoffPlanned && (long)(now - plannedCutoff) >= 0) {
+        cutOff(lastMass + flowRate * (long)(now - lastSampleTime) / 1000L, now);
+      }
+    }
+    if (state != DOSE_RUNNING) return;
+
+    const char* error = nullptr;
+    if (millis() - startTime > DOSE_TIMEOUT_MS) {
+      error = MSG_DOSE_TIMEOUT;
+    } else if (getWeightSampleAge() > WEIGHT_SAMPLE_STALE_MS) {
+      error = MSG_DOSE_SENSOR;
+    }
+    if (!error) return;
+
+    ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+      // Отсечка могла произойти в обработчике отсчёта - тогда доводим дозу как обычно
+      if (state == DOSE_RUNNING) {
+        cutOff(lastMass, millis());
+      } else {
+        error = nullptr;
+      }
+    }
+    if (error) {
+      finishDose(error);
+      return;
+    }
+  }
+
+  unsigned long settledSince;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    settledSince = cutoffTime;
+  }
+  if (millis() - settledSince < DOSE_SETTLE_MS) return;
+
+  long finalMass = readMassCounts();
+  adaptInflight(finalMass);
+  reportDose(finalMass);
+  finishDose(nullptr);
+}
+
+bool waitDose() {
+  while (state != DOSE_IDLE) {
+    serviceDosing();
+    serviceMotionJobs();
+    serviceWeightSampler();
+    serviceLog();
+    yield();
+  }
+  return lastDoseError == nullptr;
+}
+
+void abortDose() {
+  bool wasActive = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (state != DOSE_IDLE) {
+      setActuator(actuator, false);
+      wasActive = true;
+    }
+  }
+  if (wasActive) finishDose(MSG_JOB_ABORTED);
+}
+
+bool isDoseActive() {
+  return state != DOSE_IDLE;
+}
+
+float getLastDoseGrams() {
+  return lastDoseGrams;
+}
+
+const char* getLastDoseError() {
+  return lastDoseError;
+}
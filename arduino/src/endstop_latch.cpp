@@ -0,0 +1,151 @@
+/**
+ * @file: endstop_latch.cpp
+ * @description: Фиксация срабатывания концевиков по прерыванию с запоминанием позиции шага
+ * @dependencies: step_engine, stepper_control, config.h
+ * @created: 2026-10-14
+ *
+ * Пин 2 (Multizone и RRight) - внешнее прерывание INT4, пины 14 и 15 - группа PCINT1.
+ * Обработчик читает входы напрямую из регистров PINx, на сработавшем датчике запоминает
+ * pos взведённых осей и снимает их каналы step_engine, не дожидаясь основного цикла.
+ * Общий пин обслуживает одну маску осей за раз - чужой взвод отклоняется.
+ */
+
+#include "endstop_latch.h"
+#include "step_engine.h"
+#include <Arduino.h>
+#include <util/atomic.h>
+
+typedef struct {
+  int pin;
+  volatile uint8_t* inputReg;
+  uint8_t bitMask;
+  bool isNPN;
+  volatile uint8_t armedMask;   // оси, которые остановит срабатывание
+  volatile bool fired;
+} LatchSource;
+
+static LatchSource sources[ENDSTOP_LATCH_SOURCES];
+static uint8_t sourceCount = 0;
+static GStepper2<STEPPER2WIRE>* latchSteppers[STEP_ENGINE_AXES];
+static volatile int32_t capturedPos[STEP_ENGINE_AXES];
+
+// ============== ОБРАБОТКА ПРЕРЫВАНИЙ ==============
+static void serviceLatches() {
+  for (uint8_t s = 0; s < sourceCount; s++) {
+    LatchSource& src = sources[s];
+    uint8_t mask = src.armedMask;
+    if (!mask) continue;
+
+    bool raw = (*src.inputReg & src.bitMask) != 0;
+    if (src.isNPN == raw) continue;   // NPN: сработал = LOW, PNP: сработал = HIGH
+
+    for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+      if (mask & STEP_ENGINE_AXIS_BIT(i)) capturedPos[i] = latchSteppers[i]->pos;
+    }
+    stepEngineHaltFromISR(mask);
+    src.armedMask = 0;
+    src.fired = true;
+  }
+}
+
+static void externalLatchISR() {
+  serviceLatches();
+}
+
+ISR(PCINT1_vect) {
+  serviceLatches();
+}
+
+// ============== ИНИЦИАЛИЗАЦИЯ ==============
+static LatchSource* findSource(int pin) {
+  for (uint8_t s = 0; s < sourceCount; s++) {
+    if (sources[s].pin == pin) return &sources[s];
+  }
+  return nullptr;
+}
+
+static void addSource(int pin, bool isNPN) {
+  if (findSource(pin) || sourceCount >= ENDSTOP_LATCH_SOURCES) return;
+
+  // Поддерживаются внешние прерывания и группа PCINT1 (её вектор объявлен выше)
+  int extInterrupt = digitalPinToInterrupt(pin);
+  bool pcint1 = digitalPinToPCICR(pin) && digitalPinToPCICRbit(pin) == PCIE1;
+  if (extInterrupt == NOT_AN_INTERRUPT && !pcint1) {
+    Serial.print(F("Фиксация концевика: у пина "));
+    Serial.print(pin);
+    Serial.println(F(" нет прерывания, используется опрос"));
+    return;
+  }
+
+  LatchSource& src = sources[sourceCount++];
+  src.pin = pin;
+  src.inputReg = portInputRegister(digitalPinToPort(pin));
+  src.bitMask = digitalPinToBitMask(pin);
+  src.isNPN = isNPN;
+  src.armedMask = 0;
+  src.fired = false;
+
+  if (extInterrupt != NOT_AN_INTERRUPT) {
+    attachInterrupt(extInterrupt, externalLatchISR, CHANGE);
+  } else {
+    *digitalPinToPCMSK(pin) |= (1 << digitalPinToPCMSKbit(pin));
+    PCICR |= (1 << PCIE1);
+  }
+}
+
+void initializeEndstopLatches() {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    latchSteppers[i] = getStepperByType((StepperType)i);
+    capturedPos[i] = 0;
+  }
+
+#if ENDSTOP_INTERRUPT_LATCH
+  addSource(MULTI_ENDSTOP_PIN, MULTI_ENDSTOP_TYPE_NPN);
+  addSource(MULTIZONE_ENDSTOP_PIN, MULTIZONE_ENDSTOP_TYPE_NPN);
+  addSource(RRIGHT_ENDSTOP_PIN, RRIGHT_ENDSTOP_TYPE_NPN);
+  addSource(CLAMP_SENSOR_PIN, E0_ENDSTOP_TYPE_NPN);
+  Serial.print(F("Фиксация концевиков по прерыванию: датчиков "));
+  Serial.println(sourceCount);
+#endif
+}
+
+// ============== ВЗВОД И ЧТЕНИЕ ==============
+bool endstopLatchArm(int pin, bool isNPN, uint8_t axisMask) {
+  LatchSource* src = findSource(pin);
+  if (!src) return false;
+
+  bool armed = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    if (!src->armedMask || src->armedMask == axisMask) {
+      src->isNPN = isNPN;
+      src->fired = false;
+      src->armedMask = axisMask;
+      armed = true;
+      // Датчик уже нажат - фиксируем сразу, фронта не будет
+      serviceLatches();
+    }
+  }
+  return armed;
+}
+
+void endstopLatchDisarm(int pin) {
+  LatchSource* src = findSource(pin);
+  if (!src) return;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    src->armedMask = 0;
+    src->fired = false;
+  }
+}
+
+bool endstopLatchFired(int pin) {
+  LatchSource* src = findSource(pin);
+  return src && src->fired;
+}
+
+long endstopLatchPosition(StepperType type) {
+  long position;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    position = capturedPos[type];
+  }
+  return position;
+}
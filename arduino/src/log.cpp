@@ -0,0 +1,103 @@
+/**
+ * @file: log.cpp
+ * @description: Очередь диагностических строк, передаваемых в Serial без ожидания UART
+ * @dependencies: config.h
+ * @created: 2026-10-14
+ *
+ * Кольцо пишет и читает только основной цикл. Читатель видит лишь завершённые строки (до '\n')
+ * и отдаёт строку целиком, когда она помещается в свободную часть буфера передачи, - ответы
+ * команд, которые пишутся в Serial напрямую, не попадают в середину строки. Строка длиннее
+ * буфера передачи уходит в пустой буфер и ждёт только свой остаток.
+ */
+
+#include "log.h"
+
+static_assert(LOG_QUEUE_SIZE <= 256 && (LOG_QUEUE_SIZE & (LOG_QUEUE_SIZE - 1)) == 0,
+              "LOG_QUEUE_SIZE - степень двойки до 256");
+
+#ifdef SERIAL_TX_BUFFER_SIZE
+#define LOG_TX_CAPACITY (SERIAL_TX_BUFFER_SIZE - 1)
+#else
+#define LOG_TX_CAPACITY 63
+#endif
+
+#define LOG_NEXT(index) ((uint8_t)((index) + 1) & (LOG_QUEUE_SIZE - 1))
+
+LogQueue Log;
+
+static char queue[LOG_QUEUE_SIZE];
+static uint8_t head = 0;          // запись следующего байта
+static uint8_t lineStart = 0;     // начало незавершённой строки
+static uint8_t committed = 0;     // конец последней завершённой строки
+static uint8_t tail = 0;          // чтение
+static bool dropping = false;     // остаток переполнившейся строки отбрасывается
+static bool muted = false;
+static uint16_t droppedLines = 0;
+
+size_t LogQueue::write(uint8_t value) {
+  if (muted) return 1;
+  if (dropping) {
+    if (value == '\n') dropping = false;
+    return 1;
+  }
+
+  uint8_t next = LOG_NEXT(head);
+  if (next == tail) {
+    head = lineStart;
+    dropping = (value != '\n');
+    droppedLines++;
+    return 1;
+  }
+
+  queue[head] = value;
+  head = next;
+  if (value == '\n') {
+    lineStart = head;
+    committed = head;
+  }
+  return 1;
+}
+
+static uint16_t pendingLineLength() {
+  uint16_t length = 0;
+  for (uint8_t i = tail; i != committed; i = LOG_NEXT(i)) {
+    length++;
+    if (queue[i] == '\n') break;
+  }
+  return length;
+}
+
+void serviceLog() {
+  while (tail != committed) {
+    uint16_t length = pendingLineLength();
+    int room = Serial.availableForWrite();
+    if (room < (int)length && room < LOG_TX_CAPACITY) return;
+    while (length--) {
+      Serial.write((uint8_t)queue[tail]);
+      tail = LOG_NEXT(tail);
+    }
+  }
+}
+
+void flushLog() {
+  while (tail != committed) serviceLog();
+}
+
+void setLogMuted(bool value) {
+  muted = value;
+  if (!muted) return;
+  head = lineStart = committed = tail = 0;
+  dropping = false;
+}
+
+uint16_t getLogQueued() {
+  return (uint8_t)(head - tail) & (LOG_QUEUE_SIZE - 1);
+}
+
+uint16_t getLogDropped() {
+  return droppedLines;
+}
+
+uint16_t getLogMemory() {
+  return sizeof(queue);
+}
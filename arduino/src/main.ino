@@ -1,7 +1,7 @@
 /**
  * @file: main.ino
  * @description: Главный модуль системы управления с синхронной обработкой команд
- * @dependencies: GyverStepper2, NBHX711, stepper_control, valves, commands
+ * @dependencies: GyverStepper2, NBHX711, stepper_control, step_engine, motion_jobs, endstop_latch, valves, commands, binary_protocol, weight_sampler, dosing, telemetry, recipe, axis_tune, boot, perf, log
  * @created: 2024-12-19
  */
 
@@ -9,96 +9,124 @@
 #include <NBHX711.h>
 #include "config.h"
 #include "stepper_control.h"
+#include "step_engine.h"
+#include "motion_jobs.h"
+#include "endstop_latch.h"
 #include "sensors.h"
 #include "valves.h"
 #include "commands.h"
+#include "binary_protocol.h"
+#include "weight_sampler.h"
+#include "dosing.h"
+#include "telemetry.h"
+#include "recipe.h"
+#include "axis_tune.h"
+#include "boot.h"
+#include "perf.h"
+#include "log.h"
 
 // ============== ГЛОБАЛЬНЫЕ ПЕРЕМЕННЫЕ ==============
-NBHX711 scale(WEIGHT_SENSOR_DT, WEIGHT_SENSOR_SCK, 16);
-
-
-// Таймеры для автоматического отчета (используется только если включен)
-unsigned long lastWeightReportTime = 0;
-const unsigned long WEIGHT_REPORT_INTERVAL = 1000;  // 1 секунда
+// История отсчётов - статический буфер, куча не используется
+static NBHX711History<WEIGHT_HISTORY_DEPTH> weightHistory;
+NBHX711 scale(WEIGHT_SENSOR_DT, WEIGHT_SENSOR_SCK, weightHistory);
 
 
 // ============== ИНИЦИАЛИЗАЦИЯ СИСТЕМЫ ==============
 void setup() {
+  // Разметка свободного ОЗУ до первых вызовов - для минимального запаса в perf
+  initializePerf();
+  
   // Инициализация последовательного порта
   Serial.begin(115200);
+#if !FAST_BOOT
   delay(1000);
+#endif
   
   Serial.println(F("======== СИСТЕМА ЗАПУСКАЕТСЯ ========"));
   Serial.println(F("Версия: 2.1 (синхронная)"));
   Serial.println(F("Дата: 2024-12-19"));
   
+  // Ход старта - через очередь Log. Кольцо (LOG_QUEUE_SIZE) меньше всех строк старта, а loop()
+  // ещё не крутит serviceLog(), поэтому перед каждым этапом и прямым выводом в Serial очередь
+  // досылается с ожиданием UART - строки не теряются и идут по порядку
   // Инициализация шаговых двигателей
-  Serial.println(F("Инициализация шаговых двигателей..."));
+  LOG_INFO(Log.println(F("Инициализация шаговых двигателей...")));
   initializeSteppers();
   
+  // Запуск генерации шагов по таймерам 1/3/4/5
+  flushLog();
+  LOG_INFO(Log.println(F("Запуск движка шагов на таймерах...")));
+  initializeStepEngine();
+  initializeMotionJobs();
+  initializeEndstopLatches();
+  // Пределы осей, подобранные командой tune
+  initializeAxisTune();
+  
   // Инициализация датчиков
-  Serial.println(F("Инициализация датчиков..."));
+  flushLog();
+  LOG_INFO(Log.println(F("Инициализация датчиков...")));
   initializeSensors();
   
-  // Инициализация датчика веса
-  Serial.println(F("Инициализация датчика веса..."));
+  // Инициализация датчика веса: коэффициент и тара из EEPROM (без записи - WEIGHT_SCALE_FACTOR)
+  flushLog();
+  LOG_INFO(Log.println(F("Инициализация датчика веса...")));
   scale.begin();
-  scale.setScale(2230.0);
-  scale.tare();
-  Serial.println(F("Датчик веса инициализирован и тарирован"));
+  loadWeightCalibration();
+  scale.setFilter(WEIGHT_FILTER_MODE, WEIGHT_FILTER_IIR_SHIFT);
+  scale.setOutlierLimit(WEIGHT_OUTLIER_LIMIT);
+  initializeWeightSampler();
+  initializeDosing();
+  initializeRecipes();
+  // История заполняется в фоне - датчик проверяется (и без записи тарируется) по реальным
+  // отсчётам; при FAST_BOOT уже после "СИСТЕМА ГОТОВА", строкой SELFTEST
+  startSelfTest();
+#if !FAST_BOOT
+  flushLog();
+  waitSelfTest();
+#endif
   
   // Инициализация клапанов и насоса
-  Serial.println(F("Инициализация клапанов и насоса..."));
+  flushLog();
+  LOG_INFO(Log.println(F("Инициализация клапанов и насоса...")));
   initializeValves();
   
   // Настройка обработчиков команд
-  Serial.println(F("Настройка обработчиков команд..."));
+  flushLog();
+  LOG_INFO(Log.println(F("Настройка обработчиков команд...")));
   setupCommandHandlers();
   
-  // Вывод доступных команд
-  Serial.println();
+  flushLog();
   Serial.println(F("======== СИСТЕМА ГОТОВА ========"));
   Serial.println(F("РЕЖИМ: Синхронная обработка команд"));
-  Serial.println(F("Каждая команда выполняется полностью до завершения"));
-  Serial.println();
-  Serial.println(F("Доступные команды:"));
-  Serial.println(F("Движение:"));
-  Serial.println(F("  - move_multi <позиция>"));
-  Serial.println(F("  - move_multizone <позиция>"));
-  Serial.println(F("  - move_rright <позиция>"));
-  Serial.println(F("  - move_e0 <позиция> (индивидуальное управление)"));
-  Serial.println(F("  - move_e1 <позиция> (индивидуальное управление)"));
-  Serial.println(F("Хоминг:"));
-  Serial.println(F("  - zero_multi, zero_multizone, zero_rright"));
-  Serial.println(F("  - zero_e0, zero_e1 (индивидуальный хоминг)"));
-  Serial.println(F("Clamp (E0/E1 синхронно):"));
-  Serial.println(F("  - clamp <позиция> (временное питание)"));
-  Serial.println(F("  - clamp_zero (временное питание)"));
-  Serial.println(F("  - clamp_stop"));
-  Serial.println(F("Клапаны:"));
-  Serial.println(F("  - kl1 <время>, kl2 <время>"));
-  Serial.println(F("  - kl1_on/off, kl2_on/off"));
-  Serial.println(F("Насос:"));
-  Serial.println(F("  - pump_on/off"));
-  Serial.println(F("Датчики:"));
-  Serial.println(F("  - weight, raw_weight"));
-  Serial.println(F("  - calibrate_weight"));
-  Serial.println(F("  - calibrate_weight_factor <коэффициент>"));
-  Serial.println(F("  - weight_report_on/off"));
-  Serial.println(F("  - staterotor, waste"));
-  Serial.println(F("Диагностика:"));
-  Serial.println(F("  - check_all_endstops"));
-  Serial.println(F("  - check_enable_pins"));
-  Serial.println(F("  - test"));
-  Serial.println();
+#if FAST_BOOT
+  Serial.println(F("help - список команд"));
+#else
+  printHelp();
+#endif
   Serial.println(F("Ожидание команд..."));
 }
 
 // ============== ОСНОВНОЙ ЦИКЛ ==============
 void loop() {
-  // Только обработка входящих команд
-  // Каждая команда является блокирующей и выполняется полностью
-  if (Serial.available() > 0) {
+  perfLoopTick();
+  
+  // Продвижение заданий движения (в асинхронном режиме команды не ждут их завершения)
+  serviceMotionJobs();
+  serviceWeightSampler();
+  serviceDosing();
+  serviceValves();
+  serviceRecipe();
+  serviceAxisTune();
+  serviceSelfTest();
+  serviceTelemetry();
+  serviceLog();
+  
+  // Двоичные кадры и ответы о завершении заданий (только в двоичном режиме)
+  serviceBinaryProtocol();
+  
+  // Обработка входящих команд
+  if (!isBinaryMode() && Serial.available() > 0) {
+    perfCommandStart();
     sCmd.readSerial();
   }
   
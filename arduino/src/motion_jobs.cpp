@@ -0,0 +1,1112 @@
+/**
+ * @file: motion_jobs.cpp
+ * @description: Неблокирующие задания движения (перемещение, хоминг, clamp) для каждой оси
+ * @dependencies: step_engine, endstop_latch, stepper_control, config.h
+ * @created: 2026-10-14
+ *
+ * Шаги генерирует step_engine по таймерам, здесь - только автоматы состояний, которые
+ * serviceMotionJobs() продвигает из loop(). Задержки стабилизации заменены отметками millis(),
+ * поэтому пока одна ось едет, остальные оси и команды датчиков обслуживаются без ожидания.
+ *
+ * Перемешивание (agitate) - такое же задание: ходы туда-обратно от исходной позиции или
+ * вращение, цель которого отодвигается вперёд, пока не выйдет время. Одна команда
+ * заменяет поток move_e0 от хоста с полным обменом на каждый ход.
+ */
+
+#include "motion_jobs.h"
+#include "step_engine.h"
+#include "endstop_latch.h"
+#include "log.h"
+#include <Arduino.h>
+
+// Фазы автоматов заданий
+typedef enum {
+  PHASE_SETTLE,          // пауза после остановки перед началом
+  PHASE_TRAVEL,          // движение к цели (move, clamp)
+  PHASE_ESCAPE,          // отъезд от уже сработавшего датчика
+  PHASE_ESCAPE_SETTLE,   // пауза после отъезда
+  PHASE_SEEK,            // поиск датчика
+  PHASE_LATCH_SETTLE,    // пауза после быстрого поиска
+  PHASE_LATCH_ESCAPE,    // отъезд на дистанцию повторного подхода
+  PHASE_LATCH_SEEK,      // медленный повторный подход к датчику
+  PHASE_ZERO_SETTLE,     // пауза после сброса позиции
+  PHASE_BACKOFF,         // отъезд от датчика на рабочую позицию
+  PHASE_STROKE_OUT,      // перемешивание: ход от исходной позиции
+  PHASE_STROKE_BACK,     // перемешивание: возврат в исходную позицию
+  PHASE_ROTATE,          // вращение с отодвигаемой целью
+  PHASE_ROTATE_STOP      // торможение вращения
+} MotionJobPhase;
+
+// Время пауз и таймауты отдельных фаз, мс
+#define JOB_HOME_SETTLE_MS 100
+#define JOB_CLAMP_SETTLE_MS 50
+#define JOB_ZERO_SETTLE_MS 200
+#define JOB_ESCAPE_TIMEOUT_MS 10000
+#define JOB_CLAMP_ESCAPE_TIMEOUT_MS 5000
+#define JOB_BACKOFF_TIMEOUT_MS 10000
+#define JOB_MOVE_PROGRESS_MS 2000
+#define JOB_HOME_PROGRESS_MS 3000
+
+// Отъезд от датчика после хоминга: новый ноль на этом расстоянии от точки срабатывания
+#define JOB_HOME_BACKOFF_STEPS 100
+
+#define CLAMP_AXES (STEP_ENGINE_AXIS_BIT(STEPPER_E0) | STEP_ENGINE_AXIS_BIT(STEPPER_E1))
+
+typedef struct {
+  MotionJobKind kind;
+  MotionJobPhase phase;
+  MotionJobResult result;
+  uint8_t axisMask;
+  bool notify;
+  long target;               // цель перемещения; у хоминга - позиция срабатывания датчика до сброса
+  unsigned long jobStart;
+  unsigned long phaseStart;
+  unsigned long lastProgress;
+  const char* errorCode;     // код ошибки для события ERROR
+  int latchPin;              // датчик, взведённый на фиксацию по прерыванию (-1 - опрос)
+  StepperConfig config;
+  // Перемешивание: исходная позиция, ход (0 - вращение), направление вращения,
+  // путь торможения, выполненные и заданные циклы (0 - по времени), длительность (0 - по циклам)
+  long origin;
+  long amplitude;
+  int8_t dir;
+  long brakeSteps;
+  uint16_t cycles;
+  uint16_t cycleLimit;
+  unsigned long duration;
+  bool stopRequested;
+} MotionJob;
+
+static MotionJob jobs[STEP_ENGINE_AXES];
+static bool asyncMode = false;
+
+// Оси, обнулённые по датчику с момента включения
+static bool homed[STEP_ENGINE_AXES];
+
+// Смещение точки срабатывания датчика при последнем хоминге относительно прежнего нуля
+static long homeDrift[STEP_ENGINE_AXES];
+static bool homeDriftValid[STEP_ENGINE_AXES];
+
+// Групповой хоминг (zero_all / zero <маска>)
+typedef struct {
+  bool active;
+  bool notify;
+  uint8_t pending;     // оси, ожидающие освобождения общего датчика
+  uint8_t running;     // оси с запущенным заданием
+  uint8_t failed;
+  MotionJobResult result;
+  unsigned long start;
+} HomingBatch;
+
+static HomingBatch batch;
+
+// ============== СЛУЖЕБНЫЕ ФУНКЦИИ ==============
+const __FlashStringHelper* getMotionJobName(StepperType type) {
+  MotionJobKind kind = jobs[type].kind;
+  if (kind == JOB_CLAMP || kind == JOB_CLAMP_ZERO) return F("clamp");
+  return getAxisEventName(type);
+}
+
+static bool maskRunning(uint8_t axisMask) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if ((axisMask & STEP_ENGINE_AXIS_BIT(i)) && stepEngineIsRunning((StepperType)i)) return true;
+  }
+  return false;
+}
+
+static void stopMask(uint8_t axisMask) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if (axisMask & STEP_ENGINE_AXIS_BIT(i)) stepEngineStop((StepperType)i);
+  }
+}
+
+static inline void enterPhase(MotionJob& job, MotionJobPhase phase) {
+  job.phase = phase;
+  job.phaseStart = millis();
+}
+
+static inline unsigned long phaseElapsed(const MotionJob& job) {
+  return millis() - job.phaseStart;
+}
+
+bool isAxisBusy(StepperType type) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if (jobs[i].kind != JOB_NONE && (jobs[i].axisMask & STEP_ENGINE_AXIS_BIT(type))) return true;
+  }
+  return false;
+}
+
+static bool maskBusy(uint8_t axisMask) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if ((axisMask & STEP_ENGINE_AXIS_BIT(i)) && isAxisBusy((StepperType)i)) return true;
+  }
+  return false;
+}
+
+static MotionJob& prepareJob(StepperType slot, MotionJobKind kind, uint8_t axisMask, bool notify) {
+  MotionJob& job = jobs[slot];
+  job.kind = kind;
+  job.result = JOB_RESULT_NONE;
+  job.axisMask = axisMask;
+  job.notify = notify;
+  job.target = 0;
+  job.jobStart = millis();
+  job.lastProgress = job.jobStart;
+  job.errorCode = MSG_MOVE_FAILED;
+  job.latchPin = -1;
+  return job;
+}
+
+// Фиксация датчика по прерыванию; если недоступна, фаза остаётся на опросе
+static void armJobLatch(MotionJob& job, int pin, bool isNPN) {
+  job.latchPin = endstopLatchArm(pin, isNPN, job.axisMask) ? pin : -1;
+}
+
+static void releaseJobLatch(MotionJob& job) {
+  if (job.latchPin >= 0) endstopLatchDisarm(job.latchPin);
+  job.latchPin = -1;
+}
+
+static inline bool jobLatchFired(const MotionJob& job) {
+  return job.latchPin >= 0 && endstopLatchFired(job.latchPin);
+}
+
+// Завершение задания: освобождение осей и событие для хоста
+static void finishJob(StepperType slot, MotionJobResult result) {
+  MotionJob& job = jobs[slot];
+  releaseJobLatch(job);
+  if (result != JOB_RESULT_OK) stopMask(job.axisMask);
+
+  if (job.kind == JOB_CLAMP || job.kind == JOB_CLAMP_ZERO) {
+    if (result == JOB_RESULT_FAILED) {
+      // Безопасность: сброс состояния, как при аварийной остановке
+      e0Stepper.reset();
+      e1Stepper.reset();
+    }
+    releaseClampFlag();
+  }
+
+  if (job.notify) {
+    if (result == JOB_RESULT_OK) {
+      Serial.print(MSG_COMPLETED);
+    } else {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(result == JOB_RESULT_ABORTED ? MSG_JOB_ABORTED : job.errorCode);
+    }
+    Serial.print(' ');
+    Serial.println(getMotionJobName(slot));
+  }
+
+  if (job.kind == JOB_AGITATE) {
+    // Дальше перемещения идут на скорости, как после хоминга или включения
+    stepEngineSetMaxSpeed(slot, homed[slot] ? job.config.homingSpeed : job.config.maxSpeed);
+    LOG_INFO({
+      Log.print(F("Перемешивание "));
+      Log.print(getAxisName(slot));
+      Log.print(F(": циклов "));
+      Log.print(job.cycles);
+      Log.print(F(", позиция "));
+      Log.println(getStepperByType(slot)->getCurrent());
+    });
+  }
+
+  if (job.kind == JOB_HOME || job.kind == JOB_CLAMP_ZERO) {
+    for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+      if (!(job.axisMask & STEP_ENGINE_AXIS_BIT(i))) continue;
+      homed[i] = (result == JOB_RESULT_OK);
+      // clamp_zero обнуляет пару без замера смещения
+      if (!homed[i] || job.kind == JOB_CLAMP_ZERO) homeDriftValid[i] = false;
+    }
+  }
+
+  job.result = result;
+  job.kind = JOB_NONE;
+}
+
+// ============== ЗАДАНИЕ ПЕРЕМЕЩЕНИЯ ==============
+bool startMoveJob(StepperType type, long position, bool notify) {
+  return startMoveJob(type, position, notify, nullptr, 0);
+}
+
+bool startMoveJob(StepperType type, long position, bool notify, const StepEngineEvent* events, uint8_t eventCount) {
+  if (position == 0) {
+    LOG_ERROR(Log.println(F("Ошибка: Нулевая позиция не допускается")));
+    return false;
+  }
+
+  if ((type == STEPPER_E0 || type == STEPPER_E1) && isClampInProgress()) {
+    LOG_ERROR(Log.println(F("Ошибка: Двигатели E0/E1 заняты командой clamp")));
+    return false;
+  }
+
+  if (isAxisBusy(type)) {
+    LOG_ERROR({
+      Log.print(F("Ошибка: ось "));
+      Log.print(getAxisName(type));
+      Log.println(F(" занята другим заданием"));
+    });
+    return false;
+  }
+
+  LOG_INFO({
+    Log.print(F("ДВИЖЕНИЕ "));
+    Log.print(getAxisName(type));
+    Log.print(F(": "));
+    Log.print(getStepperByType(type)->getCurrent());
+    Log.print(F(" -> "));
+    Log.println(position);
+  });
+
+  MotionJob& job = prepareJob(type, JOB_MOVE, STEP_ENGINE_AXIS_BIT(type), notify);
+  job.target = position;
+  enterPhase(job, PHASE_TRAVEL);
+  stepEngineMoveTo(type, position, events, eventCount);
+  return true;
+}
+
+static void serviceMoveJob(StepperType type, MotionJob& job) {
+  GStepper2<STEPPER2WIRE>* stepper = getStepperByType(type);
+  unsigned long now = millis();
+
+  if (!stepEngineIsRunning(type)) {
+    LOG_INFO({
+      Log.print(F("ЗАВЕРШЕНО "));
+      Log.print(getAxisName(type));
+      Log.print(F(": "));
+      Log.println(stepper->getCurrent());
+    });
+    finishJob(type, stepper->getCurrent() == job.target ? JOB_RESULT_OK : JOB_RESULT_FAILED);
+    return;
+  }
+
+  if (now - job.jobStart > HOMING_TIMEOUT) {
+    stepEngineStop(type);
+    LOG_ERROR({
+      Log.print(F("ТАЙМАУТ "));
+      Log.print(getAxisName(type));
+      Log.print(F(" на позиции "));
+      Log.println(stepper->getCurrent());
+    });
+    finishJob(type, JOB_RESULT_FAILED);
+    return;
+  }
+
+  LOG_DEBUG({
+    if (now - job.lastProgress >= JOB_MOVE_PROGRESS_MS) {
+      job.lastProgress = now;
+      Log.print(F("ПРОГРЕСС "));
+      Log.print(getAxisName(type));
+      Log.print(F(": "));
+      Log.print(stepEngineGetPosition(type));
+      Log.print(F("/"));
+      Log.println(job.target);
+    }
+  });
+}
+
+// ============== ЗАДАНИЕ ХОМИНГА ==============
+bool startHomeJob(StepperType type, bool notify) {
+  StepperConfig config;
+  readStepperConfig(type, config);
+  return startHomeJob(type, config, notify);
+}
+
+bool startHomeJob(StepperType type, const StepperConfig& config, bool notify) {
+  if ((type == STEPPER_E0 || type == STEPPER_E1) && isClampInProgress()) {
+    LOG_ERROR(Log.println(F("Ошибка: Двигатели E0/E1 заняты командой clamp")));
+    return false;
+  }
+
+  if (isAxisBusy(type)) {
+    LOG_ERROR({
+      Log.print(F("Ошибка: ось "));
+      Log.print(getAxisName(type));
+      Log.println(F(" занята другим заданием"));
+    });
+    return false;
+  }
+
+  // Общий датчик (Multizone/RRight) не различает, чья каретка его нажала
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if ((jobs[i].kind == JOB_HOME || jobs[i].kind == JOB_CLAMP_ZERO) &&
+        jobs[i].config.endstopPin == config.endstopPin) {
+      LOG_ERROR({
+        Log.print(F("Ошибка: датчик пина "));
+        Log.print(config.endstopPin);
+        Log.println(F(" занят хомингом другой оси"));
+      });
+      return false;
+    }
+  }
+
+  LOG_INFO({
+    Log.print(F("Хоминг "));
+    Log.print(getAxisName(type));
+    Log.print(F(" со скоростью "));
+    Log.print(config.homingFastSpeed);
+    Log.print(F("/"));
+    Log.print(config.homingLatchSpeed);
+    Log.print(F(" steps/sec, подход "));
+    Log.print(config.homingLatchDistance);
+    Log.print(F(" шагов, датчик тип: "));
+    Log.println(config.endstopTypeNPN ? F("NPN") : F("PNP"));
+  });
+
+  MotionJob& job = prepareJob(type, JOB_HOME, STEP_ENGINE_AXIS_BIT(type), notify);
+  job.config = config;
+  job.errorCode = MSG_HOMING_TIMEOUT;
+
+  stepEngineStop(type);
+  enterPhase(job, PHASE_SETTLE);
+  return true;
+}
+
+static inline bool homeEndstop(const MotionJob& job) {
+  return readEndstopWithType(job.config.endstopPin, job.config.endstopTypeNPN);
+}
+
+static void beginHomeSeek(StepperType type, MotionJob& job) {
+  LOG_INFO(Log.println(F("Движемся к концевику...")));
+  stepEngineMoveTo(type, getStepperByType(type)->getCurrent() - 50000);
+  armJobLatch(job, job.config.endstopPin, job.config.endstopTypeNPN);
+  job.lastProgress = millis();
+  enterPhase(job, PHASE_SEEK);
+}
+
+// Сброс позиции в 0 по сработавшему датчику: при фиксации по прерыванию нулём
+// становится позиция шага в момент фронта, а не точка, где ось остановилась
+static void latchHomeZero(StepperType type, MotionJob& job, bool fired) {
+  GStepper2<STEPPER2WIRE>* stepper = getStepperByType(type);
+  job.target = fired ? endstopLatchPosition(type) : stepper->getCurrent();
+  if (fired) {
+    long overshoot = stepper->getCurrent() - endstopLatchPosition(type);
+    stepper->setCurrent(overshoot);
+    LOG_INFO({
+      Log.print(F("Позиция зафиксирована по прерыванию, перебег "));
+      Log.print(overshoot);
+      Log.println(F(" шагов"));
+    });
+  } else {
+    stepper->reset();
+  }
+  releaseJobLatch(job);
+  LOG_INFO({
+    Log.print(F("Концевик сработал (тип: "));
+    Log.print(job.config.endstopTypeNPN ? F("NPN") : F("PNP"));
+    Log.println(F("), позиция сброшена в 0"));
+  });
+  enterPhase(job, PHASE_ZERO_SETTLE);
+}
+
+static void serviceHomeJob(StepperType type, MotionJob& job) {
+  GStepper2<STEPPER2WIRE>* stepper = getStepperByType(type);
+
+  switch (job.phase) {
+    case PHASE_SETTLE: {
+      if (phaseElapsed(job) < JOB_HOME_SETTLE_MS) return;
+      stepEngineSetMaxSpeed(type, job.config.homingFastSpeed);
+
+      bool initialEndstopState = homeEndstop(job);
+      LOG_INFO({
+        Log.print(F("Начальное состояние датчика: "));
+        Log.println(initialEndstopState ? F("СРАБОТАЛ") : F("НЕ СРАБОТАЛ"));
+      });
+
+      if (initialEndstopState) {
+        LOG_INFO(Log.println(F("Датчик уже сработал, отъезжаем...")));
+        stepEngineMoveTo(type, stepper->getCurrent() + 200);
+        enterPhase(job, PHASE_ESCAPE);
+      } else {
+        beginHomeSeek(type, job);
+      }
+      break;
+    }
+
+    case PHASE_ESCAPE:
+      if (stepEngineIsRunning(type) && phaseElapsed(job) < JOB_ESCAPE_TIMEOUT_MS) return;
+      stepEngineStop(type);
+      enterPhase(job, PHASE_ESCAPE_SETTLE);
+      break;
+
+    case PHASE_ESCAPE_SETTLE:
+      if (phaseElapsed(job) < JOB_HOME_SETTLE_MS) return;
+      if (homeEndstop(job)) {
+        LOG_ERROR(Log.println(F("Ошибка: не удалось отъехать от датчика")));
+        finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+      LOG_INFO(Log.println(F("Успешно отъехали от датчика")));
+      beginHomeSeek(type, job);
+      break;
+
+    case PHASE_SEEK: {
+      bool fired = jobLatchFired(job);
+      if (fired || homeEndstop(job)) {
+        stepEngineStop(type);
+        if (job.config.homingLatchDistance > 0) {
+          releaseJobLatch(job);
+          LOG_INFO(Log.println(F("Концевик найден, повторный подход на малой скорости...")));
+          enterPhase(job, PHASE_LATCH_SETTLE);
+        } else {
+          latchHomeZero(type, job, fired);
+        }
+        return;
+      }
+
+      if (phaseElapsed(job) >= HOMING_TIMEOUT) {
+        LOG_ERROR(Log.println(F("Ошибка: Таймаут хоминга")));
+        finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+
+      if (!stepEngineIsRunning(type)) {
+        LOG_ERROR(Log.println(F("Ошибка: концевик не сработал за отведенное время")));
+        finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+
+      LOG_DEBUG({
+        unsigned long now = millis();
+        if (now - job.lastProgress >= JOB_HOME_PROGRESS_MS) {
+          job.lastProgress = now;
+          Log.print(F("ХОМИНГ "));
+          Log.print(getAxisName(type));
+          Log.print(F(": позиция="));
+          Log.print(stepEngineGetPosition(type));
+          Log.print(F(", время="));
+          Log.print(phaseElapsed(job) / 1000);
+          Log.println(F("с"));
+        }
+      });
+      break;
+    }
+
+    case PHASE_LATCH_SETTLE:
+      if (phaseElapsed(job) < JOB_HOME_SETTLE_MS) return;
+      stepEngineMoveTo(type, stepper->getCurrent() + job.config.homingLatchDistance);
+      enterPhase(job, PHASE_LATCH_ESCAPE);
+      break;
+
+    case PHASE_LATCH_ESCAPE:
+      if (stepEngineIsRunning(type)) {
+        if (phaseElapsed(job) > JOB_ESCAPE_TIMEOUT_MS) {
+          LOG_ERROR(Log.println(F("Ошибка: Таймаут отъезда перед повторным подходом")));
+          finishJob(type, JOB_RESULT_FAILED);
+        }
+        return;
+      }
+      if (homeEndstop(job)) {
+        LOG_ERROR(Log.println(F("Ошибка: датчик не отпустился перед повторным подходом")));
+        finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+      stepEngineSetMaxSpeed(type, job.config.homingLatchSpeed);
+      stepEngineMoveTo(type, stepper->getCurrent() - 2L * job.config.homingLatchDistance);
+      armJobLatch(job, job.config.endstopPin, job.config.endstopTypeNPN);
+      enterPhase(job, PHASE_LATCH_SEEK);
+      break;
+
+    case PHASE_LATCH_SEEK: {
+      bool fired = jobLatchFired(job);
+      if (fired || homeEndstop(job)) {
+        stepEngineStop(type);
+        latchHomeZero(type, job, fired);
+        return;
+      }
+      if (!stepEngineIsRunning(type)) {
+        LOG_ERROR(Log.println(F("Ошибка: концевик не сработал при повторном подходе")));
+        finishJob(type, JOB_RESULT_FAILED);
+      }
+      break;
+    }
+
+    case PHASE_ZERO_SETTLE:
+      if (phaseElapsed(job) < JOB_ZERO_SETTLE_MS) return;
+      LOG_INFO(Log.println(F("Отъезжаем от концевика...")));
+      // Отъезд и последующие перемещения - на homingSpeed, как и до двухскоростного хоминга
+      stepEngineSetMaxSpeed(type, job.config.homingSpeed);
+      stepEngineMoveTo(type, JOB_HOME_BACKOFF_STEPS);
+      enterPhase(job, PHASE_BACKOFF);
+      break;
+
+    case PHASE_BACKOFF:
+      if (stepEngineIsRunning(type)) {
+        if (phaseElapsed(job) > JOB_BACKOFF_TIMEOUT_MS) {
+          LOG_ERROR(Log.println(F("Ошибка: Таймаут отъезда от концевика")));
+          finishJob(type, JOB_RESULT_FAILED);
+        }
+        return;
+      }
+      if (homeEndstop(job)) {
+        LOG_WARN(Log.println(F("Предупреждение: датчик все еще активен после отъезда")));
+      }
+      stepper->reset(); // Новая нулевая точка
+      // Без потерь шагов датчик срабатывает на -JOB_HOME_BACKOFF_STEPS от прежнего нуля
+      homeDriftValid[type] = homed[type];
+      homeDrift[type] = job.target + JOB_HOME_BACKOFF_STEPS;
+      LOG_INFO({
+        Log.print(F("Хоминг "));
+        Log.print(getAxisName(type));
+        Log.println(F(" завершен успешно"));
+        if (homeDriftValid[type]) {
+          Log.print(F("Смещение датчика от прежнего нуля: "));
+          Log.print(homeDrift[type]);
+          Log.println(F(" шагов"));
+        }
+      });
+      finishJob(type, JOB_RESULT_OK);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// ============== ЗАДАНИЯ CLAMP / CLAMP_ZERO ==============
+static bool claimClampAxes() {
+  if (maskBusy(CLAMP_AXES)) {
+    LOG_ERROR(Log.println(F("Ошибка: Двигатели E0/E1 заняты другим заданием")));
+    return false;
+  }
+  if (!acquireClampFlag()) {
+    LOG_ERROR(Log.println(F("Ошибка: Команда clamp уже выполняется")));
+    return false;
+  }
+  return true;
+}
+
+// E0/E1 едут связанной парой через планировщик движка (один профиль на обе оси)
+static void startClampAxes(long e0Target, long e1Target) {
+  stepEngineMoveClampGroup(e0Target, e1Target);
+}
+
+static void configureClampAxes(int e0Speed, int e1Speed, int e0Accel, int e1Accel) {
+  stepEngineConfigureClampGroup(min(e0Speed, e1Speed), min(e0Accel, e1Accel));
+}
+
+static void printClampSkew() {
+  LOG_INFO({
+    Log.print(F("Расхождение E0/E1: "));
+    Log.print(stepEngineGetClampSkew());
+    Log.println(F(" шагов"));
+  });
+}
+
+bool startClampJob(long position, bool notify) {
+  if (!claimClampAxes()) return false;
+
+  LOG_INFO({
+    Log.println(F("Начало выполнения команды clamp"));
+    Log.print(F("Текущие позиции - E0: "));
+    Log.print(e0Stepper.getCurrent());
+    Log.print(F(", E1: "));
+    Log.println(e1Stepper.getCurrent());
+  });
+
+  MotionJob& job = prepareJob(STEPPER_E0, JOB_CLAMP, CLAMP_AXES, notify);
+  job.target = position;
+  job.errorCode = MSG_CLAMP_FAILED;
+
+  stopMask(CLAMP_AXES);
+  enterPhase(job, PHASE_SETTLE);
+  return true;
+}
+
+static void serviceClampJob(MotionJob& job) {
+  unsigned long now = millis();
+
+  if (job.phase == PHASE_SETTLE) {
+    if (phaseElapsed(job) < JOB_CLAMP_SETTLE_MS) return;
+    StepperConfig e0Config, e1Config;
+    readStepperConfig(STEPPER_E0, e0Config);
+    readStepperConfig(STEPPER_E1, e1Config);
+    configureClampAxes(e0Config.maxSpeed, e1Config.maxSpeed, e0Config.acceleration, e1Config.acceleration);
+    startClampAxes(job.target, job.target);
+    LOG_INFO({
+      Log.print(F("Движение E0 и E1 к позиции: "));
+      Log.println(job.target);
+    });
+    job.lastProgress = now;
+    enterPhase(job, PHASE_TRAVEL);
+    return;
+  }
+
+  if (!maskRunning(CLAMP_AXES)) {
+    LOG_INFO({
+      Log.print(F("Движение завершено - E0: "));
+      Log.print(e0Stepper.getCurrent());
+      Log.print(F(", E1: "));
+      Log.println(e1Stepper.getCurrent());
+    });
+    printClampSkew();
+    finishJob(STEPPER_E0, JOB_RESULT_OK);
+    return;
+  }
+
+  if (phaseElapsed(job) >= HOMING_TIMEOUT) {
+    LOG_ERROR(Log.println(F("Ошибка: Таймаут выполнения команды clamp")));
+    finishJob(STEPPER_E0, JOB_RESULT_FAILED);
+    return;
+  }
+
+  LOG_DEBUG({
+    if (now - job.lastProgress >= JOB_MOVE_PROGRESS_MS) {
+      job.lastProgress = now;
+      Log.print(F("Прогресс - E0: "));
+      Log.print(stepEngineGetPosition(STEPPER_E0));
+      Log.print(F("/"));
+      Log.print(job.target);
+      Log.print(F(", E1: "));
+      Log.print(stepEngineGetPosition(STEPPER_E1));
+      Log.print(F("/"));
+      Log.println(job.target);
+    }
+  });
+}
+
+bool startClampZeroJob(bool notify) {
+  if (!claimClampAxes()) return false;
+
+  LOG_INFO(Log.println(F("Начало процедуры clamp_zero")));
+
+  MotionJob& job = prepareJob(STEPPER_E0, JOB_CLAMP_ZERO, CLAMP_AXES, notify);
+  readStepperConfig(STEPPER_E0, job.config);
+  job.errorCode = MSG_CLAMP_ZERO_FAILED;
+
+  stopMask(CLAMP_AXES);
+  enterPhase(job, PHASE_SETTLE);
+  return true;
+}
+
+static inline bool clampSensor(const MotionJob& job) {
+  return readEndstopWithType(CLAMP_SENSOR_PIN, job.config.endstopTypeNPN);
+}
+
+static void beginClampSeek(MotionJob& job) {
+  LOG_INFO({
+    Log.print(F("Движение к датчику (тип: "));
+    Log.print(job.config.endstopTypeNPN ? F("NPN") : F("PNP"));
+    Log.println(F(")..."));
+  });
+  startClampAxes(e0Stepper.getCurrent() - 5000, e1Stepper.getCurrent() - 5000);
+  armJobLatch(job, CLAMP_SENSOR_PIN, job.config.endstopTypeNPN);
+  enterPhase(job, PHASE_SEEK);
+}
+
+static void serviceClampZeroJob(MotionJob& job) {
+  switch (job.phase) {
+    case PHASE_SETTLE: {
+      if (phaseElapsed(job) < JOB_HOME_SETTLE_MS) return;
+      StepperConfig e1Config;
+      readStepperConfig(STEPPER_E1, e1Config);
+      configureClampAxes(job.config.homingSpeed, e1Config.homingSpeed, job.config.acceleration, e1Config.acceleration);
+
+      if (clampSensor(job)) {
+        LOG_INFO(Log.println(F("Датчик уже активен, начинаю отъезд")));
+        startClampAxes(e0Stepper.getCurrent() + 200, e1Stepper.getCurrent() + 200);
+        enterPhase(job, PHASE_ESCAPE);
+      } else {
+        beginClampSeek(job);
+      }
+      break;
+    }
+
+    case PHASE_ESCAPE:
+      if (maskRunning(CLAMP_AXES) && phaseElapsed(job) < JOB_CLAMP_ESCAPE_TIMEOUT_MS) return;
+      stopMask(CLAMP_AXES);
+      enterPhase(job, PHASE_ESCAPE_SETTLE);
+      break;
+
+    case PHASE_ESCAPE_SETTLE:
+      if (phaseElapsed(job) < JOB_HOME_SETTLE_MS) return;
+      beginClampSeek(job);
+      break;
+
+    case PHASE_SEEK: {
+      bool fired = jobLatchFired(job);
+      if (fired || clampSensor(job)) {
+        stopMask(CLAMP_AXES);
+        LOG_INFO(Log.println(F("Датчик сработал")));
+        if (fired) {
+          e0Stepper.setCurrent(e0Stepper.getCurrent() - endstopLatchPosition(STEPPER_E0));
+          e1Stepper.setCurrent(e1Stepper.getCurrent() - endstopLatchPosition(STEPPER_E1));
+        } else {
+          e0Stepper.setCurrent(0);
+          e1Stepper.setCurrent(0);
+        }
+        releaseJobLatch(job);
+        enterPhase(job, PHASE_ZERO_SETTLE);
+        return;
+      }
+      if (phaseElapsed(job) >= HOMING_TIMEOUT) {
+        LOG_ERROR(Log.println(F("Ошибка: Таймаут при движении к датчику")));
+        finishJob(STEPPER_E0, JOB_RESULT_FAILED);
+      }
+      break;
+    }
+
+    case PHASE_ZERO_SETTLE:
+      if (phaseElapsed(job) < JOB_ZERO_SETTLE_MS) return;
+      LOG_INFO(Log.println(F("Отъезд от датчика...")));
+      startClampAxes(100, 100);
+      enterPhase(job, PHASE_BACKOFF);
+      break;
+
+    case PHASE_BACKOFF:
+      if (maskRunning(CLAMP_AXES)) {
+        if (phaseElapsed(job) >= JOB_BACKOFF_TIMEOUT_MS) {
+          LOG_ERROR(Log.println(F("Ошибка: Таймаут отъезда от датчика")));
+          finishJob(STEPPER_E0, JOB_RESULT_FAILED);
+        }
+        return;
+      }
+      LOG_INFO({
+        Log.print(F("Обнуление завершено - E0: "));
+        Log.print(e0Stepper.getCurrent());
+        Log.print(F(", E1: "));
+        Log.println(e1Stepper.getCurrent());
+      });
+      printClampSkew();
+
+      if (e0Stepper.getCurrent() != 100 || e1Stepper.getCurrent() != 100) {
+        LOG_INFO(Log.println(F("Коррекция позиций до 100")));
+        e0Stepper.setCurrent(100);
+        e1Stepper.setCurrent(100);
+      }
+      finishJob(STEPPER_E0, JOB_RESULT_OK);
+      break;
+
+    default:
+      break;
+  }
+}
+
+// ============== ЗАДАНИЕ ПЕРЕМЕШИВАНИЯ ==============
+bool startAgitateJob(StepperType type, long amplitude, int speed, uint16_t cycles, unsigned long duration, bool notify) {
+  if (speed == 0 || (cycles == 0) == (duration == 0)) {
+    LOG_ERROR(Log.println(F("Ошибка: перемешиванию нужны скорость и число циклов или время")));
+    return false;
+  }
+
+  if ((type == STEPPER_E0 || type == STEPPER_E1) && isClampInProgress()) {
+    LOG_ERROR(Log.println(F("Ошибка: Двигатели E0/E1 заняты командой clamp")));
+    return false;
+  }
+
+  if (isAxisBusy(type)) {
+    LOG_ERROR({
+      Log.print(F("Ошибка: ось "));
+      Log.print(getAxisName(type));
+      Log.println(F(" занята другим заданием"));
+    });
+    return false;
+  }
+
+  MotionJob& job = prepareJob(type, JOB_AGITATE, STEP_ENGINE_AXIS_BIT(type), notify);
+  readStepperConfig(type, job.config);
+  job.errorCode = MSG_AGITATE_FAILED;
+  job.origin = getStepperByType(type)->getCurrent();
+  job.amplitude = amplitude;
+  job.dir = (speed < 0) ? -1 : 1;
+  job.cycles = 0;
+  job.cycleLimit = cycles;
+  job.duration = duration;
+  job.stopRequested = false;
+
+  // Скорость не выше предела оси; запас цели вращения - путь торможения и 1/8 с хода
+  uint16_t cruise = min((long)abs(speed), (long)job.config.maxSpeed);
+  job.brakeSteps = (uint32_t)cruise * cruise / (2UL * job.config.acceleration) + cruise / 8 + 1;
+  stepEngineSetMaxSpeed(type, cruise);
+
+  LOG_INFO({
+    Log.print(F("Перемешивание "));
+    Log.print(getAxisName(type));
+    Log.print(amplitude ? F(": ход ") : F(": вращение"));
+    if (amplitude) Log.print(amplitude);
+    Log.print(F(", скорость "));
+    Log.println(cruise);
+  });
+
+  if (amplitude) {
+    job.target = job.origin + amplitude;
+    enterPhase(job, PHASE_STROKE_OUT);
+  } else {
+    // Число оборотов - один ход; по времени цель отодвигается в serviceAgitateJob()
+    job.target = job.origin + job.dir * (cycles ? (long)cycles * job.config.stepsPerRevolution : 2 * job.brakeSteps);
+    enterPhase(job, PHASE_ROTATE);
+  }
+  stepEngineMoveTo(type, job.target);
+  return true;
+}
+
+static void serviceAgitateJob(StepperType type, MotionJob& job) {
+  long current = stepEngineGetPosition(type);
+  bool timeUp = job.duration && millis() - job.jobStart >= job.duration;
+
+  switch (job.phase) {
+    case PHASE_STROKE_OUT:
+    case PHASE_STROKE_BACK: {
+      if (stepEngineIsRunning(type)) {
+        if (phaseElapsed(job) > HOMING_TIMEOUT) finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+      bool out = (job.phase == PHASE_STROKE_OUT);
+      if (current != (out ? job.target : job.origin)) {
+        finishJob(type, JOB_RESULT_FAILED);
+        return;
+      }
+      if (out) {
+        stepEngineMoveTo(type, job.origin);
+        enterPhase(job, PHASE_STROKE_BACK);
+        return;
+      }
+      // Цикл заканчивается в исходной позиции - остановка и время проверяются только здесь
+      job.cycles++;
+      if ((job.cycleLimit && job.cycles >= job.cycleLimit) || timeUp || job.stopRequested) {
+        finishJob(type, JOB_RESULT_OK);
+        return;
+      }
+      stepEngineMoveTo(type, job.target);
+      enterPhase(job, PHASE_STROKE_OUT);
+      break;
+    }
+
+    case PHASE_ROTATE:
+    case PHASE_ROTATE_STOP: {
+      if (job.config.stepsPerRevolution > 0) job.cycles = labs(current - job.origin) / job.config.stepsPerRevolution;
+      if (!stepEngineIsRunning(type)) {
+        finishJob(type, current == job.target ? JOB_RESULT_OK : JOB_RESULT_FAILED);
+        return;
+      }
+      if (job.phase == PHASE_ROTATE_STOP) return;
+
+      long ahead = job.dir * (job.target - current);
+      if (timeUp || job.stopRequested) {
+        // Торможение на пути brakeSteps, если до цели дальше
+        if (ahead > job.brakeSteps) {
+          job.target = current + job.dir * job.brakeSteps;
+          stepEngineMoveTo(type, job.target);
+        }
+        enterPhase(job, PHASE_ROTATE_STOP);
+        return;
+      }
+      // Ход в ту же сторону продолжается с текущего участка профиля - без остановки
+      if (!job.cycleLimit && ahead < job.brakeSteps) {
+        job.target = current + job.dir * 2 * job.brakeSteps;
+        stepEngineMoveTo(type, job.target);
+      }
+      break;
+    }
+
+    default:
+      break;
+  }
+}
+
+void stopAgitateJob(StepperType type) {
+  if (jobs[type].kind == JOB_AGITATE) jobs[type].stopRequested = true;
+}
+
+uint16_t getAgitateCycles(StepperType type) {
+  return jobs[type].cycles;
+}
+
+// ============== ГРУППОВОЙ ХОМИНГ ==============
+// Датчик, по которому обнуляется ось (E0/E1 - общий датчик clamp)
+static int homingSensorPin(StepperType type) {
+  return getAxisEndstopPin(type);
+}
+
+// Слот и маска задания, которым обнуляется ось из маски батча
+static uint8_t batchUnitMask(uint8_t mask, StepperType type) {
+  if ((type == STEPPER_E0 || type == STEPPER_E1) && (mask & CLAMP_AXES) == CLAMP_AXES) return CLAMP_AXES;
+  return STEP_ENGINE_AXIS_BIT(type);
+}
+
+static bool sensorInUse(int pin) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if ((batch.running & STEP_ENGINE_AXIS_BIT(i)) && homingSensorPin((StepperType)i) == pin) return true;
+  }
+  return false;
+}
+
+bool startHomingBatch(uint8_t axisMask, bool notify) {
+  axisMask &= (1 << STEP_ENGINE_AXES) - 1;
+  if (!axisMask) {
+    LOG_ERROR(Log.println(F("Ошибка: пустая маска осей")));
+    return false;
+  }
+  if (batch.active) {
+    LOG_ERROR(Log.println(F("Ошибка: групповой хоминг уже выполняется")));
+    return false;
+  }
+  if (maskBusy(axisMask)) {
+    LOG_ERROR(Log.println(F("Ошибка: одна из осей занята другим заданием")));
+    return false;
+  }
+
+  LOG_INFO({
+    Log.print(F("Групповой хоминг, маска осей: "));
+    Log.println(axisMask);
+  });
+
+  batch.active = true;
+  batch.notify = notify;
+  batch.pending = axisMask;
+  batch.running = 0;
+  batch.failed = 0;
+  batch.result = JOB_RESULT_NONE;
+  batch.start = millis();
+  return true;
+}
+
+static void serviceHomingBatch() {
+  if (!batch.active) return;
+
+  // Завершившиеся задания
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    uint8_t bit = STEP_ENGINE_AXIS_BIT(i);
+    if (!(batch.running & bit) || isMotionJobActive((StepperType)i)) continue;
+    uint8_t unit = batchUnitMask(batch.running, (StepperType)i);
+    // Задание clamp_zero живёт в слоте E0, бит E1 снимается вместе с ним
+    if (unit == CLAMP_AXES && i != STEPPER_E0) continue;
+    if (jobs[i].result != JOB_RESULT_OK) batch.failed |= unit;
+    batch.running &= ~unit;
+  }
+
+  // Запуск ожидающих осей: оси с общим датчиком обнуляются по очереди
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    StepperType type = (StepperType)i;
+    if (!(batch.pending & STEP_ENGINE_AXIS_BIT(i))) continue;
+    uint8_t unit = batchUnitMask(batch.pending, type);
+    if (unit == CLAMP_AXES && i != STEPPER_E0) continue;
+    if (sensorInUse(homingSensorPin(type))) continue;
+
+    bool started = (unit == CLAMP_AXES) ? startClampZeroJob(false)
+                                        : startHomeJob(type, false);
+    batch.pending &= ~unit;
+    if (started) batch.running |= unit;
+    else batch.failed |= unit;
+  }
+
+  if (batch.pending || batch.running) return;
+
+  batch.active = false;
+  batch.result = batch.failed ? JOB_RESULT_FAILED : JOB_RESULT_OK;
+  // Через Log: в двоичном режиме очередь заглушена, кадры BIN_OP_HOME_MASK не рвутся
+  LOG_INFO({
+    Log.print(F("Групповой хоминг завершен за "));
+    Log.print(millis() - batch.start);
+    Log.println(F(" мс"));
+  });
+
+  if (batch.notify) {
+    if (batch.result == JOB_RESULT_OK) {
+      Serial.print(MSG_COMPLETED);
+    } else {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(MSG_HOMING_TIMEOUT);
+      Serial.print(' ');
+      Serial.print(batch.failed);
+    }
+    Serial.println(F(" zero"));
+  }
+}
+
+bool waitHomingBatch() {
+  while (batch.active) {
+    serviceMotionJobs();
+    serviceLog();
+    yield();
+  }
+  return batch.result == JOB_RESULT_OK;
+}
+
+bool isHomingBatchActive() {
+  return batch.active;
+}
+
+uint8_t getHomingBatchFailed() {
+  return batch.failed;
+}
+
+bool isAxisHomed(StepperType type) {
+  return homed[type];
+}
+
+bool getHomingDrift(StepperType type, long& drift) {
+  if (!homeDriftValid[type]) return false;
+  drift = homeDrift[type];
+  return true;
+}
+
+// ============== ОБСЛУЖИВАНИЕ И СОСТОЯНИЕ ==============
+void initializeMotionJobs() {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    jobs[i].kind = JOB_NONE;
+    jobs[i].result = JOB_RESULT_NONE;
+    jobs[i].axisMask = 0;
+    homed[i] = false;
+    homeDriftValid[i] = false;
+  }
+  batch.active = false;
+  batch.result = JOB_RESULT_NONE;
+}
+
+void serviceMotionJobs() {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    MotionJob& job = jobs[i];
+    switch (job.kind) {
+      case JOB_MOVE: serviceMoveJob((StepperType)i, job); break;
+      case JOB_HOME: serviceHomeJob((StepperType)i, job); break;
+      case JOB_CLAMP: serviceClampJob(job); break;
+      case JOB_CLAMP_ZERO: serviceClampZeroJob(job); break;
+      case JOB_AGITATE: serviceAgitateJob((StepperType)i, job); break;
+      default: break;
+    }
+  }
+  serviceHomingBatch();
+}
+
+bool waitMotionJob(StepperType type) {
+  while (jobs[type].kind != JOB_NONE) {
+    serviceMotionJobs();
+    serviceLog();
+    yield();
+  }
+  return jobs[type].result == JOB_RESULT_OK;
+}
+
+void abortMotionJobs(uint8_t axisMask) {
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if (jobs[i].kind != JOB_NONE && (jobs[i].axisMask & axisMask)) {
+      finishJob((StepperType)i, JOB_RESULT_ABORTED);
+    }
+  }
+}
+
+bool isMotionJobActive(StepperType type) {
+  return jobs[type].kind != JOB_NONE;
+}
+
+MotionJobKind getMotionJobKind(StepperType type) {
+  return jobs[type].kind;
+}
+
+MotionJobResult getMotionJobResult(StepperType type) {
+  return jobs[type].result;
+}
+
+void setAsyncMode(bool enabled) {
+  asyncMode = enabled;
+}
+
+bool isAsyncMode() {
+  return asyncMode;
+}
+
+uint16_t getMotionJobsMemory() {
+  return sizeof(jobs) + sizeof(batch) + sizeof(homed) + sizeof(homeDrift) + sizeof(homeDriftValid);
+}
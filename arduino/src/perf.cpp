@@ -0,0 +1,107 @@
+/**
+ * @file: perf.cpp
+ * @description: Счётчики длительности основного цикла, разбора команд, чтения HX711 и запаса ОЗУ
+ * @dependencies: config.h
+ * @created: 2026-10-14
+ *
+ * Для каждого участка хранятся число замеров, сумма и максимум в микросекундах.
+ * Минимальный запас ОЗУ определяется по разметке: при старте свободная область между
+ * кучей и стеком заполняется PERF_STACK_PAINT, нетронутые байты у границы кучи
+ * показывают, насколько глубоко стек опускался с тех пор.
+ */
+
+#include "perf.h"
+
+#if PERF_ENABLED
+
+#include <Arduino.h>
+#include <util/atomic.h>
+
+extern char __data_start;
+extern char __heap_start;
+extern char* __brkval;
+
+static PerfCounter counters[PERF_COUNTER_COUNT];
+static uint32_t lastLoopTime = 0;
+static uint32_t commandStart = 0;
+static bool commandPending = false;
+
+static uint8_t* heapEnd() {
+  return (uint8_t*)(__brkval ? __brkval : &__heap_start);
+}
+
+void initializePerf() {
+  // Граница стека - адресом: &top - N как указатель выходит за пределы объекта (-Warray-bounds)
+  uint8_t top;
+  uintptr_t end = (uintptr_t)&top - PERF_STACK_GUARD;
+  for (uintptr_t p = (uintptr_t)heapEnd(); p < end; p++) *(uint8_t*)p = PERF_STACK_PAINT;
+  perfReset();
+}
+
+void perfRecord(PerfCounterId id, uint32_t us) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    PerfCounter& counter = counters[id];
+    counter.count++;
+    counter.totalUs += us;
+    if (us > counter.maxUs) counter.maxUs = us;
+  }
+}
+
+void perfLoopTick() {
+  uint32_t now = micros();
+  if (lastLoopTime) perfRecord(PERF_LOOP, now - lastLoopTime);
+  lastLoopTime = now;
+}
+
+void perfCommandStart() {
+  commandStart = micros();
+  commandPending = true;
+}
+
+void perfCommandDispatched() {
+  if (!commandPending) return;
+  commandPending = false;
+  perfRecord(PERF_COMMAND, micros() - commandStart);
+}
+
+void perfGetCounter(PerfCounterId id, PerfCounter* counter) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    *counter = counters[id];
+  }
+}
+
+void perfReset() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < PERF_COUNTER_COUNT; i++) {
+      counters[i].count = 0;
+      counters[i].totalUs = 0;
+      counters[i].maxUs = 0;
+    }
+  }
+  // Первый период после сброса включал бы вывод самого отчёта
+  lastLoopTime = 0;
+}
+
+uint16_t getFreeMemory() {
+  uint8_t top;
+  return (uintptr_t)&top - (uintptr_t)heapEnd();
+}
+
+uint16_t getMinFreeMemory() {
+  uint8_t top;
+  uint16_t untouched = 0;
+  for (uintptr_t p = (uintptr_t)heapEnd(); p < (uintptr_t)&top && *(const uint8_t*)p == PERF_STACK_PAINT; p++) {
+    untouched++;
+  }
+  return untouched;
+}
+
+uint16_t getStaticMemory() {
+  return &__heap_start - &__data_start;
+}
+
+uint16_t getHeapMemory() {
+  return __brkval ? __brkval - &__heap_start : 0;
+}
+
+#endif // PERF_ENABLED
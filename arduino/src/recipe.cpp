@@ -0,0 +1,417 @@
+/**
+ * @file: recipe.cpp
+ * @description: Выполнение рецептов (последовательностей шагов) из EEPROM или буфера ОЗУ
+ * @dependencies: motion_jobs, valves, dosing, binary_protocol, NBHX711, EEPROM, config.h
+ * @created: 2026-10-14
+ *
+ * Шаг запускает задание движения, хоминг, импульс или дозу без событий для хоста и
+ * ждёт его завершения опросом из loop(), как binary_protocol. Хост получает только
+ * строку о каждом завершённом шаге и итог, поэтому задержки и паузы на его стороне
+ * не останавливают процесс. При ошибке или прерывании насос и клапаны выключаются.
+ */
+
+#include "recipe.h"
+#include "motion_jobs.h"
+#include "step_engine.h"
+#include "valves.h"
+#include "dosing.h"
+#include "weight_sampler.h"
+#include "binary_protocol.h"
+#include "log.h"
+#include <Arduino.h>
+#include <EEPROM.h>
+#include <NBHX711.h>
+#include <util/crc16.h>
+
+extern NBHX711 scale;
+
+// Слот EEPROM: RECIPE_MAGIC, число шагов, CRC16 LE по числу шагов и шагам, шаги
+#define RECIPE_MAGIC 0x5A
+#define RECIPE_HEADER_SIZE 4
+#define RECIPE_SLOT_SIZE (RECIPE_HEADER_SIZE + RECIPE_MAX_STEPS * sizeof(RecipeStep))
+
+static_assert(RECIPE_EEPROM_BASE + RECIPE_SLOTS * RECIPE_SLOT_SIZE <= E2END + 1,
+              "Слоты рецептов не помещаются в EEPROM");
+
+// ============== ИМЕНА ШАГОВ ==============
+static const char nameEnd[] PROGMEM = "end";
+static const char nameMove[] PROGMEM = "move";
+static const char nameZero[] PROGMEM = "zero";
+static const char nameClamp[] PROGMEM = "clamp";
+static const char nameClampZero[] PROGMEM = "clamp_zero";
+static const char nameOutput[] PROGMEM = "output";
+static const char namePulse[] PROGMEM = "pulse";
+static const char nameDose[] PROGMEM = "dose";
+static const char nameWaitWeight[] PROGMEM = "wait_weight";
+static const char nameDelay[] PROGMEM = "delay";
+
+static const char* const opNames[RECIPE_OP_COUNT] PROGMEM = {
+  nameEnd, nameMove, nameZero, nameClamp, nameClampZero,
+  nameOutput, namePulse, nameDose, nameWaitWeight, nameDelay
+};
+
+typedef enum {
+  RUN_IDLE,
+  RUN_START,     // следующий шаг ещё не запущен
+  RUN_WAIT       // шаг запущен, ждём завершения
+} RunState;
+
+static RecipeStep buffer[RECIPE_MAX_STEPS];
+static uint8_t bufferLength = 0;
+
+static RunState runState = RUN_IDLE;
+static uint8_t runId = RECIPE_RAM_ID;
+static uint8_t runLength = 0;
+static uint8_t stepIndex = 0;         // текущий шаг, он же число завершённых
+static RecipeStep current;
+static unsigned long stepStartTime = 0;
+static bool notifyHost = false;
+static const char* lastRecipeError = nullptr;
+
+// ============== EEPROM ==============
+static int slotAddress(uint8_t id) {
+  return RECIPE_EEPROM_BASE + id * RECIPE_SLOT_SIZE;
+}
+
+static int stepAddress(uint8_t id, uint8_t index) {
+  return slotAddress(id) + RECIPE_HEADER_SIZE + index * sizeof(RecipeStep);
+}
+
+static uint16_t updateCrc(uint16_t crc, const RecipeStep& step) {
+  const uint8_t* bytes = (const uint8_t*)&step;
+  for (uint8_t i = 0; i < sizeof(RecipeStep); i++) crc = _crc_ccitt_update(crc, bytes[i]);
+  return crc;
+}
+
+// ============== ВЫХОДЫ ==============
+static int outputPin(uint8_t output) {
+  switch (output) {
+    case 1: return KL1_PIN;
+    case 2: return KL2_PIN;
+    default: return PUMP_PIN;
+  }
+}
+
+static void setOutput(uint8_t output, bool on) {
+  if (output == 0) {
+    setPumpState(on);
+  } else {
+    setValveState(outputPin(output), on);
+  }
+}
+
+static void stopOutputs() {
+  setPumpState(false);
+  setValveState(KL1_PIN, false);
+  setValveState(KL2_PIN, false);
+}
+
+// ============== ПРОВЕРКА ШАГА ==============
+static bool isValidStep(const RecipeStep& step) {
+  switch (step.op) {
+    case RECIPE_MOVE: return step.arg < STEP_ENGINE_AXES;
+    case RECIPE_ZERO: return step.arg > 0 && step.arg < (1 << STEP_ENGINE_AXES);
+    case RECIPE_CLAMP:
+    case RECIPE_CLAMP_ZERO:
+    case RECIPE_WAIT_WEIGHT: return true;
+    case RECIPE_OUTPUT: return step.arg < 3 && (step.value == 0 || step.value == 1);
+    case RECIPE_PULSE: return step.arg < 3 && step.value > 0 && step.value <= VALVE_PULSE_MAX_MS;
+    case RECIPE_DOSE: return step.arg < DOSE_ACTUATOR_COUNT && step.value > 0 && step.value <= DOSE_MAX_GRAMS * 100L;
+    case RECIPE_DELAY: return step.value >= 0;
+    default: return false;
+  }
+}
+
+// ============== ВЫПОЛНЕНИЕ ШАГА ==============
+static const char* jobError(StepperType slot) {
+  switch (getMotionJobResult(slot)) {
+    case JOB_RESULT_OK: return nullptr;
+    case JOB_RESULT_ABORTED: return MSG_JOB_ABORTED;
+    default: return MSG_RECIPE_STEP;
+  }
+}
+
+static const char* startStep() {
+  switch (current.op) {
+    case RECIPE_MOVE: {
+      StepperType type = (StepperType)current.arg;
+      if (startMoveJob(type, current.value, false)) return nullptr;
+      return isAxisBusy(type) ? MSG_AXIS_BUSY : MSG_INVALID_PARAMETER;
+    }
+
+    case RECIPE_ZERO:
+      return startHomingBatch(current.arg, false) ? nullptr : MSG_AXIS_BUSY;
+
+    case RECIPE_CLAMP:
+      return startClampJob(current.value, false) ? nullptr : MSG_AXIS_BUSY;
+
+    case RECIPE_CLAMP_ZERO:
+      return startClampZeroJob(false) ? nullptr : MSG_AXIS_BUSY;
+
+    case RECIPE_OUTPUT:
+      setOutput(current.arg, current.value != 0);
+      return nullptr;
+
+    case RECIPE_PULSE:
+      return startValvePulse(outputPin(current.arg), current.value, 1, 0, false) ? nullptr : MSG_INVALID_PARAMETER;
+
+    case RECIPE_DOSE:
+      return startDose(current.value / 100.0, (DoseActuator)current.arg, false) ? nullptr : getLastDoseError();
+
+    default:
+      return nullptr;
+  }
+}
+
+// true - шаг завершён (error - его результат)
+static bool pollStep(const char*& error) {
+  switch (current.op) {
+    case RECIPE_MOVE:
+      if (isMotionJobActive((StepperType)current.arg)) return false;
+      error = jobError((StepperType)current.arg);
+      return true;
+
+    case RECIPE_ZERO:
+      if (isHomingBatchActive()) return false;
+      error = getHomingBatchFailed() ? MSG_RECIPE_STEP : nullptr;
+      return true;
+
+    case RECIPE_CLAMP:
+    case RECIPE_CLAMP_ZERO:
+      if (isMotionJobActive(STEPPER_E0)) return false;
+      error = jobError(STEPPER_E0);
+      return true;
+
+    case RECIPE_PULSE:
+      return !isValvePulseActive(outputPin(current.arg));
+
+    case RECIPE_DOSE:
+      if (isDoseActive()) return false;
+      error = getLastDoseError();
+      return true;
+
+    case RECIPE_WAIT_WEIGHT:
+      if (getWeightSampleAge() <= WEIGHT_SAMPLE_STALE_MS && scale.getUnits(5) * 100.0 >= current.value) return true;
+      if (millis() - stepStartTime <= RECIPE_WAIT_TIMEOUT_MS) return false;
+      error = MSG_RECIPE_TIMEOUT;
+      return true;
+
+    case RECIPE_DELAY:
+      return millis() - stepStartTime >= (unsigned long)current.value;
+
+    default:
+      return true;
+  }
+}
+
+static void stopStep() {
+  switch (current.op) {
+    case RECIPE_MOVE: abortMotionJobs(STEP_ENGINE_AXIS_BIT(current.arg)); break;
+    case RECIPE_ZERO: abortMotionJobs(current.arg); break;
+    case RECIPE_CLAMP:
+    case RECIPE_CLAMP_ZERO: abortMotionJobs(STEP_ENGINE_AXIS_BIT(STEPPER_E0) | STEP_ENGINE_AXIS_BIT(STEPPER_E1)); break;
+    case RECIPE_DOSE: abortDose(); break;
+    default: break;
+  }
+}
+
+static void finishRecipe(const char* error) {
+  if (error) stopOutputs();
+  lastRecipeError = error;
+  runState = RUN_IDLE;
+
+  if (notifyHost && !isBinaryMode()) {
+    if (error) {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(error);
+      Serial.print(' ');
+      Serial.print(stepIndex);
+    } else {
+      Serial.print(MSG_COMPLETED);
+    }
+    Serial.println(F(" recipe"));
+  }
+}
+
+static void reportStep() {
+  if (isBinaryMode()) return;
+  Serial.print(F("STEP "));
+  Serial.print(stepIndex);
+  Serial.print(' ');
+  Serial.println(getRecipeOpName(current.op));
+}
+
+// ============== ИНТЕРФЕЙС ==============
+void initializeRecipes() {
+  bufferLength = 0;
+  runState = RUN_IDLE;
+}
+
+bool clearRecipeBuffer() {
+  if (runState != RUN_IDLE && runId == RECIPE_RAM_ID) return false;
+  bufferLength = 0;
+  return true;
+}
+
+bool appendRecipeStep(const RecipeStep& step) {
+  if (bufferLength >= RECIPE_MAX_STEPS || !isValidStep(step)) return false;
+  if (runState != RUN_IDLE && runId == RECIPE_RAM_ID) return false;
+  buffer[bufferLength++] = step;
+  return true;
+}
+
+bool saveRecipe(uint8_t id) {
+  if (id >= RECIPE_SLOTS || bufferLength == 0) return false;
+  if (runState != RUN_IDLE && runId == id) return false;
+
+  uint16_t crc = _crc_ccitt_update(0xFFFF, bufferLength);
+  for (uint8_t i = 0; i < bufferLength; i++) {
+    EEPROM.put(stepAddress(id, i), buffer[i]);
+    crc = updateCrc(crc, buffer[i]);
+  }
+  // Заголовок пишется последним: прерванная запись даёт слот с неверной CRC
+  int address = slotAddress(id);
+  EEPROM.update(address + 1, bufferLength);
+  EEPROM.update(address + 2, crc & 0xFF);
+  EEPROM.update(address + 3, crc >> 8);
+  EEPROM.update(address, RECIPE_MAGIC);
+  return true;
+}
+
+bool loadRecipe(uint8_t id) {
+  if (runState != RUN_IDLE && runId == RECIPE_RAM_ID) return false;
+  uint8_t length = id < RECIPE_SLOTS ? getRecipeLength(id) : 0;
+  if (length == 0) return false;
+
+  for (uint8_t i = 0; i < length; i++) EEPROM.get(stepAddress(id, i), buffer[i]);
+  bufferLength = length;
+  return true;
+}
+
+uint8_t getRecipeLength(uint8_t id) {
+  if (id == RECIPE_RAM_ID) return bufferLength;
+  if (id >= RECIPE_SLOTS) return 0;
+
+  int address = slotAddress(id);
+  uint8_t length = EEPROM.read(address + 1);
+  if (EEPROM.read(address) != RECIPE_MAGIC || length == 0 || length > RECIPE_MAX_STEPS) return 0;
+
+  uint16_t stored = EEPROM.read(address + 2) | ((uint16_t)EEPROM.read(address + 3) << 8);
+  uint16_t crc = _crc_ccitt_update(0xFFFF, length);
+  for (uint8_t i = 0; i < length; i++) {
+    RecipeStep step;
+    EEPROM.get(stepAddress(id, i), step);
+    crc = updateCrc(crc, step);
+  }
+  return crc == stored ? length : 0;
+}
+
+bool getRecipeStep(uint8_t id, uint8_t index, RecipeStep& step) {
+  if (id == RECIPE_RAM_ID) {
+    if (index >= bufferLength) return false;
+    step = buffer[index];
+    return true;
+  }
+  if (id >= RECIPE_SLOTS || index >= EEPROM.read(slotAddress(id) + 1)) return false;
+  EEPROM.get(stepAddress(id, index), step);
+  return true;
+}
+
+const __FlashStringHelper* getRecipeOpName(uint8_t op) {
+  if (op >= RECIPE_OP_COUNT) op = RECIPE_END;
+  return (const __FlashStringHelper*)pgm_read_ptr(&opNames[op]);
+}
+
+uint8_t findRecipeOp(const char* name) {
+  for (uint8_t op = RECIPE_END + 1; op < RECIPE_OP_COUNT; op++) {
+    if (strcmp_P(name, (PGM_P)pgm_read_ptr(&opNames[op])) == 0) return op;
+  }
+  return RECIPE_OP_COUNT;
+}
+
+bool startRecipe(uint8_t id, bool notify) {
+  if (runState != RUN_IDLE) {
+    lastRecipeError = MSG_RECIPE_BUSY;
+    return false;
+  }
+  uint8_t length = getRecipeLength(id);
+  if (length == 0) {
+    lastRecipeError = MSG_RECIPE_EMPTY;
+    return false;
+  }
+
+  runId = id;
+  runLength = length;
+  stepIndex = 0;
+  notifyHost = notify;
+  lastRecipeError = nullptr;
+  runState = RUN_START;
+  return true;
+}
+
+void serviceRecipe() {
+  // Мгновенные шаги (output) выполняются подряд за один вызов
+  while (runState != RUN_IDLE) {
+    const char* error = nullptr;
+    if (runState == RUN_START) {
+      if (stepIndex >= runLength) {
+        finishRecipe(nullptr);
+        return;
+      }
+      // Шаг из EEPROM мог повредиться после проверки CRC при запуске
+      if (!getRecipeStep(runId, stepIndex, current) || !isValidStep(current)) {
+        finishRecipe(MSG_RECIPE_EMPTY);
+        return;
+      }
+      error = startStep();
+      stepStartTime = millis();
+      runState = RUN_WAIT;
+    }
+
+    if (!error && !pollStep(error)) return;
+    if (error) {
+      finishRecipe(error);
+      return;
+    }
+
+    reportStep();
+    stepIndex++;
+    runState = RUN_START;
+  }
+}
+
+bool waitRecipe() {
+  while (runState != RUN_IDLE) {
+    serviceRecipe();
+    serviceMotionJobs();
+    serviceWeightSampler();
+    serviceDosing();
+    serviceValves();
+    serviceLog();
+    yield();
+  }
+  return lastRecipeError == nullptr;
+}
+
+void abortRecipe() {
+  if (runState == RUN_IDLE) return;
+  if (runState == RUN_WAIT) stopStep();
+  finishRecipe(MSG_JOB_ABORTED);
+}
+
+bool isRecipeActive() {
+  return runState != RUN_IDLE;
+}
+
+uint8_t getRecipeStepsDone() {
+  return stepIndex;
+}
+
+const char* getLastRecipeError() {
+  return lastRecipeError;
+}
+
+uint16_t getRecipeMemory() {
+  return sizeof(buffer) + sizeof(current);
+}
@@ -3,15 +3,43 @@
  * @description: Модуль для работы с датчиками системы (ротор, отходы, концевые выключатели)
  * @dependencies: Arduino.h, config.h, stepper_control.h
  * @created: 2024-12-19
+ *
+ * Снимок входов: при инициализации пины ROTOR_PINS, WASTE_PIN и концевиков осей
+ * раскладываются по портам (регистр PINx и маска бита). readSensorSnapshot() читает каждый
+ * порт один раз при запрещённых прерываниями - все биты относятся к одному моменту.
  */
 
 #include "sensors.h"
 #include "stepper_control.h"
 #include <Arduino.h>
+#include <util/atomic.h>
+
+// Входы снимка: ротор, отходы, концевики осей
+#define SENSOR_INPUT_COUNT (4 + 1 + STEPPER_AXIS_COUNT)
 
 // Массив пинов ротора
 const byte rotorPins[4] = ROTOR_PINS;
 
+typedef struct {
+  uint8_t port;   // индекс в snapshotPorts
+  uint8_t mask;
+} SensorInput;
+
+static volatile uint8_t* snapshotPorts[SENSOR_INPUT_COUNT];
+static uint8_t snapshotPortCount = 0;
+static SensorInput sensorInputs[SENSOR_INPUT_COUNT];
+static uint16_t invertMask = 0;   // биты, активные по низкому уровню (NPN-концевики)
+
+static void mapSensorInput(uint8_t bit, uint8_t pin) {
+  volatile uint8_t* reg = portInputRegister(digitalPinToPort(pin));
+  uint8_t port = 0;
+  while (port < snapshotPortCount && snapshotPorts[port] != reg) port++;
+  if (port == snapshotPortCount) snapshotPorts[snapshotPortCount++] = reg;
+
+  sensorInputs[bit].port = port;
+  sensorInputs[bit].mask = digitalPinToBitMask(pin);
+}
+
 // Инициализация пинов датчиков
 void initializeSensors() {
   // Датчик отходов
@@ -21,36 +49,58 @@ void initializeSensors() {
   for (int i = 0; i < 4; i++) {
     pinMode(rotorPins[i], INPUT_PULLUP);
   }
+  
+  // Карта снимка входов
+  snapshotPortCount = 0;
+  invertMask = 0;
+  for (uint8_t i = 0; i < 4; i++) mapSensorInput(i, rotorPins[i]);
+  mapSensorInput(4, WASTE_PIN);
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    StepperType type = (StepperType)i;
+    mapSensorInput(SENSOR_ENDSTOP_SHIFT + i, getAxisEndstopPin(type));
+    if (getAxisEndstopNPN(type)) invertMask |= SENSOR_BIT_ENDSTOP(type);
+  }
+}
+
+// Снимок всех входов
+SensorSnapshot readSensorSnapshot() {
+  uint8_t values[SENSOR_INPUT_COUNT] = {0};
+  SensorSnapshot snapshot;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t p = 0; p < snapshotPortCount; p++) values[p] = *snapshotPorts[p];
+    snapshot.timeUs = micros();
+  }
+  
+  uint16_t bits = 0;
+  for (uint8_t i = 0; i < SENSOR_INPUT_COUNT; i++) {
+    if (values[sensorInputs[i].port] & sensorInputs[i].mask) bits |= ((uint16_t)1 << i);
+  }
+  snapshot.bits = bits ^ invertMask;
+  return snapshot;
 }
 
 // Чтение состояния ротора
 void readRotorState(char* stateBuffer) {
+  uint16_t bits = readSensorSnapshot().bits;
   for (int i = 0; i < 4; i++) {
-    stateBuffer[i] = digitalRead(rotorPins[i]) ? '1' : '0';
+    stateBuffer[i] = (bits & SENSOR_BIT_ROTOR(i)) ? '1' : '0';
   }
   stateBuffer[4] = '\0';
 }
 
 // Чтение состояния датчика отходов
 bool readWasteSensor() {
-  return digitalRead(WASTE_PIN);
+  return (readSensorSnapshot().bits & SENSOR_BIT_WASTE) != 0;
 }
 
 // Чтение состояния концевых выключателей с учетом индивидуальных настроек
 bool readEndstopState(int endstopPin) {
-  // Определяем тип датчика на основе пина
-  bool isNPN = true; // По умолчанию NPN
-  
-  if (endstopPin == MULTI_ENDSTOP_PIN) {
-    isNPN = MULTI_ENDSTOP_TYPE_NPN;
-  } else if (endstopPin == MULTIZONE_ENDSTOP_PIN) {
-    isNPN = MULTIZONE_ENDSTOP_TYPE_NPN;
-  } else if (endstopPin == RRIGHT_ENDSTOP_PIN) {
-    isNPN = RRIGHT_ENDSTOP_TYPE_NPN;
-  } else if (endstopPin == CLAMP_SENSOR_PIN) {
-    isNPN = E0_ENDSTOP_TYPE_NPN; // Используем настройки E0 для clamp датчика
+  // Тип датчика - из описания первой оси на этом пине (clamp датчик - настройки E0)
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    StepperType type = (StepperType)i;
+    if (getAxisEndstopPin(type) == endstopPin) return readAxisEndstop(type);
   }
   
-  // Используем функцию из stepper_control для корректного чтения
-  return readEndstopWithType(endstopPin, isNPN);
-} 
\ No newline at end of file
+  // Неизвестный пин - по умолчанию NPN
+  return readEndstopWithType(endstopPin, true);
+}
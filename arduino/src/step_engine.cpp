@@ -0,0 +1,709 @@
+/**
+ * @file: step_engine.cpp
+ * @description: Генерация шагов по прерываниям аппаратных таймеров для всех пяти осей
+ * @dependencies: GyverStepper2, stepper_control, perf, config.h
+ * @created: 2026-10-14
+ *
+ * Каждая ось получает свой канал сравнения 16-битного таймера Mega:
+ *   Multi - Timer1 A, Multizone - Timer3 A, RRight - Timer4 A, E0 - Timer5 A, E1 - Timer5 B.
+ * Таймеры считают свободно (0.5 мкс на тик), следующий шаг планируется как OCR += getPeriod(),
+ * поэтому моменты шагов не зависят ни от основного цикла, ни от задержки входа в прерывание.
+ *
+ * Для clamp пара E0/E1 переключается в связанный режим: канал Timer5 A тикает GPlanner2,
+ * который шагает обе оси по Брезенхему с одним профилем скорости, канал Timer5 B простаивает.
+ *
+ * При STEP_ENGINE_TABLE_PROFILE одиночные оси не используют профиль GStepper2: трапеция или
+ * S-кривая (*_JERK) собирается из участков таблицы accel_profile.h, пересчёт идёт только на границах участков.
+ * С STEP_ENGINE_FAST_PULSE такие оси шагают записью в порт STEP в начале прерывания, а спад
+ * импульса выдаётся после расчёта следующего шага: расчёт и есть длительность импульса.
+ * Первый шаг движения делает GStepper2::step() - библиотека выставляет DIR и помнит направление.
+ *
+ * События движения (stepEngineMoveTo с events) хранятся в канале как абсолютные позиции
+ * в порядке прохождения: после каждого шага обработчик сравнивает pos только с ближайшим.
+ */
+
+#include "step_engine.h"
+#include "accel_profile.h"
+#include "perf.h"
+#include <Arduino.h>
+#include <avr/pgmspace.h>
+#include <util/atomic.h>
+
+// Событие, привязанное к позиции оси
+typedef struct {
+  int32_t position;
+#ifdef __AVR__
+  volatile uint8_t* port;
+  uint8_t bit;
+#else
+  uint8_t pin;
+#endif
+  bool state;
+} ArmedEvent;
+
+// Канал таймера, обслуживающий одну ось
+typedef struct {
+  GStepper2<STEPPER2WIRE>* stepper;
+  volatile uint16_t* ocr;
+  volatile uint16_t* tcnt;
+  volatile uint8_t* timsk;
+  volatile uint8_t* tifr;
+  uint8_t mask;
+  volatile bool running;
+  uint32_t waitTicks;     // остаток длинного периода, который не уместился в одно сравнение
+  StepEngineStats stats;
+  ArmedEvent events[STEP_ENGINE_MAX_EVENTS];
+  uint8_t eventCount;
+  volatile uint8_t nextEvent;   // первое несработавшее событие
+#if STEP_ENGINE_TABLE_PROFILE
+  const AccelProfile* profile;  // таблица разгона оси (PROGMEM)
+  uint16_t periodScale;   // множитель периодов таблицы (stepEngineSetAcceleration), STEP_ENGINE_SCALE_ONE - как есть
+  uint32_t cruiseUs;      // период заданной скорости
+  uint8_t topSlice;       // участок, на котором достигается заданная скорость
+  uint8_t slice;          // текущий участок профиля, 0 - стоим
+  uint32_t sliceLeft;     // шагов до границы участка
+  uint32_t remaining;     // шагов до цели
+  uint32_t periodUs;
+  int8_t dir;
+#if STEP_ENGINE_FAST_PULSE
+  volatile uint8_t* stepPort;
+  uint8_t stepBit;
+  uint8_t stepPin;
+  bool dirSynced;         // DIR текущего движения выставлен библиотекой, дальше шаги идут через порт
+#endif
+#endif
+} EngineChannel;
+
+static EngineChannel channels[STEP_ENGINE_AXES];
+
+#if STEP_ENGINE_TABLE_PROFILE
+// Таблицы строятся до верхней скорости оси, включая скорости хоминга
+static const AccelProfile axisProfiles[STEP_ENGINE_AXES] PROGMEM = {
+  ACCEL_PROFILE(MULTI_ACCELERATION, ACCEL_PROFILE_SPEED(MULTI), MULTI_JERK),
+  ACCEL_PROFILE(MULTIZONE_ACCELERATION, ACCEL_PROFILE_SPEED(MULTIZONE), MULTIZONE_JERK),
+  ACCEL_PROFILE(RRIGHT_ACCELERATION, ACCEL_PROFILE_SPEED(RRIGHT), RRIGHT_JERK),
+  ACCEL_PROFILE(E0_ACCELERATION, ACCEL_PROFILE_SPEED(E0), E0_JERK),
+  ACCEL_PROFILE(E1_ACCELERATION, ACCEL_PROFILE_SPEED(E1), E1_JERK),
+};
+
+// Ускорения, по которым построены таблицы
+static const uint16_t profileAcceleration[STEP_ENGINE_AXES] PROGMEM = {
+  MULTI_ACCELERATION, MULTIZONE_ACCELERATION, RRIGHT_ACCELERATION, E0_ACCELERATION, E1_ACCELERATION,
+};
+
+#define STEP_ENGINE_SCALE_ONE (1U << STEP_ENGINE_SCALE_SHIFT)
+#endif
+
+// Связанный режим E0/E1
+static ClampGroupPlanner clampPlanner;
+static volatile bool groupMode = false;
+static int32_t groupStart[2];
+static int32_t groupDist[2];
+static bool groupSkewTracked;
+static uint32_t groupSkewRaw;       // max |d0 * D1 - d1 * D0|, делится на max(D0, D1) при чтении
+static uint16_t groupSkewMax;
+
+// Расстояния в пределах 46340 шагов: произведение d * D помещается в int32
+#define GROUP_SKEW_MAX_DIST 46340L
+
+// ============== ОБСЛУЖИВАНИЕ КАНАЛА (КОНТЕКСТ ПРЕРЫВАНИЯ) ==============
+static inline void writeEventOutput(const ArmedEvent& event, bool state) {
+#ifdef __AVR__
+  if (state) *event.port |= event.bit;
+  else *event.port &= ~event.bit;
+#else
+  digitalWrite(event.pin, state ? HIGH : LOW);
+#endif
+}
+
+// События на текущей позиции; несколько событий одного шага срабатывают вместе
+static inline void fireEvents(EngineChannel& ch) {
+  uint8_t next = ch.nextEvent;
+  while (next < ch.eventCount && ch.events[next].position == ch.stepper->pos) {
+    writeEventOutput(ch.events[next], ch.events[next].state);
+    next++;
+  }
+  ch.nextEvent = next;
+}
+
+// Снятие несработавших событий: выключения выполняются сейчас, включения отменяются
+static inline void releaseEvents(EngineChannel& ch) {
+  for (uint8_t i = ch.nextEvent; i < ch.eventCount; i++) {
+    if (!ch.events[i].state) writeEventOutput(ch.events[i], false);
+  }
+  ch.eventCount = 0;
+  ch.nextEvent = 0;
+}
+
+// Планирование следующего сравнения; false - момент уже прошёл и канал перенесён на ближайший тик
+static inline bool scheduleNext(EngineChannel& ch, uint32_t ticks) {
+  uint16_t chunk = (ticks > STEP_ENGINE_MAX_CHUNK) ? STEP_ENGINE_MAX_CHUNK : (uint16_t)ticks;
+  ch.waitTicks = ticks - chunk;
+  uint16_t next = *ch.ocr + chunk;
+  *ch.ocr = next;
+  if ((int16_t)(next - *ch.tcnt) < STEP_ENGINE_MIN_LEAD_TICKS) {
+    *ch.ocr = *ch.tcnt + STEP_ENGINE_MIN_LEAD_TICKS;
+    *ch.tifr = ch.mask;
+    return false;
+  }
+  return true;
+}
+
+static inline void disarmChannel(EngineChannel& ch) {
+  *ch.timsk &= ~ch.mask;
+  ch.running = false;
+}
+
+// Планирование шага после tickManual(); false - движение закончено, канал снят
+static inline void finishTick(EngineChannel& ch, bool moving, uint32_t period) {
+  ch.stats.steps++;
+  if (!moving) {
+    disarmChannel(ch);
+    return;
+  }
+
+  if (scheduleNext(ch, period * STEP_ENGINE_TICKS_PER_US)) {
+    if (period < ch.stats.minPeriodUs) ch.stats.minPeriodUs = period;
+  } else {
+    ch.stats.lateSteps++;
+  }
+}
+
+#if STEP_ENGINE_TABLE_PROFILE
+// Период участка j с учётом масштаба. Умножение 32 x 16 по частям: произведение
+// старшей части не выходит за 32 бита для периодов до 2^28 мкс
+static inline uint32_t slicePeriod(const EngineChannel& ch, uint8_t j) {
+  uint32_t period = pgm_read_dword(&ch.profile->periodUs[j]);
+  if (ch.periodScale == STEP_ENGINE_SCALE_ONE) return period;
+  return (period >> STEP_ENGINE_SCALE_SHIFT) * ch.periodScale +
+         (((period & (STEP_ENGINE_SCALE_ONE - 1)) * ch.periodScale) >> STEP_ENGINE_SCALE_SHIFT);
+}
+
+// Выбор участка на границе: разгон, удержание скорости или торможение - самый быстрый
+// участок j, после которого хватит пути на остановку (brakeSteps[j] <= remaining)
+static inline void selectSlice(EngineChannel& ch) {
+  uint8_t j = (ch.slice < ch.topSlice) ? ch.slice + 1 : ch.topSlice;
+  uint32_t brake = pgm_read_dword(&ch.profile->brakeSteps[j]);
+  while (j > 1 && brake > ch.remaining) brake = pgm_read_dword(&ch.profile->brakeSteps[--j]);
+
+  uint32_t length = brake - pgm_read_dword(&ch.profile->brakeSteps[j - 1]);
+  uint32_t period = slicePeriod(ch, j);
+  ch.slice = j;
+  ch.sliceLeft = (length < ch.remaining) ? length : ch.remaining;
+  ch.periodUs = (period > ch.cruiseUs) ? period : ch.cruiseUs;
+}
+
+static inline bool channelHasMotion(EngineChannel& ch) {
+  return ch.remaining != 0;
+}
+
+#if STEP_ENGINE_FAST_PULSE
+#define STEP_ENGINE_PULSE_TICKS (STEP_ENGINE_PULSE_US * STEP_ENGINE_TICKS_PER_US)
+
+static inline void stepPinHigh(EngineChannel& ch) {
+#ifdef __AVR__
+  *ch.stepPort |= ch.stepBit;
+#else
+  digitalWrite(ch.stepPin, HIGH);
+#endif
+}
+
+// Спад STEP не раньше STEP_ENGINE_PULSE_US от фронта. Расчёт шага обычно длиннее импульса,
+// ожидание остаётся только на коротком пути; число проверок ограничено на случай стоящего таймера
+static inline void stepPinLow(EngineChannel& ch, uint16_t raisedAt) {
+  for (uint8_t i = 0; i < 4 * STEP_ENGINE_PULSE_TICKS && (uint16_t)(*ch.tcnt - raisedAt) < STEP_ENGINE_PULSE_TICKS; i++) {
+  }
+#ifdef __AVR__
+  *ch.stepPort &= ~ch.stepBit;
+#else
+  digitalWrite(ch.stepPin, LOW);
+#endif
+}
+#endif
+
+static inline void serviceChannel(EngineChannel& ch) {
+  if (ch.waitTicks) {
+    if (!scheduleNext(ch, ch.waitTicks)) ch.stats.lateSteps++;
+    return;
+  }
+
+  if (!ch.remaining) {
+    disarmChannel(ch);
+    return;
+  }
+
+#if STEP_ENGINE_FAST_PULSE
+  uint16_t raisedAt = *ch.tcnt;
+  bool fast = ch.dirSynced;
+  if (fast) {
+    stepPinHigh(ch);
+    ch.stepper->pos += ch.dir;
+  } else {
+    ch.stepper->step();
+    ch.dirSynced = true;
+  }
+#else
+  ch.stepper->step();
+#endif
+  fireEvents(ch);
+  if (--ch.remaining == 0) ch.slice = 0;
+  else if (--ch.sliceLeft == 0) selectSlice(ch);
+  finishTick(ch, ch.remaining != 0, ch.periodUs);
+#if STEP_ENGINE_FAST_PULSE
+  if (fast) stepPinLow(ch, raisedAt);
+#endif
+}
+#else
+static inline bool channelHasMotion(EngineChannel& ch) {
+  return ch.stepper->getStatus() != 0;
+}
+
+static inline void serviceChannel(EngineChannel& ch) {
+  if (ch.waitTicks) {
+    if (!scheduleNext(ch, ch.waitTicks)) ch.stats.lateSteps++;
+    return;
+  }
+
+  if (!ch.stepper->getStatus()) {
+    disarmChannel(ch);
+    return;
+  }
+
+  bool moving = ch.stepper->tickManual();
+  fireEvents(ch);
+  finishTick(ch, moving, ch.stepper->getPeriod());
+}
+#endif
+
+// Сброс движения канала без снятия прерывания
+static inline void clearChannelMotion(EngineChannel& ch) {
+  ch.waitTicks = 0;
+  releaseEvents(ch);
+  ch.stepper->brake();
+#if STEP_ENGINE_TABLE_PROFILE
+  ch.remaining = 0;
+  ch.slice = 0;
+#endif
+}
+
+static inline void updateGroupSkew() {
+  if (!groupSkewTracked) return;
+  int32_t d0 = abs(channels[STEPPER_E0].stepper->pos - groupStart[0]);
+  int32_t d1 = abs(channels[STEPPER_E1].stepper->pos - groupStart[1]);
+  int32_t diff = d0 * groupDist[1] - d1 * groupDist[0];
+  uint32_t skew = (diff < 0) ? -diff : diff;
+  if (skew > groupSkewRaw) groupSkewRaw = skew;
+}
+
+static inline void serviceClampGroup() {
+  EngineChannel& ch = channels[STEPPER_E0];
+  if (ch.waitTicks) {
+    if (!scheduleNext(ch, ch.waitTicks)) ch.stats.lateSteps++;
+    return;
+  }
+
+  if (clampPlanner.getStatus() <= 1) {
+    disarmChannel(ch);
+    return;
+  }
+
+  bool moving = clampPlanner.tickManual();
+  updateGroupSkew();
+  // tickManual() шагает на каждом 2^shift-м вызове - вызовы идут с периодом сабшага,
+  // getPeriod() отдаёт период целого шага
+  finishTick(ch, moving, clampPlanner.getSubstepPeriod());
+}
+
+// Время обработчика по счётчику таймера канала (0.5 мкс), без вызова micros() в прерывании
+static inline void recordServiceTime(EngineChannel& ch, uint16_t start) {
+#if PERF_ENABLED
+  uint16_t ticks = *ch.tcnt - start;
+  ch.stats.isrCalls++;
+  ch.stats.isrTicks += ticks;
+  if (ticks > ch.stats.isrMaxTicks) ch.stats.isrMaxTicks = ticks;
+#endif
+}
+
+static inline void timedServiceChannel(EngineChannel& ch) {
+  uint16_t start = *ch.tcnt;
+  serviceChannel(ch);
+  recordServiceTime(ch, start);
+}
+
+ISR(TIMER1_COMPA_vect) { timedServiceChannel(channels[STEPPER_MULTI]); }
+ISR(TIMER3_COMPA_vect) { timedServiceChannel(channels[STEPPER_MULTIZONE]); }
+ISR(TIMER4_COMPA_vect) { timedServiceChannel(channels[STEPPER_RRIGHT]); }
+ISR(TIMER5_COMPA_vect) {
+  EngineChannel& ch = channels[STEPPER_E0];
+  uint16_t start = *ch.tcnt;
+  if (groupMode) serviceClampGroup();
+  else serviceChannel(ch);
+  recordServiceTime(ch, start);
+}
+ISR(TIMER5_COMPB_vect) { timedServiceChannel(channels[STEPPER_E1]); }
+
+// ============== ИНИЦИАЛИЗАЦИЯ ==============
+static void setupChannel(StepperType type, volatile uint16_t* ocr, volatile uint16_t* tcnt,
+                         volatile uint8_t* timsk, volatile uint8_t* tifr, uint8_t mask) {
+  EngineChannel& ch = channels[type];
+  ch.stepper = getStepperByType(type);
+  ch.ocr = ocr;
+  ch.tcnt = tcnt;
+  ch.timsk = timsk;
+  ch.tifr = tifr;
+  ch.mask = mask;
+  ch.running = false;
+  ch.waitTicks = 0;
+  ch.eventCount = 0;
+  ch.nextEvent = 0;
+#if STEP_ENGINE_TABLE_PROFILE
+  ch.profile = &axisProfiles[type];
+  ch.periodScale = STEP_ENGINE_SCALE_ONE;
+  ch.remaining = 0;
+  ch.slice = 0;
+#if STEP_ENGINE_FAST_PULSE
+  StepperConfig config;
+  readStepperConfig(type, config);
+  ch.stepPin = config.stepPin;
+  ch.stepPort = portOutputRegister(digitalPinToPort(config.stepPin));
+  ch.stepBit = digitalPinToBitMask(config.stepPin);
+  ch.dirSynced = false;
+#endif
+#endif
+}
+
+void initializeStepEngine() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    // Нормальный режим, предделитель 8. ШИМ на пинах этих таймеров в проекте не используется
+    TCCR1A = 0; TCCR1B = (1 << CS11);
+    TCCR3A = 0; TCCR3B = (1 << CS31);
+    TCCR4A = 0; TCCR4B = (1 << CS41);
+    TCCR5A = 0; TCCR5B = (1 << CS51);
+
+    setupChannel(STEPPER_MULTI, &OCR1A, &TCNT1, &TIMSK1, &TIFR1, (1 << OCIE1A));
+    setupChannel(STEPPER_MULTIZONE, &OCR3A, &TCNT3, &TIMSK3, &TIFR3, (1 << OCIE3A));
+    setupChannel(STEPPER_RRIGHT, &OCR4A, &TCNT4, &TIMSK4, &TIFR4, (1 << OCIE4A));
+    setupChannel(STEPPER_E0, &OCR5A, &TCNT5, &TIMSK5, &TIFR5, (1 << OCIE5A));
+    setupChannel(STEPPER_E1, &OCR5B, &TCNT5, &TIMSK5, &TIFR5, (1 << OCIE5B));
+
+    for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) *channels[i].timsk &= ~channels[i].mask;
+  }
+  clampPlanner.addStepper(0, e0Stepper);
+  clampPlanner.addStepper(1, e1Stepper);
+  StepperConfig config;
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    readStepperConfig((StepperType)i, config);
+    stepEngineSetAcceleration((StepperType)i, config.acceleration);
+    stepEngineSetMaxSpeed((StepperType)i, config.maxSpeed);
+  }
+  stepEngineResetStats();
+}
+
+#if STEP_ENGINE_TABLE_PROFILE
+// Первый участок, период которого не длиннее заданного; выше таблицы скорость не растёт
+static void updateTopSlice(EngineChannel& ch, uint32_t cruiseUs) {
+  uint8_t top = 1;
+  while (top < ACCEL_PROFILE_SLICES && slicePeriod(ch, top) > cruiseUs) top++;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ch.cruiseUs = cruiseUs;
+    ch.topSlice = top;
+  }
+}
+#endif
+
+void stepEngineSetMaxSpeed(StepperType type, uint16_t speed) {
+#if STEP_ENGINE_TABLE_PROFILE
+  if (!speed) return;
+  updateTopSlice(channels[type], 1000000UL / speed);
+#else
+  getStepperByType(type)->setMaxSpeed(speed);
+#endif
+}
+
+void stepEngineSetAcceleration(StepperType type, uint16_t acceleration) {
+  if (!acceleration) return;
+#if STEP_ENGINE_TABLE_PROFILE
+  // Периоды в k раз длиннее - скорость в той же точке пути в k раз ниже, ускорение в k^2
+  EngineChannel& ch = channels[type];
+  float scale = sqrt((float)pgm_read_word(&profileAcceleration[type]) / acceleration) * STEP_ENGINE_SCALE_ONE + 0.5;
+  uint16_t periodScale = scale >= 0xFFFF ? 0xFFFF : (scale < 1 ? 1 : (uint16_t)scale);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ch.periodScale = periodScale;
+  }
+  updateTopSlice(ch, ch.cruiseUs);
+#else
+  getStepperByType(type)->setAcceleration(acceleration);
+#endif
+}
+
+uint16_t stepEngineGetSpeedCeiling(StepperType type) {
+#if STEP_ENGINE_TABLE_PROFILE
+  uint32_t period = slicePeriod(channels[type], ACCEL_PROFILE_SLICES);
+  if (period < 1000000UL / 0xFFFF + 1) return 0xFFFF;
+  return 1000000UL / period;
+#else
+  (void)type;
+  return 0xFFFF;
+#endif
+}
+
+// ============== УПРАВЛЕНИЕ ИЗ ФОНА ==============
+void stepEngineStartMask(uint8_t axisMask) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+      if (!(axisMask & STEP_ENGINE_AXIS_BIT(i))) continue;
+      EngineChannel& ch = channels[i];
+      if (!channelHasMotion(ch)) continue;
+      if (i == STEPPER_E0) groupMode = false;
+      ch.waitTicks = 0;
+      *ch.ocr = *ch.tcnt + STEP_ENGINE_MIN_LEAD_TICKS;
+      *ch.tifr = ch.mask;     // сброс ранее взведённого флага сравнения
+      *ch.timsk |= ch.mask;
+      ch.running = true;
+    }
+  }
+}
+
+void stepEngineStart(StepperType type) {
+  stepEngineStartMask(STEP_ENGINE_AXIS_BIT(type));
+}
+
+// Перевод шагов событий в позиции по ходу движения, по возрастанию шага.
+// Вызывается при снятом канале и запрещённых прерываниях
+static void armEvents(EngineChannel& ch, int32_t delta, const StepEngineEvent* events, uint8_t eventCount) {
+  uint32_t distance = (delta < 0) ? -delta : delta;
+  int32_t start = ch.stepper->pos;
+  uint8_t count = 0;
+
+  for (uint8_t i = 0; i < eventCount && count < STEP_ENGINE_MAX_EVENTS; i++) {
+    if (events[i].step == 0 || events[i].step > distance) continue;
+    int32_t position = (delta > 0) ? start + (int32_t)events[i].step : start - (int32_t)events[i].step;
+
+    // Вставка по порядку прохождения; события одного шага сохраняют исходный порядок
+    uint8_t j = count;
+    while (j > 0 && (delta > 0 ? ch.events[j - 1].position > position : ch.events[j - 1].position < position)) {
+      ch.events[j] = ch.events[j - 1];
+      j--;
+    }
+    ArmedEvent& armed = ch.events[j];
+    armed.position = position;
+#ifdef __AVR__
+    armed.port = portOutputRegister(digitalPinToPort(events[i].pin));
+    armed.bit = digitalPinToBitMask(events[i].pin);
+#else
+    armed.pin = events[i].pin;
+#endif
+    armed.state = events[i].state;
+    count++;
+  }
+  ch.eventCount = count;
+  ch.nextEvent = 0;
+}
+
+bool stepEngineMoveTo(StepperType type, long position, const StepEngineEvent* events, uint8_t eventCount) {
+  EngineChannel& ch = channels[type];
+#if STEP_ENGINE_TABLE_PROFILE
+  // Идущий канал в ту же сторону не снимается: взведённое сравнение остаётся, меняется только
+  // остаток пути - иначе перезапуск ставит шаг через STEP_ENGINE_MIN_LEAD_TICKS после предыдущего
+  bool extended = false;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    int32_t delta = (int32_t)position - ch.stepper->pos;
+    bool grouped = (type == STEPPER_E0 || type == STEPPER_E1) && groupMode;
+    if (ch.running && ch.remaining && !grouped && delta != 0 && (delta > 0 ? 1 : -1) == ch.dir) {
+      releaseEvents(ch);
+      armEvents(ch, delta, events, eventCount);
+      ch.remaining = (delta < 0) ? -delta : delta;
+      // Укороченный путь: граница участка не дальше цели, торможение выбирается на ней
+      if (ch.sliceLeft > ch.remaining) ch.sliceLeft = ch.remaining;
+      extended = true;
+    }
+  }
+  if (extended) return true;
+#endif
+  // setTarget() занимает сотни микросекунд - выполняем его при снятом канале,
+  // но с разрешёнными прерываниями, чтобы не сбивать остальные оси
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    disarmChannel(ch);
+    if ((type == STEPPER_E0 || type == STEPPER_E1) && groupMode) {
+      disarmChannel(channels[STEPPER_E0]);
+      clampPlanner.brake();
+      groupMode = false;
+    }
+    releaseEvents(ch);
+    armEvents(ch, (int32_t)position - ch.stepper->pos, events, eventCount);
+  }
+#if STEP_ENGINE_TABLE_PROFILE
+  // Канал снят - движение продолжается с текущего участка, если направление то же
+  int32_t delta = (int32_t)position - ch.stepper->pos;
+  int8_t dir = (delta > 0) ? 1 : -1;
+  if (ch.remaining == 0 || dir != ch.dir) {
+    ch.slice = 0;
+#if STEP_ENGINE_FAST_PULSE
+    // Между движениями DIR мог сменить планировщик clamp или сама библиотека
+    ch.dirSynced = false;
+#endif
+  }
+  ch.remaining = (delta < 0) ? -delta : delta;
+  if (!ch.remaining) {
+    ch.slice = 0;
+    return false;
+  }
+  ch.dir = dir;
+  ch.stepper->dir = dir;
+  selectSlice(ch);
+#else
+  ch.stepper->setTarget(position);
+  if (!ch.stepper->getStatus()) return false;
+#endif
+  stepEngineStart(type);
+  return true;
+}
+
+void stepEngineStop(StepperType type) {
+  EngineChannel& ch = channels[type];
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    disarmChannel(ch);
+    clearChannelMotion(ch);
+    // Остановка любой оси пары останавливает связанное движение целиком
+    if ((type == STEPPER_E0 || type == STEPPER_E1) && groupMode) {
+      disarmChannel(channels[STEPPER_E0]);
+      channels[STEPPER_E0].waitTicks = 0;
+      clampPlanner.brake();
+    }
+  }
+}
+
+// ============== СВЯЗАННАЯ ПАРА E0/E1 ==============
+void stepEngineConfigureClampGroup(double maxSpeed, uint16_t acceleration) {
+  // Параметры применяются только к остановленному планировщику
+  stepEngineStop(STEPPER_E0);
+  stepEngineStop(STEPPER_E1);
+  clampPlanner.setMaxSpeed(maxSpeed);
+  clampPlanner.setAcceleration(acceleration);
+}
+
+bool stepEngineMoveClampGroup(long e0Target, long e1Target) {
+  EngineChannel& ch = channels[STEPPER_E0];
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    disarmChannel(ch);
+    disarmChannel(channels[STEPPER_E1]);
+    clearChannelMotion(channels[STEPPER_E1]);
+    clearChannelMotion(ch);
+    clampPlanner.brake();
+    groupMode = false;
+  }
+
+  int32_t current[2] = {e0Stepper.getCurrent(), e1Stepper.getCurrent()};
+  int32_t target[2] = {(int32_t)e0Target, (int32_t)e1Target};
+
+  // Расчёт профиля (calculateBlock/setTarget) - в фоне, пока канал снят
+  clampPlanner.clearBuffer();
+  clampPlanner.addTarget(current, 0);
+  clampPlanner.addTarget(target, 1);
+  clampPlanner.start();
+  uint32_t calcStart = perfNow();
+  clampPlanner.checkBuffer();
+  perfRecord(PERF_PLANNER, perfNow() - calcStart);
+  if (clampPlanner.getStatus() <= 1) {
+    clampPlanner.brake();
+    return false;
+  }
+
+  groupStart[0] = current[0];
+  groupStart[1] = current[1];
+  groupDist[0] = abs(target[0] - current[0]);
+  groupDist[1] = abs(target[1] - current[1]);
+  groupSkewTracked = groupDist[0] <= GROUP_SKEW_MAX_DIST && groupDist[1] <= GROUP_SKEW_MAX_DIST;
+  groupSkewRaw = 0;
+
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    groupMode = true;
+    ch.waitTicks = 0;
+    *ch.ocr = *ch.tcnt + STEP_ENGINE_MIN_LEAD_TICKS;
+    *ch.tifr = ch.mask;
+    *ch.timsk |= ch.mask;
+    ch.running = true;
+  }
+  return true;
+}
+
+bool stepEngineClampGroupActive() {
+  return groupMode && channels[STEPPER_E0].running;
+}
+
+uint16_t stepEngineGetClampSkew() {
+  uint32_t raw;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    raw = groupSkewRaw;
+  }
+  int32_t scale = max(groupDist[0], groupDist[1]);
+  uint16_t skew = scale ? (uint16_t)((raw + scale - 1) / scale) : 0;
+  if (skew > groupSkewMax) groupSkewMax = skew;
+  return skew;
+}
+
+uint16_t stepEngineGetClampSkewMax() {
+  stepEngineGetClampSkew();
+  return groupSkewMax;
+}
+
+void stepEngineHaltFromISR(uint8_t axisMask) {
+  uint8_t clampAxes = STEP_ENGINE_AXIS_BIT(STEPPER_E0) | STEP_ENGINE_AXIS_BIT(STEPPER_E1);
+  if ((axisMask & clampAxes) && groupMode) {
+    axisMask |= STEP_ENGINE_AXIS_BIT(STEPPER_E0);
+    clampPlanner.brake();
+  }
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    if (!(axisMask & STEP_ENGINE_AXIS_BIT(i))) continue;
+    EngineChannel& ch = channels[i];
+    disarmChannel(ch);
+    clearChannelMotion(ch);
+  }
+}
+
+uint8_t stepEngineGetPendingEvents(StepperType type) {
+  EngineChannel& ch = channels[type];
+  uint8_t pending;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    pending = ch.eventCount - ch.nextEvent;
+  }
+  return pending;
+}
+
+bool stepEngineIsRunning(StepperType type) {
+  return channels[type].running;
+}
+
+long stepEngineGetPosition(StepperType type) {
+  long position;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    position = channels[type].stepper->pos;
+  }
+  return position;
+}
+
+// ============== СТАТИСТИКА ==============
+void stepEngineGetStats(StepperType type, StepEngineStats* stats) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    *stats = channels[type].stats;
+  }
+}
+
+void stepEngineResetStats() {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+      channels[i].stats.steps = 0;
+      channels[i].stats.minPeriodUs = 0xFFFFFFFFUL;
+      channels[i].stats.lateSteps = 0;
+      channels[i].stats.isrCalls = 0;
+      channels[i].stats.isrTicks = 0;
+      channels[i].stats.isrMaxTicks = 0;
+    }
+  }
+  groupSkewMax = 0;
+}
+
+uint16_t stepEngineGetMemory() {
+  return sizeof(channels) + sizeof(clampPlanner);
+}
@@ -1,19 +1,23 @@
 /**
  * @file: stepper_control.cpp
  * @description: Модуль управления шаговыми двигателями с индивидуальными настройками для каждого двигателя
- * @dependencies: GyverStepper2, config.h
+ * @dependencies: GyverStepper2, axis_model.h, motion_jobs
  * @created: 2024-12-19
  */
 
 #include "stepper_control.h"
+#include "motion_jobs.h"
+#include "log.h"
 #include <Arduino.h>
+#include <avr/pgmspace.h>
 
 // Создание экземпляров шаговых двигателей БЕЗ enable пинов как в примерах
-GStepper2<STEPPER2WIRE> multiStepper(MULTI_STEPS_PER_REVOLUTION, MULTI_STEP_PIN, MULTI_DIR_PIN);
-GStepper2<STEPPER2WIRE> multizoneSteper(MULTIZONE_STEPS_PER_REVOLUTION, MULTIZONE_STEP_PIN, MULTIZONE_DIR_PIN);
-GStepper2<STEPPER2WIRE> rRightStepper(RRIGHT_STEPS_PER_REVOLUTION, RRIGHT_STEP_PIN, RRIGHT_DIR_PIN);
-GStepper2<STEPPER2WIRE> e0Stepper(E0_STEPS_PER_REVOLUTION, E0_STEP_PIN, E0_DIR_PIN);
-GStepper2<STEPPER2WIRE> e1Stepper(E1_STEPS_PER_REVOLUTION, E1_STEP_PIN, E1_DIR_PIN);
+#define AXIS_STEPPER(id) Axis<id>::stepsPerRevolution(), Axis<id>::stepPin(), Axis<id>::dirPin()
+GStepper2<STEPPER2WIRE> multiStepper(AXIS_STEPPER(AXIS_MULTI));
+GStepper2<STEPPER2WIRE> multizoneSteper(AXIS_STEPPER(AXIS_MULTIZONE));
+GStepper2<STEPPER2WIRE> rRightStepper(AXIS_STEPPER(AXIS_RRIGHT));
+GStepper2<STEPPER2WIRE> e0Stepper(AXIS_STEPPER(AXIS_E0));
+GStepper2<STEPPER2WIRE> e1Stepper(AXIS_STEPPER(AXIS_E1));
 
 // Флаг для предотвращения одновременного запуска команд, влияющих на E0/E1
 static bool clampInProgress = false;
@@ -21,106 +25,131 @@ static bool clampInProgress = false;
 // ============== УПРАВЛЕНИЕ ФЛАГОМ ЗАНЯТОСТИ ==============
 void resetClampFlag() {
   clampInProgress = false;
-  Serial.println(F("Флаг занятости clamp сброшен"));
+  LOG_INFO(Log.println(F("Флаг занятости clamp сброшен")));
 }
 
 bool isClampInProgress() {
   return clampInProgress;
 }
 
-// ============== КОНФИГУРАЦИЯ ДВИГАТЕЛЕЙ ==============
-StepperConfig getStepperConfig(StepperType type) {
-  StepperConfig config;
-  
-  switch (type) {
-    case STEPPER_MULTI:
-      config.stepPin = MULTI_STEP_PIN;
-      config.dirPin = MULTI_DIR_PIN;
-      config.endstopPin = MULTI_ENDSTOP_PIN;
-      config.stepsPerRevolution = MULTI_STEPS_PER_REVOLUTION;
-      config.maxSpeed = MULTI_MAX_SPEED;
-      config.acceleration = MULTI_ACCELERATION;
-      config.homingSpeed = MULTI_HOMING_SPEED;
-      config.endstopTypeNPN = MULTI_ENDSTOP_TYPE_NPN;
-      config.powerAlwaysOn = MULTI_POWER_ALWAYS_ON;
-      break;
-      
-    case STEPPER_MULTIZONE:
-      config.stepPin = MULTIZONE_STEP_PIN;
-      config.dirPin = MULTIZONE_DIR_PIN;
-      config.endstopPin = MULTIZONE_ENDSTOP_PIN;
-      config.stepsPerRevolution = MULTIZONE_STEPS_PER_REVOLUTION;
-      config.maxSpeed = MULTIZONE_MAX_SPEED;
-      config.acceleration = MULTIZONE_ACCELERATION;
-      config.homingSpeed = MULTIZONE_HOMING_SPEED;
-      config.endstopTypeNPN = MULTIZONE_ENDSTOP_TYPE_NPN;
-      config.powerAlwaysOn = MULTIZONE_POWER_ALWAYS_ON;
-      break;
-      
-    case STEPPER_RRIGHT:
-      config.stepPin = RRIGHT_STEP_PIN;
-      config.dirPin = RRIGHT_DIR_PIN;
-      config.endstopPin = RRIGHT_ENDSTOP_PIN;
-      config.stepsPerRevolution = RRIGHT_STEPS_PER_REVOLUTION;
-      config.maxSpeed = RRIGHT_MAX_SPEED;
-      config.acceleration = RRIGHT_ACCELERATION;
-      config.homingSpeed = RRIGHT_HOMING_SPEED;
-      config.endstopTypeNPN = RRIGHT_ENDSTOP_TYPE_NPN;
-      config.powerAlwaysOn = RRIGHT_POWER_ALWAYS_ON;
-      break;
-      
-    case STEPPER_E0:
-      config.stepPin = E0_STEP_PIN;
-      config.dirPin = E0_DIR_PIN;
-      config.endstopPin = CLAMP_SENSOR_PIN; // Используется для clamp_zero
-      config.stepsPerRevolution = E0_STEPS_PER_REVOLUTION;
-      config.maxSpeed = E0_MAX_SPEED;
-      config.acceleration = E0_ACCELERATION;
-      config.homingSpeed = E0_HOMING_SPEED;
-      config.endstopTypeNPN = E0_ENDSTOP_TYPE_NPN;
-      config.powerAlwaysOn = E0_POWER_ALWAYS_ON;
-      break;
-      
-    case STEPPER_E1:
-      config.stepPin = E1_STEP_PIN;
-      config.dirPin = E1_DIR_PIN;
-      config.endstopPin = CLAMP_SENSOR_PIN; // Используется для clamp_zero
-      config.stepsPerRevolution = E1_STEPS_PER_REVOLUTION;
-      config.maxSpeed = E1_MAX_SPEED;
-      config.acceleration = E1_ACCELERATION;
-      config.homingSpeed = E1_HOMING_SPEED;
-      config.endstopTypeNPN = E1_ENDSTOP_TYPE_NPN;
-      config.powerAlwaysOn = E1_POWER_ALWAYS_ON;
-      break;
-  }
-  
-  return config;
+bool acquireClampFlag() {
+  if (clampInProgress) return false;
+  clampInProgress = true;
+  return true;
+}
+
+void releaseClampFlag() {
+  clampInProgress = false;
 }
 
+// ============== ТАБЛИЦА ОПИСАНИЙ ОСЕЙ ==============
+static const char multiName[] PROGMEM = "Multi";
+static const char multizoneName[] PROGMEM = "Multizone";
+static const char rRightName[] PROGMEM = "RRight";
+static const char e0Name[] PROGMEM = "E0";
+static const char e1Name[] PROGMEM = "E1";
+
+static const char multiEvent[] PROGMEM = "multi";
+static const char multizoneEvent[] PROGMEM = "multizone";
+static const char rRightEvent[] PROGMEM = "rright";
+static const char e0Event[] PROGMEM = "e0";
+static const char e1Event[] PROGMEM = "e1";
+
+// Конфигурация оси из модели axis_model.h (датчик E0/E1 - общий датчик clamp_zero)
+#define AXIS_CONFIG(id)                                                                              \
+  {                                                                                                  \
+    Axis<id>::stepPin(), Axis<id>::dirPin(), Axis<id>::endstopPin(), Axis<id>::stepsPerRevolution(),  \
+        Axis<id>::maxSpeed(), Axis<id>::acceleration(), axisModel[id].homingSpeed,                   \
+        axisModel[id].homingFastSpeed, axisModel[id].homingLatchSpeed,                               \
+        axisModel[id].homingLatchDistance, Axis<id>::endstopNPN(), axisModel[id].powerAlwaysOn       \
+  }
+
+// Индекс - StepperType
+static const AxisDescriptor axisDescriptors[STEPPER_AXIS_COUNT] PROGMEM = {
+  {&multiStepper, multiName, multiEvent, AXIS_CONFIG(AXIS_MULTI)},
+  {&multizoneSteper, multizoneName, multizoneEvent, AXIS_CONFIG(AXIS_MULTIZONE)},
+  {&rRightStepper, rRightName, rRightEvent, AXIS_CONFIG(AXIS_RRIGHT)},
+  {&e0Stepper, e0Name, e0Event, AXIS_CONFIG(AXIS_E0)},
+  {&e1Stepper, e1Name, e1Event, AXIS_CONFIG(AXIS_E1)},
+};
+
 GStepper2<STEPPER2WIRE>* getStepperByType(StepperType type) {
-  switch (type) {
-    case STEPPER_MULTI: return &multiStepper;
-    case STEPPER_MULTIZONE: return &multizoneSteper;
-    case STEPPER_RRIGHT: return &rRightStepper;
-    case STEPPER_E0: return &e0Stepper;
-    case STEPPER_E1: return &e1Stepper;
-    default: return nullptr;
+  if (type >= STEPPER_AXIS_COUNT) return nullptr;
+  return (GStepper2<STEPPER2WIRE>*)pgm_read_ptr(&axisDescriptors[type].stepper);
+}
+
+// Пределы осей, найденные tune (0 - значение config.h)
+static uint16_t speedLimits[STEPPER_AXIS_COUNT];
+static uint16_t accelerationLimits[STEPPER_AXIS_COUNT];
+
+void readStepperConfig(StepperType type, StepperConfig& config) {
+  memcpy_P(&config, &axisDescriptors[type].config, sizeof(StepperConfig));
+  if (speedLimits[type]) {
+    // Скорости хоминга не выше найденного предела
+    config.maxSpeed = speedLimits[type];
+    config.homingSpeed = min(config.homingSpeed, config.maxSpeed);
+    config.homingFastSpeed = min(config.homingFastSpeed, config.maxSpeed);
+    config.homingLatchSpeed = min(config.homingLatchSpeed, config.maxSpeed);
+  }
+  if (accelerationLimits[type]) config.acceleration = accelerationLimits[type];
+}
+
+void setAxisLimits(StepperType type, uint16_t maxSpeed, uint16_t acceleration) {
+  if (type >= STEPPER_AXIS_COUNT) return;
+  speedLimits[type] = min(maxSpeed, (uint16_t)AXIS_LIMIT_MAX);
+  accelerationLimits[type] = min(acceleration, (uint16_t)AXIS_LIMIT_MAX);
+}
+
+void getAxisLimits(StepperType type, uint16_t& maxSpeed, uint16_t& acceleration) {
+  maxSpeed = speedLimits[type];
+  acceleration = accelerationLimits[type];
+}
+
+const __FlashStringHelper* getAxisName(StepperType type) {
+  if (type >= STEPPER_AXIS_COUNT) return F("UNKNOWN");
+  return (const __FlashStringHelper*)pgm_read_ptr(&axisDescriptors[type].name);
+}
+
+const __FlashStringHelper* getAxisEventName(StepperType type) {
+  if (type >= STEPPER_AXIS_COUNT) return F("unknown");
+  return (const __FlashStringHelper*)pgm_read_ptr(&axisDescriptors[type].eventName);
+}
+
+int getAxisEndstopPin(StepperType type) {
+  return (int)pgm_read_word(&axisDescriptors[type].config.endstopPin);
+}
+
+bool getAxisEndstopNPN(StepperType type) {
+  return pgm_read_byte(&axisDescriptors[type].config.endstopTypeNPN);
+}
+
+bool readAxisEndstop(StepperType type) {
+  return readEndstopWithType(getAxisEndstopPin(type), getAxisEndstopNPN(type));
+}
+
+// Определение типа двигателя по ссылке на объект
+static bool findStepperType(GStepper2<STEPPER2WIRE>& stepper, StepperType& type) {
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    if (getStepperByType((StepperType)i) == &stepper) {
+      type = (StepperType)i;
+      return true;
+    }
   }
+  return false;
 }
 
 void applyStepperConfig(GStepper2<STEPPER2WIRE>& stepper, const StepperConfig& config) {
-  Serial.print(F("Настройка двигателя... "));
-  
   stepper.setMaxSpeed(config.maxSpeed);
   stepper.setAcceleration(config.acceleration);
   
-  Serial.print(F("Конфигурация: скорость="));
-  Serial.print(config.maxSpeed);
-  Serial.print(F(", ускорение="));
-  Serial.print(config.acceleration);
-  Serial.print(F(", шагов/оборот="));
-  Serial.print(config.stepsPerRevolution);
-  Serial.println(F(" [НАСТРОЕН]"));
+  LOG_DEBUG({
+    Log.print(F("Конфигурация: скорость="));
+    Log.print(config.maxSpeed);
+    Log.print(F(", ускорение="));
+    Log.print(config.acceleration);
+    Log.print(F(", шагов/оборот="));
+    Log.println(config.stepsPerRevolution);
+  });
 }
 
 bool readEndstopWithType(int endstopPin, bool isNPN) {
@@ -137,7 +166,7 @@ bool readEndstopWithType(int endstopPin, bool isNPN) {
 
 // ============== ИНИЦИАЛИЗАЦИЯ СИСТЕМЫ ==============
 void initializeSteppers() {
-  Serial.println(F("Инициализация шаговых двигателей БЕЗ управления enable через GyverStepper2..."));
+  LOG_DEBUG(Log.println(F("Инициализация шаговых двигателей БЕЗ управления enable через GyverStepper2...")));
   
   // Настройка пинов для всех двигателей
   pinMode(MULTI_STEP_PIN, OUTPUT);
@@ -158,23 +187,18 @@ void initializeSteppers() {
   // РУЧНАЯ активация enable пинов (драйверы активны на LOW)
   pinMode(MULTI_ENABLE_PIN, OUTPUT);
   digitalWrite(MULTI_ENABLE_PIN, LOW);
-  Serial.println(F("Multi enable pin АКТИВИРОВАН вручную"));
   
   pinMode(MULTIZONE_ENABLE_PIN, OUTPUT);
   digitalWrite(MULTIZONE_ENABLE_PIN, LOW);
-  Serial.println(F("Multizone enable pin АКТИВИРОВАН вручную"));
   
   pinMode(RRIGHT_ENABLE_PIN, OUTPUT);
   digitalWrite(RRIGHT_ENABLE_PIN, LOW);
-  Serial.println(F("RRight enable pin АКТИВИРОВАН вручную"));
   
   pinMode(E0_ENABLE_PIN, OUTPUT);
   digitalWrite(E0_ENABLE_PIN, LOW);
-  Serial.println(F("E0 enable pin АКТИВИРОВАН вручную"));
   
   pinMode(E1_ENABLE_PIN, OUTPUT);
   digitalWrite(E1_ENABLE_PIN, LOW);
-  Serial.println(F("E1 enable pin АКТИВИРОВАН вручную"));
   
   // Настройка датчиков
   pinMode(MULTI_ENDSTOP_PIN, INPUT_PULLUP);
@@ -183,482 +207,91 @@ void initializeSteppers() {
   pinMode(CLAMP_SENSOR_PIN, INPUT_PULLUP);
   
   // Применение индивидуальных конфигураций
-  Serial.println(F("Применение конфигураций двигателей:"));
-  
-  Serial.print(F("Multi: "));
-  applyStepperConfig(multiStepper, getStepperConfig(STEPPER_MULTI));
-  
-  Serial.print(F("Multizone: "));
-  applyStepperConfig(multizoneSteper, getStepperConfig(STEPPER_MULTIZONE));
-  
-  Serial.print(F("RRight: "));
-  applyStepperConfig(rRightStepper, getStepperConfig(STEPPER_RRIGHT));
-  
-  Serial.print(F("E0: "));
-  applyStepperConfig(e0Stepper, getStepperConfig(STEPPER_E0));
-  
-  Serial.print(F("E1: "));
-  applyStepperConfig(e1Stepper, getStepperConfig(STEPPER_E1));
+  StepperConfig config;
+  for (uint8_t i = 0; i < STEPPER_AXIS_COUNT; i++) {
+    StepperType type = (StepperType)i;
+    readStepperConfig(type, config);
+    LOG_DEBUG({
+      Log.print(getAxisName(type));
+      Log.print(F(": "));
+    });
+    applyStepperConfig(*getStepperByType(type), config);
+  }
   
-  Serial.println(F("Инициализация завершена - ВСЕ ENABLE ПИНЫ АКТИВИРОВАНЫ ВРУЧНУЮ"));
+  LOG_INFO(Log.println(F("Двигатели настроены, enable пины активированы вручную")));
 }
 
 // ============== БАЗОВЫЕ ФУНКЦИИ УПРАВЛЕНИЯ ==============
+// Блокирующие обёртки над заданиями motion_jobs: пока функция ждёт,
+// serviceMotionJobs() продолжает вести задания остальных осей
 bool setStepperPosition(GStepper2<STEPPER2WIRE>& stepper, long position) {
-  if (position == 0) {
-    Serial.println(F("Ошибка: Нулевая позиция не допускается"));
-    return false;
-  }
-  
-  // Проверка занятости двигателей E0 и E1
-  if ((&stepper == &e0Stepper || &stepper == &e1Stepper) && clampInProgress) {
-    Serial.println(F("Ошибка: Двигатели E0/E1 заняты командой clamp"));
-    return false;
-  }
-  
-  // Определяем какой это двигатель для диагностики
-  String motorName = "UNKNOWN";
-  if (&stepper == &multiStepper) motorName = "Multi";
-  else if (&stepper == &multizoneSteper) motorName = "Multizone";
-  else if (&stepper == &rRightStepper) motorName = "RRight";
-  else if (&stepper == &e0Stepper) motorName = "E0";
-  else if (&stepper == &e1Stepper) motorName = "E1";
-  else {
-    Serial.println(F("Ошибка: Неизвестный двигатель"));
+  StepperType type;
+  if (!findStepperType(stepper, type)) {
+    LOG_ERROR(Log.println(F("Ошибка: Неизвестный двигатель")));
     return false;
   }
   
-  long currentPos = stepper.getCurrent();
-  Serial.print(F("ДВИЖЕНИЕ "));
-  Serial.print(motorName);
-  Serial.print(F(": "));
-  Serial.print(currentPos);
-  Serial.print(F(" -> "));
-  Serial.println(position);
-  
-  // Простая настройка как в примерах GyverStepper2
-  stepper.setTarget(position);
-  
-  // Простое блокирующее ожидание как в примерах
-  unsigned long startTime = millis();
-  unsigned long lastProgressTime = 0;
-  
-  while (!stepper.ready()) {
-    unsigned long currentTime = millis();
-    
-    // Проверка таймаута
-    if (currentTime - startTime > HOMING_TIMEOUT) {
-      Serial.print(F("ТАЙМАУТ "));
-      Serial.print(motorName);
-      Serial.print(F(" на позиции "));
-      Serial.println(stepper.getCurrent());
-      stepper.brake();
-      return false;
-    }
-    
-    // Главное - вызов tick()!
-    stepper.tick();
-    
-    // Периодический прогресс
-    if (currentTime - lastProgressTime >= 2000) {
-      lastProgressTime = currentTime;
-      Serial.print(F("ПРОГРЕСС "));
-      Serial.print(motorName);
-      Serial.print(F(": "));
-      Serial.print(stepper.getCurrent());
-      Serial.print(F("/"));
-      Serial.println(stepper.getTarget());
-    }
-    
-    yield();
-  }
-  
-  Serial.print(F("ЗАВЕРШЕНО "));
-  Serial.print(motorName);
-  Serial.print(F(": "));
-  Serial.println(stepper.getCurrent());
-  
-  return true;
+  if (!startMoveJob(type, position, false)) return false;
+  return waitMotionJob(type);
 }
 
 bool homeStepperMotor(GStepper2<STEPPER2WIRE>& stepper, int endstopPin) {
-  // Проверка занятости двигателей E0 и E1
-  if ((&stepper == &e0Stepper || &stepper == &e1Stepper) && clampInProgress) {
-    Serial.println(F("Ошибка: Двигатели E0/E1 заняты командой clamp"));
-    return false;
-  }
-  
+  // Датчик оси берётся из её конфигурации (защёлка endstop_latch), пин остался в интерфейсе
+  (void)endstopPin;
   // Определяем тип двигателя для получения правильной конфигурации
   StepperType stepperType;
-  if (&stepper == &multiStepper) stepperType = STEPPER_MULTI;
-  else if (&stepper == &multizoneSteper) stepperType = STEPPER_MULTIZONE;
-  else if (&stepper == &rRightStepper) stepperType = STEPPER_RRIGHT;
-  else if (&stepper == &e0Stepper) stepperType = STEPPER_E0;
-  else if (&stepper == &e1Stepper) stepperType = STEPPER_E1;
-  else return false;
+  if (!findStepperType(stepper, stepperType)) return false;
   
-  StepperConfig config = getStepperConfig(stepperType);
-  return homeStepperMotorWithConfig(stepper, config);
+  LOG_INFO(Log.println(F("Начало процедуры хоминга с индивидуальными настройками...")));
+  if (!startHomeJob(stepperType, false)) return false;
+  return waitMotionJob(stepperType);
 }
 
 bool homeStepperMotorWithConfig(GStepper2<STEPPER2WIRE>& stepper, const StepperConfig& config) {
-  Serial.println(F("Начало процедуры хоминга с индивидуальными настройками..."));
-  
-  // Определяем название двигателя для диагностики
-  String motorName = "UNKNOWN";
-  if (&stepper == &multiStepper) motorName = "Multi";
-  else if (&stepper == &multizoneSteper) motorName = "Multizone";
-  else if (&stepper == &rRightStepper) motorName = "RRight";
-  else if (&stepper == &e0Stepper) motorName = "E0";
-  else if (&stepper == &e1Stepper) motorName = "E1";
+  LOG_INFO(Log.println(F("Начало процедуры хоминга с индивидуальными настройками...")));
   
-  Serial.print(F("Хоминг "));
-  Serial.print(motorName);
-  Serial.print(F(" со скоростью "));
-  Serial.print(config.homingSpeed);
-  Serial.print(F(" steps/sec, датчик тип: "));
-  Serial.println(config.endstopTypeNPN ? "NPN" : "PNP");
-  
-  // Остановка двигателя
-  stepper.brake();
-  delay(100);
-  
-  // Настройка параметров для хоминга
-  stepper.setMaxSpeed(config.homingSpeed);
-  stepper.setAcceleration(config.acceleration);
-  
-  // Проверка начального состояния датчика
-  bool initialEndstopState = readEndstopWithType(config.endstopPin, config.endstopTypeNPN);
-  Serial.print(F("Начальное состояние датчика: "));
-  Serial.println(initialEndstopState ? "СРАБОТАЛ" : "НЕ СРАБОТАЛ");
-  
-  // Если датчик уже сработал, сначала отъезжаем
-  if (initialEndstopState) {
-    Serial.println(F("Датчик уже сработал, отъезжаем..."));
-    stepper.setTarget(stepper.getCurrent() + 200); // Отъезжаем на 200 шагов
-    
-    unsigned long escapeStart = millis();
-    while (!stepper.ready() && (millis() - escapeStart < 10000)) {
-      stepper.tick();
-      yield();
-    }
-    
-    stepper.brake();
-    delay(100);
-    
-    // Проверяем, что датчик отпустился
-    if (readEndstopWithType(config.endstopPin, config.endstopTypeNPN)) {
-      Serial.println(F("Ошибка: не удалось отъехать от датчика"));
-      return false;
-    }
-    Serial.println(F("Успешно отъехали от датчика"));
-  }
+  StepperType type;
+  if (!findStepperType(stepper, type)) return false;
   
-  // Движение к концевику
-  Serial.println(F("Движемся к концевику..."));
-  long startPosition = stepper.getCurrent();
-  stepper.setTarget(startPosition - 50000); // Движемся на много шагов назад
-  
-  unsigned long startTime = millis();
-  unsigned long lastProgressTime = 0;
-  
-  while (!stepper.ready()) {
-    unsigned long currentTime = millis();
-    
-    // Проверка таймаута
-    if (currentTime - startTime >= HOMING_TIMEOUT) {
-      stepper.brake();
-      Serial.println(F("Ошибка: Таймаут хоминга"));
-      return false;
-    }
-    
-    // Проверка датчика
-    if (readEndstopWithType(config.endstopPin, config.endstopTypeNPN)) {
-      Serial.println(F("Концевик сработал!"));
-      stepper.brake();
-      break;
-    }
-    
-    // Периодический прогресс
-    if (currentTime - lastProgressTime >= 3000) {
-      lastProgressTime = currentTime;
-      Serial.print(F("ХОМИНГ "));
-      Serial.print(motorName);
-      Serial.print(F(": позиция="));
-      Serial.print(stepper.getCurrent());
-      Serial.print(F(", время="));
-      Serial.print((currentTime - startTime) / 1000);
-      Serial.println(F("с"));
-    }
-    
-    stepper.tick();
-    yield();
-  }
-  
-  // Проверяем, что концевик действительно сработал
-  if (!readEndstopWithType(config.endstopPin, config.endstopTypeNPN)) {
-    Serial.println(F("Ошибка: концевик не сработал за отведенное время"));
-    return false;
-  }
-  
-  // Сброс позиции в 0
-  stepper.reset();
-  Serial.print(F("Концевик сработал (тип: "));
-  Serial.print(config.endstopTypeNPN ? "NPN" : "PNP");
-  Serial.println(F("), позиция сброшена в 0"));
-  
-  delay(200); // Стабилизация
-  
-  // Отъезд от концевика
-  Serial.println(F("Отъезжаем от концевика..."));
-  stepper.setTarget(100);
-  startTime = millis();
-  
-  while (!stepper.ready()) {
-    if (millis() - startTime > 10000) { // 10 секунд на отъезд
-      stepper.brake();
-      Serial.println(F("Ошибка: Таймаут отъезда от концевика"));
-      return false;
-    }
-    stepper.tick();
-    yield();
-  }
-  
-  // Финальная проверка
-  if (readEndstopWithType(config.endstopPin, config.endstopTypeNPN)) {
-    Serial.println(F("Предупреждение: датчик все еще активен после отъезда"));
-  }
-  
-  stepper.reset(); // Устанавливаем новую нулевую точку
-  Serial.print(F("Хоминг "));
-  Serial.print(motorName);
-  Serial.println(F(" завершен успешно"));
-  return true;
+  if (!startHomeJob(type, config, false)) return false;
+  return waitMotionJob(type);
 }
 
 // ============== ФУНКЦИИ ДЛЯ ДВИГАТЕЛЕЙ E0/E1 ==============
 bool clampMotors(long targetPosition) {
-  if (clampInProgress) {
-    Serial.println(F("Ошибка: Команда clamp уже выполняется"));
-    return false;
-  }
-  
-  clampInProgress = true;
-  Serial.println(F("Начало выполнения команды clamp"));
-  
-  // Получение конфигураций для E0 и E1
-  StepperConfig e0Config = getStepperConfig(STEPPER_E0);
-  StepperConfig e1Config = getStepperConfig(STEPPER_E1);
-  
-  // Получение текущих позиций
-  long currentE0 = e0Stepper.getCurrent();
-  long currentE1 = e1Stepper.getCurrent();
-  
-  Serial.print(F("Текущие позиции - E0: "));
-  Serial.print(currentE0);
-  Serial.print(F(", E1: "));
-  Serial.println(currentE1);
-  
-  // Остановка двигателей перед движением
-  e0Stepper.brake();
-  e1Stepper.brake();
-  delay(50);
-  
-  // Настройка параметров движения ПРОСТЫМИ командами как в примерах
-  e0Stepper.setMaxSpeed(e0Config.maxSpeed);
-  e1Stepper.setMaxSpeed(e1Config.maxSpeed);
-  e0Stepper.setAcceleration(e0Config.acceleration);
-  e1Stepper.setAcceleration(e1Config.acceleration);
-  
-  // Установка целевых позиций
-  e0Stepper.setTarget(targetPosition);
-  e1Stepper.setTarget(targetPosition);
-  
-  Serial.print(F("Движение E0 и E1 к позиции: "));
-  Serial.println(targetPosition);
-  
-  // Простое движение как в примерах GyverStepper2
-  unsigned long startTime = millis();
-  unsigned long lastProgressTime = 0;
-  
-  while (!e0Stepper.ready() || !e1Stepper.ready()) {
-    unsigned long currentTime = millis();
-    
-    // Проверка таймаута
-    if (currentTime - startTime >= HOMING_TIMEOUT) {
-      Serial.println(F("Ошибка: Таймаут выполнения команды clamp"));
-      e0Stepper.brake();
-      e1Stepper.brake();
-      clampInProgress = false;
-      return false;
-    }
-    
-    // Обновление двигателей - ГЛАВНОЕ В GYVERSTEPPER2!
-    e0Stepper.tick();
-    e1Stepper.tick();
-    
-    // Периодический вывод прогресса
-    if (currentTime - lastProgressTime >= 2000) {
-      lastProgressTime = currentTime;
-      Serial.print(F("Прогресс - E0: "));
-      Serial.print(e0Stepper.getCurrent());
-      Serial.print(F("/"));
-      Serial.print(e0Stepper.getTarget());
-      Serial.print(F(", E1: "));
-      Serial.print(e1Stepper.getCurrent());
-      Serial.print(F("/"));
-      Serial.println(e1Stepper.getTarget());
-    }
-    
-    yield();
-  }
-  
-  Serial.print(F("Движение завершено - E0: "));
-  Serial.print(e0Stepper.getCurrent());
-  Serial.print(F(", E1: "));
-  Serial.println(e1Stepper.getCurrent());
-  
-  clampInProgress = false;
-  return true;
+  if (!startClampJob(targetPosition, false)) return false;
+  return waitMotionJob(STEPPER_E0);
 }
 
 bool clampZeroMotors() {
-  if (clampInProgress) {
-    Serial.println(F("Ошибка: Команда clamp уже выполняется"));
-    return false;
-  }
-  
-  clampInProgress = true;
-  Serial.println(F("Начало процедуры clamp_zero"));
-  
-  // Получение конфигураций для E0 и E1
-  StepperConfig e0Config = getStepperConfig(STEPPER_E0);
-  StepperConfig e1Config = getStepperConfig(STEPPER_E1);
-  
-  // Остановка двигателей
-  e0Stepper.brake();
-  e1Stepper.brake();
-  delay(100);
-  
-  // Настройка параметров из конфигурации
-  e0Stepper.setMaxSpeed(e0Config.homingSpeed);
-  e1Stepper.setMaxSpeed(e1Config.homingSpeed);
-  e0Stepper.setAcceleration(e0Config.acceleration);
-  e1Stepper.setAcceleration(e1Config.acceleration);
-  
-  // Начальная проверка датчика с учетом типа
-  if (readEndstopWithType(CLAMP_SENSOR_PIN, e0Config.endstopTypeNPN)) {
-    Serial.println(F("Датчик уже активен, начинаю отъезд"));
-    // Если датчик уже нажат, сначала отъезжаем
-    e0Stepper.setTarget(e0Stepper.getCurrent() + 200);
-    e1Stepper.setTarget(e1Stepper.getCurrent() + 200);
-    
-    unsigned long escapeStart = millis();
-    while ((!e0Stepper.ready() || !e1Stepper.ready()) && (millis() - escapeStart < 5000)) {
-      e0Stepper.tick();
-      e1Stepper.tick();
-      yield();
-    }
-    
-    e0Stepper.brake();
-    e1Stepper.brake();
-    delay(100);
-  }
-  
-  // Движение к датчику
-  Serial.print(F("Движение к датчику (тип: "));
-  Serial.print(e0Config.endstopTypeNPN ? "NPN" : "PNP");
-  Serial.println(F(")..."));
-  
-  long startE0 = e0Stepper.getCurrent();
-  long startE1 = e1Stepper.getCurrent();
-  e0Stepper.setTarget(startE0 - 5000);
-  e1Stepper.setTarget(startE1 - 5000);
-  
-  unsigned long startTime = millis();
-  
-  while (!readEndstopWithType(CLAMP_SENSOR_PIN, e0Config.endstopTypeNPN)) {
-    if (millis() - startTime >= HOMING_TIMEOUT) {
-      Serial.println(F("Ошибка: Таймаут при движении к датчику"));
-      e0Stepper.brake();
-      e1Stepper.brake();
-      clampInProgress = false;
-      return false;
-    }
-    
-    e0Stepper.tick();
-    e1Stepper.tick();
-    yield();
-  }
-  
-  // Датчик сработал
-  Serial.println(F("Датчик сработал"));
-  e0Stepper.brake();
-  e1Stepper.brake();
-  
-  // Установка нулевой позиции
-  e0Stepper.setCurrent(0);
-  e1Stepper.setCurrent(0);
-  
-  delay(200); // Стабилизация
-  
-  // Отъезд от датчика на позицию 100
-  Serial.println(F("Отъезд от датчика..."));
-  e0Stepper.setTarget(100);
-  e1Stepper.setTarget(100);
-  
-  startTime = millis();
-  
-  while (!e0Stepper.ready() || !e1Stepper.ready()) {
-    if (millis() - startTime >= 10000) {
-      Serial.println(F("Ошибка: Таймаут отъезда от датчика"));
-      e0Stepper.brake();
-      e1Stepper.brake();
-      clampInProgress = false;
-      return false;
-    }
-    
-    e0Stepper.tick();
-    e1Stepper.tick();
-    yield();
-  }
-  
-  Serial.print(F("Обнуление завершено - E0: "));
-  Serial.print(e0Stepper.getCurrent());
-  Serial.print(F(", E1: "));
-  Serial.println(e1Stepper.getCurrent());
-  
-  // Проверка корректности позиций
-  if (e0Stepper.getCurrent() != 100 || e1Stepper.getCurrent() != 100) {
-    Serial.println(F("Коррекция позиций до 100"));
-    e0Stepper.setCurrent(100);
-    e1Stepper.setCurrent(100);
-  }
-  
-  clampInProgress = false;
-  return true;
+  if (!startClampZeroJob(false)) return false;
+  return waitMotionJob(STEPPER_E0);
 }
 
 // ============== ИНДИВИДУАЛЬНЫЕ ФУНКЦИИ ДЛЯ E0 И E1 ==============
 bool moveE0(long position) {
-  Serial.print(F("Индивидуальное движение E0 к позиции: "));
-  Serial.println(position);
+  LOG_INFO({
+    Log.print(F("Индивидуальное движение E0 к позиции: "));
+    Log.println(position);
+  });
   return setStepperPosition(e0Stepper, position);
 }
 
 bool moveE1(long position) {
-  Serial.print(F("Индивидуальное движение E1 к позиции: "));
-  Serial.println(position);
+  LOG_INFO({
+    Log.print(F("Индивидуальное движение E1 к позиции: "));
+    Log.println(position);
+  });
   return setStepperPosition(e1Stepper, position);
 }
 
 bool homeE0() {
-  Serial.println(F("Индивидуальный хоминг E0..."));
+  LOG_INFO(Log.println(F("Индивидуальный хоминг E0...")));
   return homeStepperMotor(e0Stepper, CLAMP_SENSOR_PIN);
 }
 
 bool homeE1() {
-  Serial.println(F("Индивидуальный хоминг E1..."));
+  LOG_INFO(Log.println(F("Индивидуальный хоминг E1...")));
   return homeStepperMotor(e1Stepper, CLAMP_SENSOR_PIN);
 }
 
@@ -673,22 +306,26 @@ bool moveRRightToPosition(long position) {
 
 bool zeroAndMoveMulti(long position) {
   if (!homeStepperMotor(multiStepper, MULTI_ENDSTOP_PIN)) {
-    Serial.println(F("Ошибка: не удалось выполнить обнуление Multi"));
+    LOG_ERROR(Log.println(F("Ошибка: не удалось выполнить обнуление Multi")));
     return false;
   }
   
-  Serial.print(F("Перемещение Multi в позицию "));
-  Serial.println(position);
+  LOG_INFO({
+    Log.print(F("Перемещение Multi в позицию "));
+    Log.println(position);
+  });
   return setStepperPosition(multiStepper, position);
 }
 
 bool zeroAndMoveRRight(long position) {
   if (!homeStepperMotor(rRightStepper, RRIGHT_ENDSTOP_PIN)) {
-    Serial.println(F("Ошибка: не удалось выполнить обнуление RRight"));
+    LOG_ERROR(Log.println(F("Ошибка: не удалось выполнить обнуление RRight")));
     return false;
   }
   
-  Serial.print(F("Перемещение RRight в позицию "));
-  Serial.println(position);
+  LOG_INFO({
+    Log.print(F("Перемещение RRight в позицию "));
+    Log.println(position);
+  });
   return setStepperPosition(rRightStepper, position);
 } 
\ No newline at end of file
@@ -0,0 +1,137 @@
+/**
+ * @file: telemetry.cpp
+ * @description: Поток телеметрии: позиции осей, вес, ротор, отходы и концевики одним кадром
+ * @dependencies: step_engine, stepper_control, sensors, binary_protocol, NBHX711, config.h
+ * @created: 2026-10-14
+ *
+ * Заменяет опрос weight / staterotor / waste / check_all_endstops отдельными командами.
+ * Кадры идут по сроку (next += период), без накопления ошибки; в двоичном режиме кадр,
+ * не помещающийся в буфер передачи, пропускается, чтобы не задерживать основной цикл.
+ */
+
+#include "telemetry.h"
+#include "step_engine.h"
+#include "stepper_control.h"
+#include "sensors.h"
+#include "binary_protocol.h"
+#include <Arduino.h>
+#include <NBHX711.h>
+
+extern NBHX711 scale;
+
+// Полный кадр binary_protocol: синхробайт, заголовок, данные, CRC
+#define TELEMETRY_FRAME_SIZE (1 + 4 + TELEMETRY_PAYLOAD_SIZE + 2)
+
+static uint8_t telemetryHz = 0;
+static unsigned long periodMs = 0;
+static unsigned long nextFrameTime = 0;
+static uint8_t frameSeq = 0;
+static uint32_t droppedFrames = 0;
+
+typedef struct {
+  unsigned long time;
+  long positions[STEP_ENGINE_AXES];
+  long weight;          // г * 100
+  uint8_t rotor;
+  uint8_t waste;
+  uint8_t endstops;
+} TelemetrySample;
+
+static void collectSample(TelemetrySample& sample) {
+  SensorSnapshot inputs = readSensorSnapshot();
+  sample.time = millis();
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    sample.positions[i] = stepEngineGetPosition((StepperType)i);
+  }
+  float units = scale.getUnits(5) * 100.0;
+  sample.weight = (long)(units < 0 ? units - 0.5 : units + 0.5);
+  sample.rotor = inputs.bits & SENSOR_ROTOR_MASK;
+  sample.waste = (inputs.bits & SENSOR_BIT_WASTE) ? 1 : 0;
+  sample.endstops = sensorEndstopMask(inputs);
+}
+
+static uint8_t* putInt32(uint8_t* p, uint32_t value) {
+  p[0] = value & 0xFF;
+  p[1] = (value >> 8) & 0xFF;
+  p[2] = (value >> 16) & 0xFF;
+  p[3] = value >> 24;
+  return p + 4;
+}
+
+static void sendBinarySample(const TelemetrySample& sample) {
+  uint8_t payload[TELEMETRY_PAYLOAD_SIZE];
+  uint8_t* p = putInt32(payload, sample.time);
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) p = putInt32(p, (uint32_t)sample.positions[i]);
+  p = putInt32(p, (uint32_t)sample.weight);
+  *p++ = sample.rotor;
+  *p++ = sample.waste;
+  *p++ = sample.endstops;
+  sendBinaryEvent(frameSeq, BIN_OP_TELEMETRY, payload, sizeof(payload));
+}
+
+static void printTextSample(const TelemetrySample& sample) {
+  Serial.print(F("TLM,"));
+  Serial.print(sample.time);
+  for (uint8_t i = 0; i < STEP_ENGINE_AXES; i++) {
+    Serial.print(',');
+    Serial.print(sample.positions[i]);
+  }
+  Serial.print(',');
+  Serial.print(sample.weight / 100.0, 2);
+  Serial.print(',');
+  Serial.print(sample.rotor);
+  Serial.print(',');
+  Serial.print(sample.waste);
+  Serial.print(',');
+  Serial.println(sample.endstops);
+}
+
+// ============== ИНТЕРФЕЙС ==============
+bool setTelemetryRate(uint8_t hz) {
+  if (hz > TELEMETRY_MAX_HZ) return false;
+  telemetryHz = hz;
+  periodMs = hz ? 1000 / hz : 0;
+  nextFrameTime = millis();
+  return true;
+}
+
+uint8_t getTelemetryRate() {
+  return telemetryHz;
+}
+
+uint32_t getTelemetryDropped() {
+  return droppedFrames;
+}
+
+void serviceTelemetry() {
+  if (!telemetryHz) return;
+
+  unsigned long now = millis();
+  if ((long)(now - nextFrameTime) < 0) return;
+  nextFrameTime += periodMs;
+  // Пропущено больше периода (блокирующая команда) - не выдаём пачку кадров подряд
+  if ((long)(now - nextFrameTime) >= 0) nextFrameTime = now + periodMs;
+
+  if (isBinaryMode() && Serial.availableForWrite() < TELEMETRY_FRAME_SIZE) {
+    droppedFrames++;
+    frameSeq++;
+    return;
+  }
+
+  TelemetrySample sample;
+  collectSample(sample);
+  if (isBinaryMode()) {
+    sendBinarySample(sample);
+  } else {
+    printTextSample(sample);
+  }
+  frameSeq++;
+}
+
+void enableWeightReport() {
+  setTelemetryRate(1);
+}
+
+void disableWeightReport() {
+  setTelemetryRate(0);
+}
@@ -1,12 +1,107 @@
 /**
  * @file: valves.cpp
  * @description: Модуль управления клапанами и насосом
- * @dependencies: Arduino.h, config.h
+ * @dependencies: Arduino.h, config.h, motion_jobs
  * @created: 2024-12-19
+ *
+ * Импульсы клапанов и насоса выполняются по таблице расписания: прерывание сравнения Timer0
+ * (канал A, раз в ~1 мс, millis() его не использует) переключает выходы по сроку millis().
+ * Основной цикл не блокируется, импульсы KL1/KL2/насоса могут идти одновременно с движением.
  */
 
 #include "valves.h"
+#include "motion_jobs.h"
+#include "log.h"
 #include <Arduino.h>
+#include <util/atomic.h>
+
+// Запись расписания импульсов выхода
+typedef struct {
+  uint8_t pin;                      // 0 - запись свободна
+  volatile bool active;
+  volatile bool isOn;
+  uint16_t onMs;
+  uint16_t offMs;
+  volatile uint16_t remaining;      // импульсов осталось, включая текущий
+  volatile unsigned long deadline;  // millis() следующего переключения
+  bool notify;
+  volatile bool finished;           // событие для хоста ещё не выведено
+  volatile bool aborted;
+} ValvePulse;
+
+static ValvePulse pulses[VALVE_PULSE_SLOTS];
+
+// ============== РАСПИСАНИЕ ИМПУЛЬСОВ ==============
+static void servicePulseTable() {
+  unsigned long now = millis();
+  for (uint8_t i = 0; i < VALVE_PULSE_SLOTS; i++) {
+    ValvePulse& pulse = pulses[i];
+    if (!pulse.active || (long)(now - pulse.deadline) < 0) continue;
+
+    if (pulse.isOn) {
+      digitalWrite(pulse.pin, LOW);
+      pulse.isOn = false;
+      if (--pulse.remaining == 0) {
+        pulse.active = false;
+        pulse.finished = true;
+        continue;
+      }
+      pulse.deadline += pulse.offMs;
+    } else {
+      digitalWrite(pulse.pin, HIGH);
+      pulse.isOn = true;
+      pulse.deadline += pulse.onMs;
+    }
+  }
+}
+
+#if VALVE_SCHEDULER_TIMER0
+ISR(TIMER0_COMPA_vect) {
+  servicePulseTable();
+}
+#endif
+
+static ValvePulse* findPulse(int pin) {
+  for (uint8_t i = 0; i < VALVE_PULSE_SLOTS; i++) {
+    if (pulses[i].pin == pin) return &pulses[i];
+  }
+  return nullptr;
+}
+
+// Снятие расписания выхода: ручная команда или дозирование управляют им напрямую
+static void cancelPulse(int pin) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    ValvePulse* pulse = findPulse(pin);
+    if (pulse && pulse->active) {
+      pulse->active = false;
+      pulse->aborted = true;
+      pulse->finished = true;
+    }
+  }
+}
+
+static const __FlashStringHelper* outputName(int pin) {
+  if (pin == KL1_PIN) return F("kl1");
+  if (pin == KL2_PIN) return F("kl2");
+  if (pin == PUMP_PIN) return F("pump");
+  return F("output");
+}
+
+// Событие о завершении импульсов записи (из прерывания печатать нельзя - только основной цикл)
+static void reportPulse(ValvePulse& pulse) {
+  if (pulse.notify) {
+    if (pulse.aborted) {
+      Serial.print(MSG_ERROR);
+      Serial.print(F(": "));
+      Serial.print(MSG_JOB_ABORTED);
+    } else {
+      Serial.print(MSG_COMPLETED);
+    }
+    Serial.print(' ');
+    Serial.println(outputName(pulse.pin));
+  }
+  pulse.finished = false;
+}
 
 // Инициализация пинов клапанов и насоса
 void initializeValves() {
@@ -20,20 +115,37 @@ void initializeValves() {
   
   digitalWrite(KL1_PIN, LOW);
   digitalWrite(KL2_PIN, LOW);
+  
+  for (uint8_t i = 0; i < VALVE_PULSE_SLOTS; i++) {
+    pulses[i].pin = 0;
+    pulses[i].active = false;
+    pulses[i].finished = false;
+  }
+  
+#if VALVE_SCHEDULER_TIMER0
+  // Канал A Timer0: счётчик идёт для millis(), прерывание по совпадению в середине периода
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    OCR0A = 0x80;
+    TIMSK0 |= (1 << OCIE0A);
+  }
+#endif
 }
 
 // Управление насосом
 void setPumpState(bool state) {
+  cancelPulse(PUMP_PIN);
   digitalWrite(PUMP_PIN, state ? HIGH : LOW);
 }
 
 // Переключение состояния клапана
 void toggleValveState(int valvePin) {
+  cancelPulse(valvePin);
   digitalWrite(valvePin, !digitalRead(valvePin));
 }
 
 // Установка состояния клапана
 void setValveState(int valvePin, bool state) {
+  cancelPulse(valvePin);
   digitalWrite(valvePin, state ? HIGH : LOW);
 }
 
@@ -47,9 +159,88 @@ void turnValveOff(int valvePin) {
   setValveState(valvePin, LOW);
 }
 
-// Открытие клапана на указанное время (в сотых долях секунды)
-void openValveForTime(int valvePin, int timeInCentiseconds) {
-  turnValveOn(valvePin);
-  delay(timeInCentiseconds * 10); // Переводим сотые доли секунды в миллисекунды (1/100 сек = 10 мс)
-  turnValveOff(valvePin);
-} 
\ No newline at end of file
+// Открытие клапана на указанное время (в сотых долях секунды), без ожидания
+bool openValveForTime(int valvePin, int timeInCentiseconds, bool notify) {
+  if (timeInCentiseconds <= 0 || timeInCentiseconds > VALVE_PULSE_MAX_MS / 10) return false;
+  return startValvePulse(valvePin, timeInCentiseconds * 10, 1, 0, notify);
+}
+
+bool startValvePulse(int pin, uint16_t onMs, uint16_t count, uint16_t periodMs, bool notify) {
+  if (onMs == 0 || count == 0 || (count > 1 && periodMs <= onMs)) return false;
+  
+  cancelPulse(pin);
+  // Запись выхода переиспользуется ниже - событие заменённой серии выводится до этого
+  ValvePulse* replaced = findPulse(pin);
+  if (replaced && replaced->finished) reportPulse(*replaced);
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    // Запись этого выхода или свободная (завершённая, событие которой уже выведено)
+    ValvePulse* pulse = findPulse(pin);
+    for (uint8_t i = 0; !pulse && i < VALVE_PULSE_SLOTS; i++) {
+      if (pulses[i].pin == 0 || (!pulses[i].active && !pulses[i].finished)) pulse = &pulses[i];
+    }
+    if (!pulse) return false;
+    
+    pulse->pin = pin;
+    pulse->onMs = onMs;
+    pulse->offMs = count > 1 ? periodMs - onMs : 0;
+    pulse->remaining = count;
+    pulse->notify = notify;
+    pulse->finished = false;
+    pulse->aborted = false;
+    pulse->isOn = true;
+    pulse->deadline = millis() + onMs;
+    digitalWrite(pin, HIGH);
+    pulse->active = true;
+  }
+  
+#if !VALVE_SCHEDULER_TIMER0
+  serviceValves();
+#endif
+  return true;
+}
+
+void serviceValves() {
+#if !VALVE_SCHEDULER_TIMER0
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    servicePulseTable();
+  }
+#endif
+  
+  // События о завершении импульсов (из прерывания печатать нельзя)
+  for (uint8_t i = 0; i < VALVE_PULSE_SLOTS; i++) {
+    if (pulses[i].finished) reportPulse(pulses[i]);
+  }
+}
+
+bool isValvePulseActive(int pin) {
+  ValvePulse* pulse = findPulse(pin);
+  return pulse && pulse->active;
+}
+
+void releaseValvePulse(int pin) {
+  // Выход в фазе импульса остался бы включённым до события движения - гасим его.
+  // Без расписания уровень задан вручную и остаётся, как есть
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    bool scheduled = isValvePulseActive(pin);
+    cancelPulse(pin);
+    if (scheduled) digitalWrite(pin, LOW);
+  }
+}
+
+bool waitValvePulse(int pin) {
+  ValvePulse* pulse = findPulse(pin);
+  if (!pulse) return false;
+  while (pulse->active) {
+    serviceMotionJobs();
+    serviceValves();
+    serviceLog();
+    yield();
+  }
+  bool completed = !pulse->aborted;
+  pulse->finished = false;   // ответ даёт ожидающая команда
+  return completed;
+}
+
+uint16_t getValvesMemory() {
+  return sizeof(pulses);
+}
@@ -0,0 +1,101 @@
+/**
+ * @file: weight_sampler.cpp
+ * @description: Фоновый опрос датчика веса HX711 для NBHX711
+ * @dependencies: NBHX711, perf, config.h
+ * @created: 2026-10-14
+ *
+ * Пин DT (40, PG1) не имеет ни внешнего прерывания, ни PCINT, поэтому фронт готовности
+ * ловится опросом: Timer2 в режиме CTC проверяет регистр PING с частотой WEIGHT_SAMPLER_POLL_HZ.
+ * Чтение 24 бит выполняется в прерывании с разрешёнными прерываниями (ISR_NOBLOCK),
+ * так что каналы step_engine на таймерах 1/3/4/5 вытесняют его и не теряют точность шага.
+ */
+
+#include "weight_sampler.h"
+#include "perf.h"
+#include <Arduino.h>
+#include <NBHX711.h>
+#include <util/atomic.h>
+
+extern NBHX711 scale;
+
+static volatile uint32_t sampleCount = 0;
+static volatile unsigned long lastSampleTime = 0;
+static volatile bool samplerBusy = false;
+static volatile WeightSampleHandler sampleHandler = nullptr;
+
+static void takeSample() {
+  uint32_t start = perfNow();
+  if (scale.update()) {
+    perfRecord(PERF_HX711, perfNow() - start);
+    sampleCount++;
+    lastSampleTime = millis();
+    WeightSampleHandler handler = sampleHandler;
+    if (handler) handler(scale.getRaw());
+  }
+}
+
+#if WEIGHT_SAMPLER_TIMER2
+#if F_CPU / 64 / WEIGHT_SAMPLER_POLL_HZ > 256
+#error "WEIGHT_SAMPLER_POLL_HZ слишком мала для 8-битного Timer2 с делителем 64"
+#endif
+
+ISR(TIMER2_COMPA_vect, ISR_NOBLOCK) {
+  if (samplerBusy) return;
+  samplerBusy = true;
+  takeSample();
+  samplerBusy = false;
+}
+#endif
+
+void initializeWeightSampler() {
+  lastSampleTime = millis();
+#if WEIGHT_SAMPLER_TIMER2
+  // CTC, делитель 64: 250 кГц / WEIGHT_SAMPLER_POLL_HZ
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    TCCR2A = (1 << WGM21);
+    TCCR2B = (1 << CS22);
+    TCNT2 = 0;
+    OCR2A = (uint8_t)(F_CPU / 64 / WEIGHT_SAMPLER_POLL_HZ - 1);
+    TIFR2 = (1 << OCF2A);
+    TIMSK2 = (1 << OCIE2A);
+  }
+#endif
+}
+
+void serviceWeightSampler() {
+#if !WEIGHT_SAMPLER_TIMER2
+  takeSample();
+#endif
+}
+
+void setWeightSampleHandler(WeightSampleHandler handler) {
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    sampleHandler = handler;
+  }
+}
+
+uint32_t getWeightSampleCount() {
+  uint32_t count;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    count = sampleCount;
+  }
+  return count;
+}
+
+unsigned long getWeightSampleAge() {
+  unsigned long last;
+  ATOMIC_BLOCK(ATOMIC_RESTORESTATE) {
+    last = lastSampleTime;
+  }
+  return millis() - last;
+}
+
+bool waitWeightSamples(uint8_t count, unsigned long timeoutMs) {
+  uint32_t target = getWeightSampleCount() + count;
+  unsigned long start = millis();
+  while ((int32_t)(getWeightSampleCount() - target) < 0) {
+    if (millis() - start > timeoutMs) return false;
+    serviceWeightSampler();
+  }
+  return true;
+}
@@ -18,34 +18,46 @@
 
  #include <Arduino.h>
  #include "GyverStepper.h"
- #include "GyverPlanner.h"
+ #include "GyverPlanner2.h"
  #include "HX711.h"
+ #include "axis_model.h"  // общая модель осей arduino/include: пины, пределы, полярность датчиков
  
  // ============================================
  // SECURITY & SAFETY CONFIGURATION
  // ============================================
  
  // Конфигурация безопасности буфера команд
- constexpr uint8_t MAX_COMMAND_LENGTH = 64;      // Максимальная длина команды (защита от переполнения)
+ constexpr uint8_t MAX_COMMAND_LENGTH = 128;     // Максимальная длина строки команды (защита от переполнения)
+ constexpr char COMMAND_SEPARATOR = ';';         // Разделитель шагов пакета в одной строке
  constexpr uint32_t HOMING_TIMEOUT_MS = 30000;   // Таймаут операции homing - 30 секунд
  constexpr uint32_t MOVE_TIMEOUT_MS = 60000;     // Таймаут операции движения - 60 секунд
  constexpr uint32_t EMERGENCY_CHECK_INTERVAL = 100; // Интервал проверки аварийных условий в мс
  constexpr uint32_t WATCHDOG_TIMEOUT_MS = 600000;  // Watchdog таймаут - 10 минут без активности
  
- constexpr uint8_t NUM_MOTORS = 5;  // Общее количество моторов в системе
+ constexpr uint8_t NUM_MOTORS = AXIS_COUNT;  // Общее количество моторов в системе (модель осей)
+ 
+ // Потоковая очередь траектории (команда queue)
+ constexpr uint8_t PLANNER_BUFFER_SIZE = 16;  // Буфер look-ahead планировщика (хранит SIZE-1 точек)
+ constexpr uint8_t STREAM_QUEUE_SIZE = 16;    // Очередь точек, принятых от хоста и ещё не переданных планировщику
  
  // Константы для весов и пинов
  constexpr uint8_t NUM_INPUT_PINS = 8;  // Количество входных пинов для мониторинга
  constexpr uint32_t WEIGHT_MEASUREMENT_TIMEOUT = 5000;  // Таймаут измерения веса (5 сек)
  
+ // Периоды задач планировщика loop() в мс
+ constexpr uint16_t SERIAL_TASK_PERIOD_MS = 1;       // Приём команд: всё, что накопилось в буфере UART
+ constexpr uint16_t RESERVOIR_TASK_PERIOD_MS = 250;  // Опрос переполнения резервуара
+ constexpr uint16_t WEIGHT_TASK_PERIOD_MS = 100;     // Считывание веса (HX711 выдаёт 10 или 80 отсчётов/сек)
+ constexpr uint16_t TELEMETRY_DEFAULT_PERIOD_MS = 500; // Период телеметрии по команде telemetry без аргумента
+ 
  // Идентификаторы моторов - используются для индексации массивов
  // Имена соответствуют физическим осям или функциям
  enum MotorID : uint8_t {
-     MULTI = 0,      // X-axis - основная горизонтальная ось
-     MULTIZONE = 1,  // Y-axis - вторая горизонтальная ось
-     RRIGHT = 2,     // Z-axis - вертикальная ось
-     E0 = 3,         // Экструдер/захват 0
-     E1 = 4          // Экструдер/захват 1
+     MULTI = AXIS_MULTI,          // X-axis - основная горизонтальная ось
+     MULTIZONE = AXIS_MULTIZONE,  // Y-axis - вторая горизонтальная ось
+     RRIGHT = AXIS_RRIGHT,        // Z-axis - вертикальная ось
+     E0 = AXIS_E0,                // Экструдер/захват 0
+     E1 = AXIS_E1                 // Экструдер/захват 1
  };
  
  // Идентификаторы контрольных пинов
@@ -70,7 +82,8 @@
      ERROR_BUFFER_OVERFLOW,       // Переполнение буфера команд
      ERROR_INVALID_COMMAND,       // Неизвестная или некорректная команда
      ERROR_WEIGHT_SENSOR,         // Ошибка датчика веса
-     ERROR_RESERVOIR_OVERFLOW     // Переполнение резервуара
+     ERROR_RESERVOIR_OVERFLOW,    // Переполнение резервуара
+     ERROR_BUSY                   // Занято homing или потоковым маршрутом
  };
  
  // ============================================
@@ -152,6 +165,24 @@
      bool isCalibrated;     // Флаг калибровки
      bool isMeasuring;      // Флаг активного измерения
      uint32_t lastMeasurement; // Время последнего измерения
+     float lastWeight;      // Последний отсчёт задачи считывания веса, граммы
+ };
+ 
+ /**
+  * Периодическая задача основного цикла
+  * Срок следующего запуска отсчитывается от предыдущего срока, а не от момента
+  * запуска, поэтому период не уплывает. Пропуск целого периода считается превышением.
+  */
+ struct ScheduledTask {
+     const char* name;      // Имя для команды tasks
+     void (*run)();         // Функция задачи
+     uint16_t periodMs;     // Период запуска
+     bool enabled;          // Задача участвует в планировании
+     uint32_t nextRunMs;    // Срок следующего запуска (millis)
+     uint32_t runs;         // Количество запусков
+     uint32_t maxRuntimeUs; // Худшее время выполнения
+     uint32_t maxLateMs;    // Наибольшее опоздание относительно срока
+     uint16_t overruns;     // Пропущенные сроки и выполнения дольше периода
  };
  
  // ============================================
@@ -160,29 +191,31 @@
  
  /**
   * Массив конфигураций всех моторов системы
-  * Содержит физические параметры и настройки безопасности
+  * Пины, скорости, шаги на единицу и тип концевика берутся из общей модели осей
+  * (arduino/include/config.h), здесь - питание, хоминг и пределы безопасности этой прошивки
   * 
   * ВАЖНО: Эти параметры должны быть настроены под конкретное оборудование!
   */
+ #define MOTOR_AXIS(id, name, alwaysOn) \
+     axisModel[id].stepPin, axisModel[id].dirPin, axisModel[id].enablePin, axisModel[id].endstopPin, name, \
+     axisModel[id].maxSpeed, axisModel[id].acceleration, axisModel[id].homingFastSpeed, \
+     axisModel[id].endstopNPN, alwaysOn, axisModel[id].stepsPerUnit
+
  constexpr MotorConfig motors[NUM_MOTORS] = {
      // Multi (X-axis) - основная горизонтальная ось
-     {A0, A1, 38, 14, "Multi(X)", 500, 500, 3000, false, true, 40, 16000, 1000, 1000, -200.0, 200.0, 300},
+     {MOTOR_AXIS(MULTI, "Multi(X)", true), 16000, 1000, 1000, -200.0, 200.0, 300},
      
-     // Multizone (Y-axis) - вторая горизонтальная ось
-     // Имеет меньшую скорость и NPN концевик
-     {A6, A7, A2, 2, "Multizone(Y)", 200, 300, 40, true, true, 80, 16000, 200, 0, -100.0, 100.0, 150},
+     // Multizone (Y-axis) - вторая горизонтальная ось, NPN концевик
+     {MOTOR_AXIS(MULTIZONE, "Multizone(Y)", true), 16000, 200, 0, -100.0, 100.0, 150},
      
-     // RRight (Z-axis) - вертикальная ось
-     // Высокая скорость homing, большой диапазон движения
-     {46, 48, A8, 2, "RRight(Z)", 1000, 200, 10000, true, true, 200, 60000, 100, 60, -300.0, 0.0, 800},
+     // RRight (Z-axis) - вертикальная ось, большой диапазон движения
+     {MOTOR_AXIS(RRIGHT, "RRight(Z)", true), 60000, 100, 60, -300.0, 0.0, 800},
      
-     // E0 - первый экструдер/захват
-     // Высокая скорость, отключается после использования
-     {26, 28, 24, 15, "E0", 2000, 2000, 2000, true, false, 200, 16000, 200, 0, -50.0, 50.0, 1500},
+     // E0 - первый экструдер/захват, отключается после использования
+     {MOTOR_AXIS(E0, "E0", false), 16000, 200, 0, -50.0, 50.0, 1500},
      
-     // E1 - второй экструдер/захват
-     // Аналогичен E0, используется для парной работы
-     {36, 34, 30, 15, "E1", 2000, 2000, 2000, true, false, 200, 16000, 200, 0, -50.0, 50.0, 1500}
+     // E1 - второй экструдер/захват, используется для парной работы
+     {MOTOR_AXIS(E1, "E1", false), 16000, 200, 0, -50.0, 50.0, 1500}
  };
  
  /**
@@ -219,6 +252,29 @@
      {11, "INPUT7", false},     // Входной пин 7
      {12, "INPUT8", false}      // Входной пин 8
  };
+ static_assert(sizeof(inputPins) / sizeof(InputPinConfig) == NUM_INPUT_PINS,
+               "NUM_INPUT_PINS не совпадает с inputPins[]");
+ 
+ /**
+  * Снимок входных пинов
+  * Все биты маски относятся к одному моменту времени timestampUs
+  */
+ struct InputSnapshot {
+     uint32_t timestampUs;  // micros() в момент чтения портов
+     uint8_t mask;          // Бит i - активное состояние inputPins[i]
+ };
+ 
+ /**
+  * Карта портов входных пинов
+  * Строится один раз в setup(): каждый регистр PINx читается в снимке ровно один раз
+  */
+ struct InputPortMap {
+     volatile uint8_t* ports[NUM_INPUT_PINS]; // Уникальные регистры PINx
+     uint8_t portCount;                       // Количество уникальных портов
+     uint8_t portIndex[NUM_INPUT_PINS];       // Индекс порта для каждого входа
+     uint8_t bitMask[NUM_INPUT_PINS];         // Бит входа в регистре порта
+     uint8_t activeLowMask;                   // Входы с активным низким уровнем
+ };
  
  // ============================================
  // ENHANCED GLOBAL OBJECTS
@@ -229,15 +285,30 @@
   * Каждый объект содержит текущую позицию и управляет пинами STEP/DIR
   */
  Stepper<STEPPER2WIRE> steppers[NUM_MOTORS] = {
-     Stepper<STEPPER2WIRE>(motors[0].stepPin, motors[0].dirPin),
-     Stepper<STEPPER2WIRE>(motors[1].stepPin, motors[1].dirPin),
-     Stepper<STEPPER2WIRE>(motors[2].stepPin, motors[2].dirPin),
-     Stepper<STEPPER2WIRE>(motors[3].stepPin, motors[3].dirPin),
-     Stepper<STEPPER2WIRE>(motors[4].stepPin, motors[4].dirPin)
+     Stepper<STEPPER2WIRE>(Axis<MULTI>::stepPin(), Axis<MULTI>::dirPin()),
+     Stepper<STEPPER2WIRE>(Axis<MULTIZONE>::stepPin(), Axis<MULTIZONE>::dirPin()),
+     Stepper<STEPPER2WIRE>(Axis<RRIGHT>::stepPin(), Axis<RRIGHT>::dirPin()),
+     Stepper<STEPPER2WIRE>(Axis<E0>::stepPin(), Axis<E0>::dirPin()),
+     Stepper<STEPPER2WIRE>(Axis<E1>::stepPin(), Axis<E1>::dirPin())
  };
  
  // Планировщик движения - координирует движение всех моторов
- GPlanner<STEPPER2WIRE, NUM_MOTORS> planner;
+ // GPlanner2 хранит маршрут в FIFO и сглаживает скорость в вершинах (look-ahead)
+ GPlanner2<STEPPER2WIRE, NUM_MOTORS, PLANNER_BUFFER_SIZE> planner;
+ 
+ /**
+  * Потоковая очередь траектории
+  * Точки команды queue копятся здесь и дозаливаются в буфер планировщика
+  * по мере освобождения места. Ответ OK <свободно> даёт хосту управление потоком.
+  */
+ struct TrajectoryStream {
+     int32_t points[STREAM_QUEUE_SIZE][NUM_MOTORS]; // Кольцевой буфер точек в шагах
+     uint8_t head = 0;                  // Индекс записи
+     uint8_t count = 0;                 // Точек в очереди
+     int32_t last[NUM_MOTORS];          // Последняя принятая точка (для неуказанных осей)
+     bool active = false;               // Маршрут принимается или выполняется
+     bool endRequested = false;         // Получен queue_end - завершить после последней точки
+ } stream;
  
  /**
   * Глобальное состояние системы
@@ -248,6 +319,7 @@
      volatile bool homingActive = false;       // Флаг выполнения homing
      volatile bool emergencyStop = false;      // Флаг аварийной остановки
      volatile ErrorCode lastError = ERROR_NONE; // Последний код ошибки
+     volatile uint8_t errorCount = 0;          // Счётчик ошибок - пакет команд узнаёт по нему сбой шага
      volatile bool commandInProgress = false;  // Флаг выполнения команды
      uint32_t lastActivityTime = 0;           // Время последней активности (для watchdog)
      
@@ -255,6 +327,7 @@
      char inputBuffer[MAX_COMMAND_LENGTH];    // Буфер для накопления команды
      uint8_t inputBufferPos = 0;              // Текущая позиция в буфере
      bool commandReady = false;               // Флаг готовности команды к обработке
+     bool inputOverflow = false;              // Строка длиннее буфера - будет отброшена
  } state;
  
  // Глобальные менеджеры безопасности
@@ -263,13 +336,15 @@
  
  // Глобальные объекты для весов и мониторинга
  HX711 weightSensor; // Датчик веса
- WeightSensor weightManager = {&weightSensor, 1.0, 0.0, false, false, 0};    // Менеджер весов
+ WeightSensor weightManager = {&weightSensor, 1.0, 0.0, false, false, 0, 0.0};    // Менеджер весов
+ InputPortMap inputMap;          // Карта портов входных пинов
  
  // ============================================
  // FORWARD DECLARATIONS
  // ============================================
  
  // Функции обработки команд
+ void processCommandLine(char* line);
  void processCommand(const char* command);
  void parseHomingFlags(const char* args, bool flags[]);
  void parseMoveCommand(const char* args, float positions[], bool active[]);
@@ -281,8 +356,18 @@
  void coordinatedMove(float positions[], bool active[]);
  void homeMotors(bool flags[]);
  void performBackoff(const char* phase, int32_t positions[]);
+ void plannerSync();
+ bool plannerGoTo(int32_t targets[]);
+ 
+ // Функции потоковой очереди траектории
+ void queuePoint(float positions[], bool active[]);
+ void endTrajectoryStream();
+ void serviceTrajectoryStream();
+ void resetTrajectoryStream();
+ uint8_t streamFreeSlots();
  
  // Функции безопасности
+ void setError(ErrorCode code);
  void emergencyStop();
  void checkEmergency();
  void startTimeout(uint32_t duration);
@@ -308,6 +393,8 @@
  bool readEndstop(uint8_t motor);
  
  // Функции мониторинга и весов
+ void initInputSnapshot();
+ InputSnapshot readInputSnapshot();
  void readInputPins();
  void startWeightMeasurement();
  void stopWeightMeasurement();
@@ -316,6 +403,31 @@
  float getWeight();
  bool checkReservoirOverflow();
  
+ // Функции планировщика задач
+ void runScheduler();
+ void resetTaskStats();
+ void printTaskStats();
+ void setTelemetryPeriod(uint16_t periodMs);
+ void taskSerialDrain();
+ void taskReservoir();
+ void taskWeightSample();
+ void taskTelemetry();
+ 
+ /**
+  * Задачи основного цикла в порядке приоритета
+  * За один вызов runScheduler() выполняется одна задача, между задачами
+  * вызывающий цикл успевает сделать planner.tick()
+  */
+ ScheduledTask tasks[] = {
+     {"serial", taskSerialDrain, SERIAL_TASK_PERIOD_MS, true, 0, 0, 0, 0, 0},
+     {"emergency", checkEmergency, EMERGENCY_CHECK_INTERVAL, true, 0, 0, 0, 0, 0},
+     {"reservoir", taskReservoir, RESERVOIR_TASK_PERIOD_MS, true, 0, 0, 0, 0, 0},
+     {"weight", taskWeightSample, WEIGHT_TASK_PERIOD_MS, true, 0, 0, 0, 0, 0},
+     {"telemetry", taskTelemetry, TELEMETRY_DEFAULT_PERIOD_MS, false, 0, 0, 0, 0, 0}
+ };
+ constexpr uint8_t NUM_TASKS = sizeof(tasks) / sizeof(ScheduledTask);
+ bool reservoirOverflowSeen = false;  // Переполнение уже сообщено задачей reservoir
+ 
  // ============================================
  // SECURITY & VALIDATION FUNCTIONS
  // ============================================
@@ -371,7 +483,7 @@
   */
  bool isPositionSafe(uint8_t motor, float position) {
      if (!validateMotorPosition(motor, position)) {
-         state.lastError = ERROR_INVALID_POSITION;
+         setError(ERROR_INVALID_POSITION);
          return false;
      }
      
@@ -439,6 +551,17 @@
      timeoutManager.active = false;
  }
  
+ /**
+  * Фиксация ошибки команды
+  * Код остаётся в status до сброса, счётчик показывает пакету команд, что шаг не выполнен
+  * 
+  * @param code - код ошибки
+  */
+ void setError(ErrorCode code) {
+     state.lastError = code;
+     state.errorCount++;
+ }
+ 
  /**
   * КРИТИЧЕСКАЯ ФУНКЦИЯ: Аварийная остановка системы
   * Немедленно останавливает все операции и блокирует систему
@@ -451,15 +574,16 @@
      state.commandInProgress = false;
      state.homingActive = false;
      
-     // Останавливаем планировщик движения
-     planner.brake();
+     // Останавливаем планировщик движения и сбрасываем маршрут
+     plannerSync();
+     resetTrajectoryStream();
      
      // Немедленно отключаем все моторы
      for (uint8_t i = 0; i < NUM_MOTORS; i++) {
          digitalWrite(motors[i].enablePin, HIGH); // Выключение моторов
      }
      
-     state.lastError = ERROR_EMERGENCY_STOP;
+     setError(ERROR_EMERGENCY_STOP);
      interrupts(); // Восстанавливаем прерывания
      
      // Информируем оператора
@@ -497,28 +621,67 @@
  // ============================================
  
  /**
-  * Чтение состояния всех входных пинов
-  * Возвращает битовую маску состояния пинов
-  * 
-  * @return битовая маска (8 бит) состояния входных пинов
+  * Построение карты портов входных пинов
+  * Номера пинов Arduino переводятся в регистр PINx и маску бита один раз,
+  * чтобы снимок не тратил время на digitalPinToPort() при каждом опросе
   */
- void readInputPins() {
-     uint8_t pinMask = 0;
-     
+ void initInputSnapshot() {
+     inputMap.portCount = 0;
+     inputMap.activeLowMask = 0;
+ 
      for (uint8_t i = 0; i < NUM_INPUT_PINS; i++) {
-         bool pinState = digitalRead(inputPins[i].pin);
-         
-         // Инвертируем логику если пин активный низкий
+         volatile uint8_t* port = portInputRegister(digitalPinToPort(inputPins[i].pin));
+         uint8_t index = 0;
+         while (index < inputMap.portCount && inputMap.ports[index] != port) {
+             index++;
+         }
+         if (index == inputMap.portCount) {
+             inputMap.ports[inputMap.portCount++] = port;
+         }
+ 
+         inputMap.portIndex[i] = index;
+         inputMap.bitMask[i] = digitalPinToBitMask(inputPins[i].pin);
          if (inputPins[i].isActiveLow) {
-             pinState = !pinState;
+             inputMap.activeLowMask |= (1 << i);
          }
-         
-         // Устанавливаем соответствующий бит в маске
-         if (pinState) {
-             pinMask |= (1 << i);
+     }
+ }
+ 
+ /**
+  * Снимок всех входных пинов
+  * Порты читаются подряд с запрещёнными прерываниями, вместе с отметкой времени
+  * 
+  * @return маска активных входов и время чтения
+  */
+ InputSnapshot readInputSnapshot() {
+     uint8_t values[NUM_INPUT_PINS] = {0};
+     InputSnapshot snapshot;
+ 
+     noInterrupts();
+     snapshot.timestampUs = micros();
+     for (uint8_t p = 0; p < inputMap.portCount; p++) {
+         values[p] = *inputMap.ports[p];
+     }
+     interrupts();
+ 
+     uint8_t mask = 0;
+     for (uint8_t i = 0; i < NUM_INPUT_PINS; i++) {
+         if (values[inputMap.portIndex[i]] & inputMap.bitMask[i]) {
+             mask |= (1 << i);
          }
      }
-     
+     // Инвертируем логику для пинов с активным низким уровнем
+     snapshot.mask = mask ^ inputMap.activeLowMask;
+     return snapshot;
+ }
+ 
+ /**
+  * Чтение состояния всех входных пинов
+  * Выводит битовую маску состояния пинов из одного снимка портов
+  */
+ void readInputPins() {
+     uint8_t pinMask = readInputSnapshot().mask;
+ 
      // Выводим битовую маску в формате 00000000
      Serial.print("INPUT_PINS: ");
      for (int8_t i = 7; i >= 0; i--) {
@@ -552,6 +715,7 @@
   */
  void startWeightMeasurement() {
      if (!weightManager.isCalibrated) {
+         setError(ERROR_WEIGHT_SENSOR);
          Serial.println("ERROR: Weight sensor not calibrated");
          return;
      }
@@ -581,6 +745,7 @@
      }
      
      if (millis() - weightManager.lastMeasurement > WEIGHT_MEASUREMENT_TIMEOUT) {
+         setError(ERROR_WEIGHT_SENSOR);
          Serial.println("ERROR: Weight measurement timeout");
          stopWeightMeasurement();
          return 0.0;
@@ -591,6 +756,7 @@
          weightManager.lastMeasurement = millis();
          return weight;
      } else {
+         setError(ERROR_WEIGHT_SENSOR);
          Serial.println("ERROR: Weight sensor not ready");
          return 0.0;
      }
@@ -618,6 +784,7 @@
          weightManager.offset = 0.0;
          Serial.println("Weight sensor zeroed");
      } else {
+         setError(ERROR_WEIGHT_SENSOR);
          Serial.println("ERROR: Weight sensor not ready for zeroing");
      }
  }
@@ -644,10 +811,10 @@
   * @param steps - количество шагов
   * @return значение в единицах
   * 
-  * ВНИМАНИЕ: Потенциальное деление на ноль если stepsPerUnit = 0!
+  * stepsPerUnit = 0 не пропускает static_assert модели осей (axisModelValid)
+  * Для оси, известной при компиляции, - Axis<id>::toUnits(): деление сворачивается в константу
   */
  inline float toUnits(uint8_t motor, int32_t steps) {
-     // TODO: Добавить проверку на ноль
      return (float)steps / motors[motor].stepsPerUnit;
  }
  
@@ -687,6 +854,7 @@
  void enableAllMotors() {
      // Блокируем включение при аварийной остановке
      if (state.emergencyStop) {
+         setError(ERROR_EMERGENCY_STOP);
          Serial.println("ERROR: Cannot enable motors - emergency stop active");
          return;
      }
@@ -724,6 +892,7 @@
   */
  void controlPin(uint8_t pinIndex, bool state) {
      if (!validatePinIndex(pinIndex)) {
+         setError(ERROR_INVALID_PIN);
          Serial.println("ERROR: Invalid pin index");
          return;
      }
@@ -753,19 +922,28 @@
  void coordinatedMove(float positions[], bool active[]) {
      // Проверка 1: Аварийное состояние
      if (state.emergencyStop) {
+         setError(ERROR_EMERGENCY_STOP);
          Serial.println("ERROR: Emergency stop active");
          return;
      }
      
      // Проверка 2: Блокировка во время homing
      if (state.homingActive) {
+         setError(ERROR_BUSY);
          Serial.println("ERROR: Cannot move during homing");
          return;
      }
      
-     // Проверка 3: Валидация всех позиций
+     // Проверка 3: Потоковый маршрут владеет планировщиком
+     if (stream.active) {
+         setError(ERROR_BUSY);
+         Serial.println("ERROR: Trajectory queue active");
+         return;
+     }
+     
+     // Проверка 4: Валидация всех позиций
      if (!validateMove(positions, active)) {
-         state.lastError = ERROR_INVALID_POSITION;
+         setError(ERROR_INVALID_POSITION);
          return;
      }
      
@@ -814,7 +992,7 @@
      }
      
      // Передаём целевые позиции планировщику
-     planner.setTarget(targets);
+     plannerGoTo(targets);
      
      // Запускаем таймаут для контроля времени выполнения
      startTimeout(MOVE_TIMEOUT_MS);
@@ -826,16 +1004,19 @@
          
          // Проверка аварийных условий
          if (state.emergencyStop || isTimeoutExpired()) {
-             planner.brake();  // Экстренная остановка
+             plannerSync();  // Экстренная остановка
              clearTimeout();
              state.commandInProgress = false;
+             // Аварийная остановка уже записала свой код
+             if (!state.emergencyStop) {
+                 setError(ERROR_TIMEOUT);
+                 Serial.println("ERROR: Move timeout");
+             }
              return;
          }
          
-         // Периодическая проверка безопасности (каждые 100мс)
-         if (millis() % EMERGENCY_CHECK_INTERVAL == 0) {
-             checkEmergency();
-         }
+         // Проверка безопасности, приём команд и опрос датчиков по своим периодам
+         runScheduler();
      }
      
      // Движение завершено успешно
@@ -857,6 +1038,186 @@
      Serial.println("COMPLETE");
  }
  
+ /**
+  * Синхронизация буфера планировщика с фактическими позициями моторов
+  * GPlanner2 считает путь от точки 0 своего буфера, поэтому после остановки
+  * или обнуления позиций буфер очищается и начинается с текущего положения
+  */
+ void plannerSync() {
+     planner.brake();
+     planner.clearBuffer();
+     
+     int32_t current[NUM_MOTORS];
+     for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+         current[i] = steppers[i].pos;
+     }
+     planner.addTarget(current, 0);
+ }
+ 
+ /**
+  * Постановка одиночной цели как конечной точки маршрута
+  * Завершение отслеживается через planner.ready()
+  * 
+  * @param targets - целевые позиции в шагах
+  * @return false если все оси уже на месте (ready() не сработает)
+  */
+ bool plannerGoTo(int32_t targets[]) {
+     bool hasMovement = false;
+     for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+         if (targets[i] != steppers[i].pos) hasMovement = true;
+     }
+     if (!hasMovement) return false;
+     
+     planner.addTarget(targets, 1);
+     planner.start();
+     return true;
+ }
+ 
+ // ============================================
+ // STREAMING TRAJECTORY QUEUE
+ // ============================================
+ 
+ /**
+  * Свободное место в очереди маршрута (в точках)
+  */
+ uint8_t streamFreeSlots() {
+     return STREAM_QUEUE_SIZE - stream.count;
+ }
+ 
+ /**
+  * Сброс очереди маршрута без движения моторов
+  */
+ void resetTrajectoryStream() {
+     stream.head = 0;
+     stream.count = 0;
+     stream.active = false;
+     stream.endRequested = false;
+ }
+ 
+ /**
+  * Добавление точки в потоковый маршрут
+  * Неуказанные оси сохраняют значение предыдущей точки маршрута.
+  * Ответ: OK <свободно> или ERROR при ошибке/переполнении
+  * 
+  * @param positions - массив позиций в единицах
+  * @param active - массив флагов указанных осей
+  */
+ void queuePoint(float positions[], bool active[]) {
+     if (state.emergencyStop) {
+         setError(ERROR_EMERGENCY_STOP);
+         Serial.println("ERROR: Emergency stop active");
+         return;
+     }
+     
+     // Без координат - только запрос свободного места
+     bool hasPoint = false;
+     for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+         if (active[i]) hasPoint = true;
+     }
+     if (!hasPoint) {
+         Serial.print("OK ");
+         Serial.println(streamFreeSlots());
+         return;
+     }
+     
+     if (stream.endRequested) {
+         setError(ERROR_BUSY);
+         Serial.println("ERROR: Queue is finishing");
+         return;
+     }
+     
+     if (stream.count >= STREAM_QUEUE_SIZE) {
+         setError(ERROR_BUFFER_OVERFLOW);
+         Serial.println("ERROR: Queue full");
+         return;
+     }
+     
+     if (!validateMove(positions, active)) {
+         setError(ERROR_INVALID_POSITION);
+         return;
+     }
+     
+     // Первая точка открывает маршрут от текущих позиций
+     if (!stream.active) {
+         for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+             stream.last[i] = steppers[i].pos;
+         }
+         enableAllMotors();
+         stream.active = true;
+     }
+     
+     int32_t* point = stream.points[stream.head];
+     bool changed = false;
+     for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+         point[i] = active[i] ? toSteps(i, positions[i]) : stream.last[i];
+         if (point[i] != stream.last[i]) changed = true;
+     }
+     
+     // Повтор предыдущей точки не ставим: отрезок нулевой длины планировщик пропускает
+     if (changed) {
+         memcpy(stream.last, point, sizeof(stream.last));
+         stream.head = (stream.head + 1) % STREAM_QUEUE_SIZE;
+         stream.count++;
+     }
+     state.lastActivityTime = millis();
+     
+     Serial.print("OK ");
+     Serial.println(streamFreeSlots());
+ }
+ 
+ /**
+  * Завершение маршрута: COMPLETE будет выведен после отработки последней точки
+  */
+ void endTrajectoryStream() {
+     if (!stream.active) {
+         Serial.println("Queue empty");
+         Serial.println("COMPLETE");
+         return;
+     }
+     
+     stream.endRequested = true;
+     startTimeout(MOVE_TIMEOUT_MS);
+ }
+ 
+ /**
+  * Обслуживание маршрута из loop()
+  * Переносит точки в буфер планировщика, пока в нём есть место, и
+  * отслеживает завершение после queue_end. Пока точки подходят быстрее,
+  * чем отрабатываются, планировщик проходит вершины без остановки.
+  */
+ void serviceTrajectoryStream() {
+     if (!stream.active) return;
+     
+     while (stream.count > 0 && planner.available()) {
+         uint8_t tail = (stream.head + STREAM_QUEUE_SIZE - stream.count) % STREAM_QUEUE_SIZE;
+         planner.addTarget(stream.points[tail], 0);
+         stream.count--;
+     }
+     planner.start();
+     
+     if (!stream.endRequested) return;
+     
+     if (isTimeoutExpired()) {
+         plannerSync();
+         resetTrajectoryStream();
+         clearTimeout();
+         setError(ERROR_TIMEOUT);
+         Serial.println("ERROR: Queue timeout");
+         return;
+     }
+     
+     // Статус 1 после разбора буфера - точек больше нет, маршрут пройден
+     if (stream.count == 0) {
+         planner.checkBuffer();
+         if (planner.getStatus() <= 1) {
+             clearTimeout();
+             resetTrajectoryStream();
+             disableTemporaryMotors();
+             Serial.println("COMPLETE");
+         }
+     }
+ }
+ 
  // ============================================
  // ENHANCED HOMING FUNCTIONS
  // ============================================
@@ -872,21 +1233,28 @@
      Serial.print(phase);
      Serial.println(" backoff...");
      
-     planner.setTarget(positions);
+     if (!plannerGoTo(positions)) return;
      uint32_t backoffStart = millis();
      
      // Цикл выполнения backoff с таймаутом 5 секунд
      while (!planner.ready()) {
          planner.tick();
+         runScheduler();
          
          // Проверка таймаута и аварийной остановки
          if (state.emergencyStop || (millis() - backoffStart) > 5000) {
-             planner.brake();
+             plannerSync();
+             if (!state.emergencyStop) {
+                 setError(ERROR_TIMEOUT);
+                 Serial.print("ERROR: ");
+                 Serial.print(phase);
+                 Serial.println(" backoff timeout");
+             }
              return;
          }
      }
      
-     planner.brake();
+     plannerSync();
  }
  
  /**
@@ -904,6 +1272,7 @@
  void homeMotors(bool flags[]) {
      // Проверка аварийного состояния
      if (state.emergencyStop) {
+         setError(ERROR_EMERGENCY_STOP);
          Serial.println("ERROR: Emergency stop active");
          return;
      }
@@ -915,10 +1284,19 @@
      }
      
      if (!hasValidFlags) {
+         setError(ERROR_INVALID_COMMAND);
          Serial.println("ERROR: No valid homing flags");
          return;
      }
      
+     if (stream.active) {
+         setError(ERROR_BUSY);
+         Serial.println("ERROR: Trajectory queue active");
+         return;
+     }
+     
+     uint8_t errors = state.errorCount;
+     
      // Установка флагов состояния
      noInterrupts();
      state.homingActive = true;
@@ -984,16 +1362,21 @@
              }
          }
          
-         planner.setTarget(positions);
+         bool seeking = plannerGoTo(positions);
          bool homed[NUM_MOTORS] = {false};  // Флаги успешного homing
          
          // Цикл поиска концевиков
-         while (!planner.ready()) {
+         while (seeking && !planner.ready()) {
              planner.tick();
+             runScheduler();
              
              // Проверка таймаута и аварийной остановки
              if (state.emergencyStop || isTimeoutExpired()) {
-                 planner.brake();
+                 plannerSync();
+                 if (!state.emergencyStop) {
+                     setError(ERROR_TIMEOUT);
+                     Serial.println("ERROR: Homing timeout");
+                 }
                  break;
              }
              
@@ -1014,7 +1397,18 @@
              if (allDone) break;
          }
          
-         planner.brake();
+         plannerSync();
+         
+         // Ход maxSteps пройден, а концевик не сработал - как таймаут поиска
+         if (!state.emergencyStop && !isTimeoutExpired()) {
+             for (uint8_t i = 0; i < 4; i++) {
+                 if (flags[i] && !homed[i]) {
+                     setError(ERROR_TIMEOUT);
+                     Serial.print("ERROR: Endstop not reached - ");
+                     Serial.println(motors[i].name);
+                 }
+             }
+         }
          
          // ФАЗА 4: Финальный отход и обнуление
          if (!state.emergencyStop) {
@@ -1046,15 +1440,182 @@
      // Очистка состояния
      clearTimeout();
      planner.reset();
+     plannerSync();  // Буфер планировщика должен начинаться с новых нулевых позиций
      
      noInterrupts();
      state.homingActive = false;
      state.commandInProgress = false;
      interrupts();
      
+     // Ошибка любой фазы уже выведена, COMPLETE - только для успешного homing
+     if (state.errorCount != errors) return;
      Serial.println("COMPLETE");
  }
  
+ // ============================================
+ // TASK SCHEDULER
+ // ============================================
+ 
+ /**
+  * Запуск одной задачи, срок которой наступил
+  * Задачи просматриваются в порядке приоритета tasks[]. Срок сдвигается на период;
+  * если задача опоздала больше чем на период, пропущенные запуски не догоняются,
+  * а отсчёт начинается заново от текущего времени.
+  */
+ void runScheduler() {
+     uint32_t now = millis();
+     
+     for (uint8_t i = 0; i < NUM_TASKS; i++) {
+         ScheduledTask& task = tasks[i];
+         if (!task.enabled || (int32_t)(now - task.nextRunMs) < 0) continue;
+         
+         uint32_t lateMs = now - task.nextRunMs;
+         uint32_t startUs = micros();
+         task.run();
+         uint32_t runtimeUs = micros() - startUs;
+         
+         task.runs++;
+         if (runtimeUs > task.maxRuntimeUs) task.maxRuntimeUs = runtimeUs;
+         if (lateMs > task.maxLateMs) task.maxLateMs = lateMs;
+         
+         task.nextRunMs += task.periodMs;
+         bool missed = (int32_t)(millis() - task.nextRunMs) >= 0;
+         if (missed) {
+             task.nextRunMs = millis() + task.periodMs;
+         }
+         if ((missed || runtimeUs > (uint32_t)task.periodMs * 1000UL) && task.overruns < UINT16_MAX) {
+             task.overruns++;
+         }
+         return;
+     }
+ }
+ 
+ /**
+  * Сброс статистики задач (команда tasks reset)
+  */
+ void resetTaskStats() {
+     for (uint8_t i = 0; i < NUM_TASKS; i++) {
+         tasks[i].runs = 0;
+         tasks[i].maxRuntimeUs = 0;
+         tasks[i].maxLateMs = 0;
+         tasks[i].overruns = 0;
+     }
+ }
+ 
+ /**
+  * Вывод статистики задач (команда tasks)
+  * Строка на задачу: период, запуски, худшее время, опоздание и превышения
+  */
+ void printTaskStats() {
+     Serial.println("=== TASKS ===");
+     for (uint8_t i = 0; i < NUM_TASKS; i++) {
+         const ScheduledTask& task = tasks[i];
+         Serial.print(task.name);
+         Serial.print(": period=");
+         if (task.enabled) {
+             Serial.print(task.periodMs);
+             Serial.print("ms");
+         } else {
+             Serial.print("off");
+         }
+         Serial.print(", runs=");
+         Serial.print(task.runs);
+         Serial.print(", max=");
+         Serial.print(task.maxRuntimeUs);
+         Serial.print("us, late=");
+         Serial.print(task.maxLateMs);
+         Serial.print("ms, overruns=");
+         Serial.println(task.overruns);
+     }
+ }
+ 
+ /**
+  * Включение телеметрии с заданным периодом, 0 - выключение
+  */
+ void setTelemetryPeriod(uint16_t periodMs) {
+     ScheduledTask& task = tasks[NUM_TASKS - 1];
+     task.enabled = periodMs > 0;
+     if (task.enabled) {
+         task.periodMs = periodMs;
+         task.nextRunMs = millis();
+     }
+ }
+ 
+ /**
+  * Задача приёма команд
+  * Забирает из буфера UART все принятые символы. Пока предыдущая команда
+  * не обработана, чтение останавливается: остальное ждёт в буфере UART.
+  */
+ void taskSerialDrain() {
+     while (!state.commandReady && Serial.available()) {
+         char c = Serial.read();
+         
+         // Команда завершена (Enter или перевод строки)
+         if (c == '\n' || c == '\r') {
+             if (state.inputOverflow) {
+                 // Обрезанная строка не выполняется - хвост пакета мог потеряться.
+                 // Ошибка другой строки: счётчик не трогаем, чтобы не прервать текущий пакет
+                 state.lastError = ERROR_BUFFER_OVERFLOW;
+                 state.inputOverflow = false;
+                 state.inputBufferPos = 0;
+                 Serial.println("ERROR: Command too long");
+                 continue;
+             }
+             state.inputBuffer[state.inputBufferPos] = '\0';  // Завершающий нуль
+             state.commandReady = true;
+             state.inputBufferPos = 0;
+             continue;
+         }
+         
+         // Добавление символа в буфер
+         if (state.inputBufferPos < MAX_COMMAND_LENGTH - 1) {
+             state.inputBuffer[state.inputBufferPos++] = c;
+             state.lastActivityTime = millis();
+         } else {
+             state.inputOverflow = true;
+         }
+     }
+ }
+ 
+ /**
+  * Задача контроля резервуара
+  * Предупреждение выводится один раз при появлении переполнения
+  */
+ void taskReservoir() {
+     bool overflow = digitalRead(controlPins[WASTE].pin);
+     if (overflow && !reservoirOverflowSeen) {
+         checkReservoirOverflow();
+     }
+     reservoirOverflowSeen = overflow;
+ }
+ 
+ /**
+  * Задача считывания веса
+  * Берёт один отсчёт HX711, только если он уже готов - без ожидания преобразования
+  */
+ void taskWeightSample() {
+     if (!weightManager.isMeasuring || !weightManager.sensor->is_ready()) return;
+     
+     weightManager.lastWeight = weightManager.sensor->get_units(1);
+     weightManager.lastMeasurement = millis();
+ }
+ 
+ /**
+  * Задача телеметрии
+  * Формат: TELEMETRY <x> <y> <z> <e0> <e1> <вес> <маска входов>
+  */
+ void taskTelemetry() {
+     Serial.print("TELEMETRY");
+     for (uint8_t i = 0; i < NUM_MOTORS; i++) {
+         Serial.print(' ');
+         Serial.print(toUnits(i, steppers[i].pos), 2);
+     }
+     Serial.print(' ');
+     Serial.print(weightManager.isMeasuring ? weightManager.lastWeight : 0.0, 2);
+     Serial.print(' ');
+     Serial.println(readInputSnapshot().mask);
+ }
+ 
  // ============================================
  // SETUP & LOOP FUNCTIONS
  // ============================================
@@ -1089,6 +1650,7 @@
      for (uint8_t i = 0; i < NUM_INPUT_PINS; i++) {
          pinMode(inputPins[i].pin, INPUT_PULLUP);
      }
+     initInputSnapshot();
      
      // Инициализация датчика веса
      Serial.println("Initializing weight sensor...");
@@ -1104,6 +1666,7 @@
          weightManager.sensor->tare(10);
          weightManager.isCalibrated = true;
      } else {
+         setError(ERROR_WEIGHT_SENSOR);
          Serial.println("ERROR: Weight sensor not ready");
          weightManager.isCalibrated = false;
      }
@@ -1120,8 +1683,9 @@
      // Включение моторов
      enableAllMotors();
      
-     // Сброс позиций в 0
+     // Сброс позиций в 0 и начальная точка маршрута в буфере планировщика
      planner.reset();
+     plannerSync();
      
      Serial.println("System ready!");
      Serial.println("=== AVAILABLE COMMANDS ===");
@@ -1136,11 +1700,18 @@
      Serial.println("              move 0 0 -10 0 0   (Z=-10 only)");
      Serial.println("              move 50            (X=50 only)");
      Serial.println("");
+     Serial.println("  queue [x] [y] [z] [e0] [e1] - append point to streamed path");
+     Serial.println("    Reply: OK <free slots>, ERROR: Queue full when no space");
+     Serial.println("    queue (no args) - report free slots only");
+     Serial.println("  queue_end - finish path after last point (prints COMPLETE)");
+     Serial.println("");
      Serial.println("SYSTEM COMMANDS:");
      Serial.println("  status - show system status and motor positions");
      Serial.println("  reset - emergency stop reset");
      Serial.println("  help - show this help message");
      Serial.println("  version - show system version");
+     Serial.println("  tasks [reset] - loop task periods, worst runtime, overruns");
+     Serial.println("  telemetry [ms] - periodic TELEMETRY line, 0 - off");
      Serial.println("");
      Serial.println("CONTROL PIN COMMANDS:");
      Serial.println("  pin [index] [state] - control output pins");
@@ -1172,50 +1743,76 @@
   * Обработка команд, проверка безопасности, обновление планировщика
   */
  void loop() {
-     // Обработка входящих команд
-     if (Serial.available()) {
-         char c = Serial.read();
-         
-         // Добавление символа в буфер
-         if (state.inputBufferPos < MAX_COMMAND_LENGTH - 1) {
-             state.inputBuffer[state.inputBufferPos++] = c;
-             state.lastActivityTime = millis();
-         }
-         
-         // Команда завершена (Enter или перевод строки)
-         if (c == '\n' || c == '\r') {
-             state.inputBuffer[state.inputBufferPos] = '\0';  // Завершающий нуль
-             state.commandReady = true;
-             state.inputBufferPos = 0;
-         }
-     }
-     
      // Обработка готовой команды
      if (state.commandReady && !state.commandInProgress) {
-         processCommand(state.inputBuffer);
+         processCommandLine(state.inputBuffer);
          clearCommandBuffer();
      }
      
      // Обновление планировщика движения
      if (!state.emergencyStop) {
+         serviceTrajectoryStream();
          planner.tick();
      }
      
-     // Периодическая проверка безопасности
-     static uint32_t lastCheck = 0;
-     if (millis() - lastCheck >= EMERGENCY_CHECK_INTERVAL) {
-         checkEmergency();
-         lastCheck = millis();
-     }
-     
-     // Небольшая задержка для стабильности
-     delay(1);
+     // Приём команд, проверки безопасности и датчики - по одной задаче за проход
+     runScheduler();
  }
  
  // ============================================
  // COMMAND PROCESSING
  // ============================================
  
+ /**
+  * Обработка строки команд
+  * Строка "pin 1 1; move 100; pin 1 0" выполняется по шагам в одном обмене.
+  * Пакет прерывается на первом шаге, вызвавшем setError() (в том числе аварийной остановкой).
+  * Итог: BATCH <выполнено>/<всего> или ERROR: <код> <номер шага> BATCH <выполнено>/<всего> (шаги с 1)
+  * 
+  * @param line - принятая строка (изменяется при разборе)
+  */
+ void processCommandLine(char* line) {
+     if (!strchr(line, COMMAND_SEPARATOR)) {
+         processCommand(line);
+         return;
+     }
+     
+     const char separator[2] = {COMMAND_SEPARATOR, '\0'};
+     uint8_t total = 0;
+     uint8_t done = 0;
+     uint8_t failedStep = 0;
+     ErrorCode failedCode = ERROR_NONE;
+     char* save = NULL;
+     
+     for (char* step = strtok_r(line, separator, &save); step; step = strtok_r(NULL, separator, &save)) {
+         while (*step == ' ') step++;
+         if (*step == '\0') continue;
+         total++;
+         if (failedStep) continue;  // Остаток пакета после ошибки не выполняется
+         
+         uint8_t errors = state.errorCount;
+         processCommand(step);
+         if (state.errorCount != errors) {
+             failedStep = total;
+             failedCode = state.lastError;
+             continue;
+         }
+         done++;
+     }
+     
+     if (failedStep) {
+         Serial.print("ERROR: ");
+         Serial.print(failedCode);
+         Serial.print(" ");
+         Serial.print(failedStep);
+         Serial.print(" ");
+     }
+     Serial.print("BATCH ");
+     Serial.print(done);
+     Serial.print("/");
+     Serial.println(total);
+ }
+ 
  /**
   * Обработка входящих команд
   * 
@@ -1251,6 +1848,17 @@
          parseHomingFlags(cleanCommand + 4, flags);
          homeMotors(flags);
      }
+     else if (strcmp(cleanCommand, "queue_end") == 0) {
+         // Завершение потокового маршрута
+         endTrajectoryStream();
+     }
+     else if (strncmp(cleanCommand, "queue", 5) == 0) {
+         // Точка потокового маршрута (без аргументов - запрос свободного места)
+         float positions[NUM_MOTORS];
+         bool active[NUM_MOTORS] = {false};
+         parseMoveCommand(cleanCommand + 5, positions, active);
+         queuePoint(positions, active);
+     }
      else if (strncmp(cleanCommand, "move", 4) == 0) {
          // Команда движения
          float positions[NUM_MOTORS];
@@ -1258,6 +1866,27 @@
          parseMoveCommand(cleanCommand + 4, positions, active);
          coordinatedMove(positions, active);
      }
+     else if (strcmp(cleanCommand, "tasks reset") == 0) {
+         // Сброс статистики задач
+         resetTaskStats();
+         Serial.println("Task stats reset");
+     }
+     else if (strcmp(cleanCommand, "tasks") == 0) {
+         // Статистика задач основного цикла
+         printTaskStats();
+     }
+     else if (strncmp(cleanCommand, "telemetry", 9) == 0) {
+         // Периодическая телеметрия: telemetry [мс], telemetry 0 - выключить
+         long periodMs = TELEMETRY_DEFAULT_PERIOD_MS;
+         sscanf(cleanCommand + 9, "%ld", &periodMs);
+         if (periodMs < 0 || periodMs > 60000) {
+             setError(ERROR_INVALID_COMMAND);
+             Serial.println("ERROR: Invalid telemetry period");
+         } else {
+             setTelemetryPeriod((uint16_t)periodMs);
+             Serial.println(periodMs > 0 ? "Telemetry on" : "Telemetry off");
+         }
+     }
      else if (strcmp(cleanCommand, "status") == 0) {
          // Статус системы
          printSystemStatus();
@@ -1278,9 +1907,11 @@
              if (validatePinIndex(pinIndex)) {
                  controlPin(pinIndex, tempState != 0);
              } else {
+                 setError(ERROR_INVALID_PIN);
                  Serial.println("ERROR: Invalid pin index");
              }
          } else {
+             setError(ERROR_INVALID_COMMAND);
              Serial.println("ERROR: Invalid pin command format");
          }
      }
@@ -1324,6 +1955,7 @@
              Serial.print(weight, 2);
              Serial.println(" grams");
          } else {
+             setError(ERROR_WEIGHT_SENSOR);
              Serial.println("ERROR: Weight measurement not active");
          }
      }
@@ -1353,20 +1985,25 @@
                          Serial.println(weightManager.calibrationFactor, 6);
                          Serial.println("Calibration completed successfully");
                      } else {
+                         setError(ERROR_WEIGHT_SENSOR);
                          Serial.println("ERROR: Invalid sensor reading");
                      }
                  } else {
+                     setError(ERROR_WEIGHT_SENSOR);
                      Serial.println("ERROR: Weight sensor not ready");
                  }
              } else {
+                 setError(ERROR_INVALID_COMMAND);
                  Serial.println("ERROR: Known weight must be positive");
              }
          } else {
+             setError(ERROR_INVALID_COMMAND);
              Serial.println("ERROR: Invalid calibration command format");
              Serial.println("Use: calibrate_weight [weight_in_grams]");
          }
      }
      else {
+         setError(ERROR_INVALID_COMMAND);
          Serial.print("Unknown command: ");
          Serial.println(cleanCommand);
      }
@@ -1440,6 +2077,10 @@
      Serial.println(state.homingActive ? "Yes" : "No");
      Serial.print("Command In Progress: ");
      Serial.println(state.commandInProgress ? "Yes" : "No");
+     Serial.print("Trajectory Queue: ");
+     Serial.print(stream.active ? "Active" : "Idle");
+     Serial.print(", free ");
+     Serial.println(streamFreeSlots());
      
      Serial.println("Motor Positions:");
      for (uint8_t i = 0; i < NUM_MOTORS; i++) {
@@ -1474,11 +2115,18 @@
      Serial.println("              move 50            (X=50 only)");
      Serial.println("    Units: mm, degrees, etc.");
      Serial.println("");
+     Serial.println("  queue [x] [y] [z] [e0] [e1] - append point to streamed path");
+     Serial.println("    Reply: OK <free slots>, ERROR: Queue full when no space");
+     Serial.println("    queue (no args) - report free slots only");
+     Serial.println("  queue_end - finish path after last point (prints COMPLETE)");
+     Serial.println("");
      Serial.println("SYSTEM COMMANDS:");
      Serial.println("  status - show system status and motor positions");
      Serial.println("  reset - emergency stop reset");
      Serial.println("  help - show this help message");
      Serial.println("  version - show system version");
+     Serial.println("  tasks [reset] - loop task periods, worst runtime, overruns");
+     Serial.println("  telemetry [ms] - periodic TELEMETRY line, 0 - off");
      Serial.println("");
      Serial.println("CONTROL PIN COMMANDS:");
      Serial.println("  pin [index] [state] - control output pins");